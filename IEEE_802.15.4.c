@@ -3,8 +3,8 @@
  */
 /*******************| Inclusions |*************************************/
 #include "IEEE_802.15.4.h"
-#include <ioCC2530.h>
-#include <cc253x.h>
+#include "IEEE_802.15.4_Radio.h"
+#include <stddef.h>
 
 /**
  * Implementation only covers MAC layer since PHYS layer is completely handled by
@@ -12,10 +12,153 @@
 */
 
 /*******************| Macros |*****************************************/
+/* states of CSMA-CA engine */
+#define IEEE802154_CSMA_STATE_IDLE              0x00
+#define IEEE802154_CSMA_STATE_BACKOFF           0x01    /**< waiting for random backoff to expire before CCA */
+#define IEEE802154_CSMA_STATE_TX                0x02    /**< CCA was clear, waiting for TXDONE */
+#define IEEE802154_CSMA_STATE_WAIT_ACK          0x03    /**< frame sent, waiting for acknowledge */
+
+#define IEEE802154_RANDOM_POLYNOMIAL            0xB400  /**< x^16 + x^14 + x^13 + x^11 + 1 */
+
+/* payload of a received frame is still copied by DMA, RXFIFO must not be read */
+#ifdef IEEE802154_ENABLE_DMA
+#define IEEE802154_RX_PENDING()                 IEEE802154_dmaRxPending
+#else
+#define IEEE802154_RX_PENDING()                 0
+#endif
+
+/* MAC header length of a frame without auxiliary security header, 0 for reserved address modes */
+#define IEEE802154_HEADER_LENGTH(header)        IEEE802154_frameLayout[IEEE802154_FRAME_LAYOUT_INDEX(((const uint8_t*)&(header)->fcf)[0], \
+                                                                                             ((const uint8_t*)&(header)->fcf)[1])].headerLength
+
+#ifdef IEEE802154_ENABLE_CSMA
+/* frame handed to IEEE802154_txStart() is still in CSMA-CA or, with DMA, still being copied */
+#ifdef IEEE802154_ENABLE_DMA
+#define IEEE802154_TX_BUSY()                    (IEEE802154_dmaTxPending || (IEEE802154_csmaState != IEEE802154_CSMA_STATE_IDLE))
+#else
+#define IEEE802154_TX_BUSY()                    (IEEE802154_csmaState != IEEE802154_CSMA_STATE_IDLE)
+#endif
+#endif
+
+/* counters of IEEE802154_ENABLE_STATISTICS, no code without it */
+#ifdef IEEE802154_ENABLE_STATISTICS
+#define IEEE802154_STAT_INC(counter)            IEEE802154_statistics.counter++
+#define IEEE802154_STAT_ADD(counter, value)     IEEE802154_statistics.counter += (value)
+#define IEEE802154_STAT_CYCLES(stat, start)     IEEE802154_statisticsCycles(&IEEE802154_statistics.stat, IEEE802154_RADIO_CYCLES() - (start))
+#else
+#define IEEE802154_STAT_INC(counter)
+#define IEEE802154_STAT_ADD(counter, value)
+#define IEEE802154_STAT_CYCLES(stat, start)
+#endif
 
 /*******************| Type definitions |*******************************/
 
 /*******************| Global variables |*******************************/
+#ifdef IEEE802154_ENABLE_CSMA
+IEEE802154_Context_t IEEE802154_Context =
+{
+  .csmaConfig =
+  {
+    IEEE802154_MAC_MIN_BE,
+    IEEE802154_MAC_MAX_BE,
+    IEEE802154_MAC_MAX_CSMA_BACKOFFS,
+    IEEE802154_MAC_MAX_FRAME_RETRIES,
+    IEEE802154_MAC_ACK_WAIT_PERIODS
+  }
+};
+#else
+IEEE802154_Context_t IEEE802154_Context;
+#endif
+#ifdef IEEE802154_ENABLE_NETSIM
+__thread IEEE802154_Context_t *IEEE802154_Instance = &IEEE802154_Context;
+#endif
+#define IEEE802154_channel                      (IEEE802154_Instance->channel)
+#ifdef IEEE802154_ENABLE_STATISTICS
+#define IEEE802154_statistics                   (IEEE802154_Instance->statistics)
+#endif
+#ifdef IEEE802154_ENABLE_TX_QUEUE
+#define IEEE802154_txQueue                      (IEEE802154_Instance->txQueue)
+#define IEEE802154_txQueueHead                  (IEEE802154_Instance->txQueueHead)
+#define IEEE802154_txQueueTail                  (IEEE802154_Instance->txQueueTail)
+#endif
+#ifdef IEEE802154_ENABLE_INDIRECT_QUEUE
+#define IEEE802154_txHeader                     (IEEE802154_Instance->txHeader)
+#endif
+#ifdef IEEE802154_ENABLE_CSMA
+#define IEEE802154_csmaState                    (IEEE802154_Instance->csmaState)
+#define IEEE802154_csmaNB                       (IEEE802154_Instance->csmaNB)
+#define IEEE802154_csmaBE                       (IEEE802154_Instance->csmaBE)
+#define IEEE802154_csmaRetries                  (IEEE802154_Instance->csmaRetries)
+#define IEEE802154_csmaTimer                    (IEEE802154_Instance->csmaTimer)
+#define IEEE802154_csmaAckRequired              (IEEE802154_Instance->csmaAckRequired)
+#define IEEE802154_csmaSequenceNumber           (IEEE802154_Instance->csmaSequenceNumber)
+#define IEEE802154_random                       (IEEE802154_Instance->random)
+#endif
+#ifdef IEEE802154_ENABLE_DMA
+#ifndef IEEE802154_SIMULATION
+__xdata IEEE802154_DmaDescriptor_t IEEE802154_DmaDescriptor[4];
+#endif
+#define IEEE802154_dmaTxPending                 (IEEE802154_Instance->dmaTxPending)
+#define IEEE802154_dmaTxAckRequired             (IEEE802154_Instance->dmaTxAckRequired)
+#define IEEE802154_dmaTxSequenceNumber          (IEEE802154_Instance->dmaTxSequenceNumber)
+#define IEEE802154_dmaRxPending                 (IEEE802154_Instance->dmaRxPending)
+#endif
+/* frame being read from RXFIFO, handed from IEEE802154_receiveFrame() to IEEE802154_receiveFrameEnd() */
+#define IEEE802154_rxFrame                      (IEEE802154_Instance->rxFrame)
+#define IEEE802154_rxFrameLength                (IEEE802154_Instance->rxFrameLength)
+#define IEEE802154_rxPayloadLength              (IEEE802154_Instance->rxPayloadLength)
+#ifdef IEEE802154_ENABLE_DUPLICATE_FILTER
+#define IEEE802154_duplicateCache               (IEEE802154_Instance->duplicateCache)
+#define IEEE802154_rxDuplicateEntry             (IEEE802154_Instance->rxDuplicateEntry)
+#define IEEE802154_rxTimestamp                  (IEEE802154_Instance->rxTimestamp)
+#endif
+#ifdef IEEE802154_ENABLE_SOFTWARE_CRC
+#define IEEE802154_rxFcs                        (IEEE802154_Instance->rxFcs)
+#define IEEE802154_txFcs                        (IEEE802154_Instance->txFcs)
+#endif
+#ifdef IEEE802154_ENABLE_RX_QUEUE
+#define IEEE802154_rxQueue                      (IEEE802154_Instance->rxQueue)
+#define IEEE802154_rxQueueHead                  (IEEE802154_Instance->rxQueueHead)
+#define IEEE802154_rxQueueTail                  (IEEE802154_Instance->rxQueueTail)
+#endif
+#ifdef IEEE802154_ENABLE_SECURITY
+#define IEEE802154_securedFrame                 (IEEE802154_Instance->securedFrame)
+#endif
+#if defined(IEEE802154_ENABLE_SCATTER_GATHER) && !defined(IEEE802154_ENABLE_RX_QUEUE)
+#define IEEE802154_rxSegments                   (IEEE802154_Instance->rxSegments)
+#define IEEE802154_rxSegmentsCapacity           (IEEE802154_Instance->rxSegmentsCapacity)
+#endif
+
+/*******************| Function prototypes |****************************/
+static uint8_t IEEE802154_frameLengthCheck(uint8_t headerLength, uint16_t payloadLength);
+static uint8_t IEEE802154_writeDataFrame(IEEE802154_DataFrameHeader_t* header, uint8_t payloadLength);
+static void IEEE802154_writeDataFrameHeader(const IEEE802154_DataFrameHeader_t* header, uint8_t payloadLength);
+static uint8_t IEEE802154_writeFlowFrame(const IEEE802154_Flow_t *flow, uint8_t sequenceNumber, IEEE802154_PayloadPointer payload, uint8_t payloadLength);
+static void IEEE802154_writePayload(const IEEE802154_Payload *payload, uint8_t payloadLength, uint8_t ackRequired, uint8_t sequenceNumber);
+static void IEEE802154_txStart(uint8_t ackRequired, uint8_t sequenceNumber);
+static void IEEE802154_readPayload(IEEE802154_PayloadPointer payload, uint8_t payloadLength);
+static void IEEE802154_receiveFrameEnd(void);
+#ifdef IEEE802154_ENABLE_RX_DRAIN
+static void IEEE802154_rxFifoDrain(void);
+#else
+static void IEEE802154_rxFifoFlush(void);
+#endif
+#ifdef IEEE802154_ENABLE_SCATTER_GATHER
+static uint8_t IEEE802154_writeDataFrameSegments(IEEE802154_DataFrameHeader_t* header, const IEEE802154_Segment_t *segments, uint8_t segmentCount);
+#endif
+#ifdef IEEE802154_ENABLE_STATISTICS
+static void IEEE802154_statisticsCycles(IEEE802154_CycleStatistics_t *stat, uint32_t cycles);
+#endif
+#ifdef IEEE802154_ENABLE_CSMA
+static void IEEE802154_csmaBackoff(void);
+#endif
+#if defined(IEEE802154_ENABLE_TX_QUEUE) || defined(IEEE802154_ENABLE_CSMA)
+static void IEEE802154_txComplete(uint8_t status);
+#endif
+#ifdef IEEE802154_ENABLE_TX_QUEUE
+static void IEEE802154_writeQueueEntry(const IEEE802154_TxQueueEntry_t *entry);
+static void IEEE802154_txQueuePublish(IEEE802154_TxQueueEntry_t *entry);
+#endif
 
 /*******************| Function definition |****************************/
 
@@ -26,8 +169,13 @@
 */
 void IEEE802154_radioInit(IEEE802154_Config_t *config)
 {    
+#ifdef IEEE802154_ENABLE_SOFTWARE_CRC
+  /* FCS is handled by MAC, auto ACK relies on auto CRC and is not available */
+  FRMCTRL0 &= (uint8_t)~(FRMCTRL0_AUTOACK_ENABLED | FRMCTRL0_AUTOCRC_ENABLED);
+#else
   /* Configure frama handline (FRMCTRL0) use auto ACK and auto CRC for convenience */
   FRMCTRL0 |= (FRMCTRL0_AUTOACK_ENABLED | FRMCTRL0_AUTOCRC_ENABLED);
+#endif
     
   /* according to (swru191c.pdf) 23.15.1 Register Settings Update
      This section contains a summary of the register settings that must be 
@@ -41,12 +189,13 @@ void IEEE802154_radioInit(IEEE802154_Config_t *config)
      with 16 channels 5 MHz apart. The channels are numbered 11 through 26. For an
      IEEE 802.15.4-2006 compliant system, the only valid settings are thus
      FREQ[6:0] = 11 + 5 (channel number  11).*/   
-  FREQCTRL =  FREQCTRL_CHANNEL_OFFSET + FREQCTRL_CHANNEL_FAKTOR * (config->Channel - FREQCTRL_CHANNEL_OFFSET);
+  FREQCTRL = FREQCTRL_CHANNEL(config->Channel);
+  IEEE802154_channel = config->Channel;
     
   /* set short address to configured value and extended address to factory preset. Which value will be used
    * during data reception is defined by frame header */
-  SHORT_ADDR0 = HI_UINT16(config->shortAddress);
-  SHORT_ADDR1 = LO_UINT16(config->shortAddress);
+  SHORT_ADDR0 = LO_UINT16(config->shortAddress);
+  SHORT_ADDR1 = HI_UINT16(config->shortAddress);
   EXT_ADDR0 = IEEE_EXTENDED_ADDRESS0;
   EXT_ADDR1 = IEEE_EXTENDED_ADDRESS1;
   EXT_ADDR2 = IEEE_EXTENDED_ADDRESS2;
@@ -57,227 +206,1935 @@ void IEEE802154_radioInit(IEEE802154_Config_t *config)
   EXT_ADDR7 = IEEE_EXTENDED_ADDRESS7;
     
   /* set PANID */
-  PAN_ID0 = HI_UINT16(config->PanID);
-  PAN_ID1 = LO_UINT16(config->PanID);
+  PAN_ID0 = LO_UINT16(config->PanID);
+  PAN_ID1 = HI_UINT16(config->PanID);
   
   /* enable general RF interrupt */
   enableInterrupt(IEN2, IEN2_RFIE);
   /* enable rx done interrupt */
   enableInterrupt(RFIRQM0, RFIRQF0_RXPKTDONE);
+#ifdef IEEE802154_ENABLE_TX_QUEUE
+  IEEE802154_txQueueHead = 0;
+  IEEE802154_txQueueTail = 0;
+#endif
+#if defined(IEEE802154_ENABLE_TX_QUEUE) || defined(IEEE802154_ENABLE_CSMA)
+  /* enable tx done interrupt to start next queued frame or ACK wait */
+  enableInterrupt(RFIRQM1, RFIRQF1_TXDONE);
+#endif
+#ifdef IEEE802154_ENABLE_CSMA
+  IEEE802154_csmaState = IEEE802154_CSMA_STATE_IDLE;
+  /* seed backoff randomization with device addresses so that nodes differ */
+  IEEE802154_random = config->shortAddress ^ ((uint16_t)IEEE_EXTENDED_ADDRESS0 << 8) ^ IEEE_EXTENDED_ADDRESS1;
+  if (IEEE802154_random == 0)
+  {
+    IEEE802154_random = 1;
+  }
+#endif
+#if defined(IEEE802154_ENABLE_CSMA) || defined(IEEE802154_ENABLE_ED_SCAN) || defined(IEEE802154_ENABLE_STATISTICS) || \
+    defined(IEEE802154_ENABLE_SNIFFER)
+  /* MAC timer overflows once per backoff period (swru191c.pdf Chapter 22 Timer 2 (MAC Timer)) */
+  T2CTRL &= (uint8_t)~T2CTRL_RUN;
+  T2MSEL = T2MSEL_T2MSEL_PERIOD;
+  T2M0 = LO_UINT16(IEEE802154_MAC_TIMER_BACKOFF_PERIOD);
+  T2M1 = HI_UINT16(IEEE802154_MAC_TIMER_BACKOFF_PERIOD);
+  T2MSEL = 0x00;
+#ifdef IEEE802154_ENABLE_CSMA
+  /* overflow drives CSMA-CA engine */
+  clearInterruptFlag(T2IRQF, T2IRQF_TIMER2_PERF);
+  enableInterrupt(T2IRQM, T2IRQF_TIMER2_PERF);
+  enableInterrupt(IEN1, IEN1_T2IE);
+#endif
+  T2CTRL |= T2CTRL_RUN;
+#endif
+#ifdef IEEE802154_ENABLE_SOURCE_MATCH
+  IEEE802154_srcMatchInit();
+#endif
+#ifdef IEEE802154_ENABLE_DUPLICATE_FILTER
+  {
+    uint8_t i;
+    for (i=0; i<IEEE802154_DUPLICATE_CACHE_SIZE; i++)
+    {
+      IEEE802154_duplicateCache[i].addressMode = IEEE802154_FCF_ADDRESS_MODE_NONE;
+    }
+  }
+#endif
+#ifdef IEEE802154_ENABLE_ADDRESS_INTERNING
+  IEEE802154_addressInit();
+#endif
+#ifdef IEEE802154_ENABLE_NEIGHBOR_TABLE
+  IEEE802154_neighborInit();
+#endif
+#ifdef IEEE802154_ENABLE_SECURITY
+  IEEE802154_securityInit();
+#endif
+#ifdef IEEE802154_ENABLE_STATISTICS
+  IEEE802154_statisticsReset();
+#endif
+#ifdef IEEE802154_ENABLE_DMA
+  IEEE802154_dmaTxPending = 0;
+  IEEE802154_dmaRxPending = 0;
+#ifndef IEEE802154_SIMULATION
+  DMA1CFGH = HI_UINT16(IEEE802154_XDATA_ADDRESS(IEEE802154_DmaDescriptor));
+  DMA1CFGL = LO_UINT16(IEEE802154_XDATA_ADDRESS(IEEE802154_DmaDescriptor));
+#endif
+  /* completion of TX payload transfer starts transmission, of RX payload transfer finishes the frame */
+  clearInterruptFlag(DMAIRQ, IEEE802154_DMA_TX_MASK | IEEE802154_DMA_RX_MASK);
+  enableInterrupt(IEN1, IEN1_DMAIE);
+#endif
    
   IEEE802154_ISRFOFF(); /* disables RX/TX and the frequency synthesizer */
   IEEE802154_ISFLUSHRX();
+#ifdef IEEE802154_ENABLE_RX_QUEUE
+  {
+    uint8_t i;
+    for (i=0; i<IEEE802154_RX_QUEUE_SIZE; i++)
+    {
+      IEEE802154_rxQueue[i].header.payload = IEEE802154_rxQueue[i].payload;
+    }
+    IEEE802154_rxQueueHead = 0;
+    IEEE802154_rxQueueTail = 0;
+  }
+#endif
   IEEE802154_ISRXON(); /* enables and calibrates the frequency synthesizer for RX */
 }
 
+#ifndef IEEE802154_SIMULATION
 /**
- * ISR for IEEE 802.15.4 radio. ISR must check bits of RFIRQF0 to further check
- * which situation happend. As of now only RXPKTDONE is used for data reception.
- * In case a complete frame hase been received (RXPKTDONE) the ISR will first fill fcf 
- * data and copy data to receive buffer. If crc is ok callback function depending 
- * frame type is called.
- * Access global variable declared by IEEE 802.15.4 module but definited by application.
+ * Reads the 24 bit overflow counter of the MAC timer (Timer 2) which is used as time
+ * base for received frames. The MAC timer itself is configured and started by the
+ * application, see swru191c.pdf Chapter 22 Timer 2 (MAC Timer).
+ */
+IEEE802154_Timestamp_t IEEE802154_radioReadMacTimer(void)
+{
+  IEEE802154_Timestamp_t timestamp;
+  T2MSEL = 0x00;    /* T2MOVFSEL = 000: reading T2MOVF0 latches T2MOVF1 and T2MOVF2 */
+  timestamp = T2MOVF0;
+  timestamp |= (IEEE802154_Timestamp_t)T2MOVF1 << 8;
+  timestamp |= (IEEE802154_Timestamp_t)T2MOVF2 << 16;
+  return timestamp;
+}
+
+#if defined(IEEE802154_ENABLE_STATISTICS) || defined(IEEE802154_ENABLE_SNIFFER)
+/**
+ * Reads overflow counter and timer count of the MAC timer consistently.
+ * @param count timer count within the current backoff period, cycles of 32MHz
+ * @return overflow counter, see IEEE802154_radioReadMacTimer()
+ */
+IEEE802154_Timestamp_t IEEE802154_radioReadMacTimerFine(uint16_t *count)
+{
+  IEEE802154_Timestamp_t overflows;
+  do
+  {
+    overflows = IEEE802154_radioReadMacTimer();
+    /* T2MSEL = 000 (set above): reading T2M0 latches T2M1 */
+    *count = T2M0;
+    *count |= (uint16_t)T2M1 << 8;
+  } while (overflows != IEEE802154_radioReadMacTimer());
+  return overflows;
+}
+#endif
+
+#ifdef IEEE802154_ENABLE_STATISTICS
+/**
+ * Reads the MAC timer in cycles of 32MHz, i.e. overflow counter and timer count. Wraps
+ * after 2^32 cycles, differences of two readings are valid across the wrap.
+ */
+uint32_t IEEE802154_radioReadCycles(void)
+{
+  uint16_t count;
+  IEEE802154_Timestamp_t overflows = IEEE802154_radioReadMacTimerFine(&count);
+  return overflows * IEEE802154_MAC_TIMER_BACKOFF_PERIOD + count;
+}
+#endif
+
+#ifdef IEEE802154_ENABLE_DMA
+/**
+ * Starts a manually triggered block transfer on one of the DMA channels 1-4.
+ * @param channel DMA channel 1-4
+ * @param source XDATA address of first source byte
+ * @param destination XDATA address of first destination byte
+ * @param length number of bytes, 1-255
+ * @param config SRCINC, DESTINC, IRQMASK, M8 and PRIORITY of descriptor
 */
-#pragma vector = RF_VECTOR
-__near_func __interrupt void IEEE802154_radioISR(void)
+void IEEE802154_radioDmaStart(uint8_t channel, uint16_t source, uint16_t destination, uint8_t length, uint8_t config)
 {
   uint8_t i;
-  uint8_t overallBufferLength;
-  uint8_t payloadLength;
-  uint8_t *rxFramePtr = (uint8_t*)&IEEE802154_RxDataFrame;   /* Pointer used to copy rx data. This is bad, but efficient */
-  if( RFIRQF0 & RFIRQF0_RXPKTDONE ) /* A complete frame has been received. */
+  __xdata IEEE802154_DmaDescriptor_t *descriptor = &IEEE802154_DmaDescriptor[channel - 1];
+  descriptor->sourceAddressHigh = HI_UINT16(source);
+  descriptor->sourceAddressLow = LO_UINT16(source);
+  descriptor->destinationAddressHigh = HI_UINT16(destination);
+  descriptor->destinationAddressLow = LO_UINT16(destination);
+  descriptor->lengthHigh = DMA_VLEN_USE_LEN;
+  descriptor->lengthLow = length;
+  descriptor->trigger = DMA_WORDSIZE_BYTE | DMA_TMODE_BLOCK | DMA_TRIG_NONE;
+  descriptor->config = config;
+  clearInterruptFlag(DMAIRQ, (uint8_t)(1 << channel));
+  DMAARM = (uint8_t)(1 << channel);
+  /* descriptor is loaded within 9 system clocks after arming (swru191c.pdf Chapter 8.2.3) */
+  for (i=0; i<9; i++)
   {
-    /* get overall buffer length since it could be more than one frame in FIFO */
-    overallBufferLength = RXFIFOCNT;
-    /* handle receive interrupt, first read payload length from rx-buffer. */
-    payloadLength = RFD; 
-    
-    /* Read 2 bytes frame control field, 1 byte sequence number, and 2 bytes destination pan ID */
-    for( i=0; i< IEEE802154_HEADERSIZE_STATIC ;i++ )
-    {
-      *rxFramePtr++ = RFD;
-    }
-    payloadLength -= IEEE802154_HEADERSIZE_STATIC;
-    if (IEEE802154_RxDataFrame.fcf.destinationAddressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
-    {
-      *rxFramePtr++ = RFD;
-      *rxFramePtr++ = RFD;
-      payloadLength -= sizeof(IEEE802154_ShortAddress_t);
-      rxFramePtr += sizeof(IEEE802154_ExtendedAddress_t);
-    }
-    if (IEEE802154_RxDataFrame.fcf.destinationAddressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT)
+    asm("NOP");
+  }
+  DMAREQ = (uint8_t)(1 << channel);
+}
+#endif
+#endif
+
+#ifdef IEEE802154_ENABLE_SOFTWARE_CRC
+/**
+ * Reads one byte from RXFIFO and adds it to the receive FCS.
+*/
+uint8_t IEEE802154_radioReadRxFifoFcs(void)
+{
+  uint8_t value = IEEE802154_RADIO_READ_RFD();
+  IEEE802154_rxFcs = IEEE802154_CRC16_UPDATE(IEEE802154_rxFcs, value);
+  return value;
+}
+
+/**
+ * Writes one byte to TXFIFO and adds it to the transmit FCS.
+*/
+void IEEE802154_radioWriteTxFifoFcs(uint8_t value)
+{
+  IEEE802154_txFcs = IEEE802154_CRC16_UPDATE(IEEE802154_txFcs, value);
+  IEEE802154_RADIO_WRITE_RFD(value);
+}
+#endif
+
+#ifdef IEEE802154_ENABLE_DUPLICATE_FILTER
+/**
+ * Looks up the cache entry of the source of a frame.
+ * @return entry of source or entry to be replaced if source is not cached: unused,
+ * expired or the oldest one
+*/
+static IEEE802154_DuplicateEntry_t* IEEE802154_duplicateFind(const IEEE802154_DataFrameHeader_t *frame, IEEE802154_Timestamp_t now)
+{
+  uint8_t i;
+  uint8_t j;
+  IEEE802154_DuplicateEntry_t *entry = IEEE802154_duplicateCache;
+  IEEE802154_DuplicateEntry_t *victim = IEEE802154_duplicateCache;
+  for (i=0; i<IEEE802154_DUPLICATE_CACHE_SIZE; i++, entry++)
+  {
+    if (entry->addressMode == frame->fcf.sourceAddressMode)
     {
-      for( i=0; i< sizeof(IEEE802154_ExtendedAddress_t) ;i++ )
+      if (entry->addressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
       {
-        *rxFramePtr++ = RFD;
+        if (entry->sourceAddress.shortAddress == frame->sourceAddress.shortAddress)
+        {
+          return entry;
+        }
       }
-      payloadLength -= sizeof(IEEE802154_ExtendedAddress_t);
-      rxFramePtr += sizeof(IEEE802154_ShortAddress_t);
-    }
-#ifndef IEEE802154_ENABLE_PANID_COMPRESSION
-    *rxFramePtr++ = RFD;
-    *rxFramePtr++ = RFD;
-    payloadLength -= sizeof(IEEE802154_PANIdentifier_t);
-#endif
-    if (IEEE802154_RxDataFrame.fcf.sourceAddressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
-    {
-      *rxFramePtr++ = RFD;
-      *rxFramePtr++ = RFD;
-      payloadLength -= sizeof(IEEE802154_ShortAddress_t);
-      rxFramePtr += sizeof(IEEE802154_ExtendedAddress_t);
-    }
-    if (IEEE802154_RxDataFrame.fcf.sourceAddressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT)
-    {
-      for( i=0; i< sizeof(IEEE802154_ExtendedAddress_t) ;i++ )
+      else
       {
-        *rxFramePtr++ = RFD;
+        for (j=0; j<sizeof(IEEE802154_ExtendedAddress_t); j++)
+        {
+          if (entry->sourceAddress.extendedAdress[j] != frame->sourceAddress.extendedAdress[j])
+          {
+            break;
+          }
+        }
+        if (j == sizeof(IEEE802154_ExtendedAddress_t))
+        {
+          return entry;
+        }
       }
-      payloadLength -= sizeof(IEEE802154_ExtendedAddress_t);
-      rxFramePtr += sizeof(IEEE802154_ShortAddress_t);
     }
-    /* Copy remaining payload, ignore two more bytes with RSSI and Correlation value
-     * instead of CRC (see swru191c.pdf Chapter 23.9.7 Frame-Check Sequence) */
-    payloadLength -= IEEE802154_CRCLENGTH;
-    rxFramePtr = (uint8_t*)IEEE802154_RxDataFrame.payload;
-    for (i=0; i<payloadLength; i++)
+    if ((victim->addressMode != IEEE802154_FCF_ADDRESS_MODE_NONE) &&
+        ((entry->addressMode == IEEE802154_FCF_ADDRESS_MODE_NONE) ||
+         ((IEEE802154_Timestamp_t)(now - entry->timestamp) > (IEEE802154_Timestamp_t)(now - victim->timestamp))))
     {
-      *rxFramePtr++ = RFD;
+      victim = entry;
     }
-    /* Check CRC and copy RSSI */
-    sint8_t rssi = RFD;
-    uint8_t crc_ok = RFD;
-    /* Check which frame was received and call appropriate callback */
-    if (crc_ok & IEEE802154_CRCOK_MASK)
+  }
+  /* entry is taken over by the source, it must not match the current frame */
+  victim->addressMode = IEEE802154_FCF_ADDRESS_MODE_NONE;
+  return victim;
+}
+#endif
+
+/**
+ * Reads a short or extended address from RXFIFO. Both are transmitted least
+ * significant byte first, extended addresses are kept in that order.
+*/
+static void IEEE802154_readAddress(IEEE802154_Adress_t *address, uint8_t addressMode)
+{
+  uint8_t i;
+  if (addressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
+  {
+    address->shortAddress = IEEE802154_RADIO_READ_RXFIFO();
+    address->shortAddress |= (uint16_t)IEEE802154_RADIO_READ_RXFIFO() << 8;
+  }
+  else
+  {
+    for( i=0; i< sizeof(IEEE802154_ExtendedAddress_t) ;i++ )
     {
-      if (IEEE802154_RxDataFrame.fcf.frameType == IEEE802154_FCF_FRAME_TYPE_BEACON)
-      {
-        IEEE802154_UserCbk_BeaconFrameReceived(payloadLength, rssi);
-      }
-      else if (IEEE802154_RxDataFrame.fcf.frameType == IEEE802154_FCF_FRAME_TYPE_DATA)
-      {
-        IEEE802154_UserCbk_DataFrameReceived(payloadLength, rssi);
-      }
-      if (IEEE802154_RxDataFrame.fcf.frameType == IEEE802154_FCF_FRAME_TYPE_ACKNOWLEDGE)
-      {
-        IEEE802154_UserCbk_AckFrameReceived(payloadLength, rssi);
-      }
-      else 
-      {
-        IEEE802154_UserCbk_MACCommandFrameReceived(payloadLength, rssi);
-      }
+      address->extendedAdress[i] = IEEE802154_RADIO_READ_RXFIFO();
     }
-    else {
-      IEEE802154_UserCbk_CRCError(payloadLength, rssi);
-    }
-    clearInterruptFlag(RFIRQF0, RFIRQF0_RXPKTDONE);  // Clear package received interrupt flag
-    
-    /** @todo read RSSI or LQI to global variable */
   }
-  /* according to (swru191c.pdf) 23.1.2 Interrupt Registers
-     To clear an interrupt from the RF Core, one must clear two flags, both the flag 
-     set in RF Core and the one set in S1CON or TCON (depending on which interrupt
-     is triggered). */
-   S1CON = 0;
-   IEEE802154_ISFLUSHRX();
 }
 
 /**
- * Blocking send of data frame via radio.
- * @param header header of frame including pointer to payload
- * @param payloadLength length of frame payload excluding header and CRC
- * @note Only auto-crc is supported right now
+ * Writes a short or extended address to TXFIFO, least significant byte first.
 */
-void IEEE802154_radioSentDataFrame(IEEE802154_DataFrameHeader_t* header, uint8_t payloadLength)
+static void IEEE802154_writeAddress(const IEEE802154_Adress_t *address, uint8_t addressMode)
 {
   uint8_t i;
-  
-  /* @todo check length */
-
-  IEEE802154_ISFLUSHTX();          /* Flush TX FIFO */
-
-  clearInterruptFlag(RFIRQF1, RFIRQF1_TXDONE);   /* Clear TX interrupt */
-  
-  /* write length first. Size of header (without pointer to payload) + 2 * address 
-  (short or extended) payloadlength + 2 bytes CRC */
-  uint8_t txLength = IEEE802154_HEADERSIZE_STATIC + IEEE802154_CRCLENGTH;
-  if (header->fcf.destinationAddressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT)
+  if (addressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
   {
-    txLength += sizeof(IEEE802154_ExtendedAddress_t);
+    IEEE802154_RADIO_WRITE_TXFIFO(LO_UINT16(address->shortAddress));
+    IEEE802154_RADIO_WRITE_TXFIFO(HI_UINT16(address->shortAddress));
   }
-  if (header->fcf.sourceAddressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT)
+  else
   {
-    txLength += sizeof(IEEE802154_ExtendedAddress_t);
+    for( i=0; i< sizeof(IEEE802154_ExtendedAddress_t); i++ )
+    {
+      IEEE802154_RADIO_WRITE_TXFIFO(address->extendedAdress[i]);
+    }
   }
-  if (header->fcf.destinationAddressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
+}
+
+/**
+ * Reads one frame from RXFIFO into IEEE802154_RxDataFrame and calls the callback
+ * depending on frame type. With IEEE802154_ENABLE_RX_QUEUE the frame is read into
+ * the next free slot of the receive queue instead and no callback except
+ * IEEE802154_UserCbk_CRCError() is called. The length byte must already be read from RXFIFO, the
+ * function consumes exactly frameLength further bytes so that a following frame in
+ * RXFIFO can be read afterwards. If the payload is copied by DMA the function returns
+ * with IEEE802154_RX_PENDING() set, RSSI and Correlation value are then read and the
+ * frame is finished by IEEE802154_dmaISR(). An invalid frameLength flushes RXFIFO as the
+ * following frames can not be located anymore.
+ * @param frameLength PHY length byte of frame (MAC header, payload and 2 bytes RSSI/CRC)
+*/
+static void IEEE802154_receiveFrame(uint8_t frameLength)
+{
+  uint8_t i;
+  uint8_t payloadLength;
+  const IEEE802154_FrameLayout_t *layout;
+#ifdef IEEE802154_ENABLE_RX_QUEUE
+  IEEE802154_RxQueueSlot_t *slot;
+  IEEE802154_DataFrameHeader_t *frame;
+#else
+  IEEE802154_DataFrameHeader_t *frame = &IEEE802154_RxDataFrame;
+#endif
+  uint8_t *rxFramePtr;
+#ifdef IEEE802154_ENABLE_DUPLICATE_FILTER
+  IEEE802154_DuplicateEntry_t *duplicateEntry = NULL;
+  IEEE802154_Timestamp_t now;
+#endif
+#ifdef IEEE802154_ENABLE_SECURITY
+  uint8_t auxHeader[IEEE802154_AUX_HEADER_MAX_SIZE];
+  uint8_t auxLength;
+#endif
+#if defined(IEEE802154_ENABLE_SCATTER_GATHER) && !defined(IEEE802154_ENABLE_RX_QUEUE)
+  const IEEE802154_Segment_t *segment;
+  uint8_t scatter;
+  uint8_t remaining;
+#endif
+
+  if ((frameLength < IEEE802154_ACK_PACKET_SIZE) || (frameLength > IEEE802154_MAX_PHY_PACKET_SIZE))
   {
-    txLength += sizeof(IEEE802154_ShortAddress_t);
+    /* invalid length byte, frame boundaries in RXFIFO are lost */
+    IEEE802154_STAT_INC(rxMalformed);
+    IEEE802154_STAT_INC(rxFlushes);
+    IEEE802154_ISFLUSHRX();
+    return;
   }
-  if (header->fcf.sourceAddressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
+#ifdef IEEE802154_ENABLE_SOFTWARE_CRC
+  IEEE802154_rxFcs = IEEE802154_CRC16_INIT;
+#endif
+#ifdef IEEE802154_ENABLE_RX_QUEUE
+  /* Single producer: only the ISR writes IEEE802154_rxQueueHead, the slot at head is
+   * owned by the ISR until head is advanced */
+  if ((uint8_t)(IEEE802154_rxQueueHead - IEEE802154_rxQueueTail) >= IEEE802154_RX_QUEUE_SIZE)
   {
-    txLength += sizeof(IEEE802154_ShortAddress_t);
+    IEEE802154_RxQueueDropped++;
+    IEEE802154_STAT_INC(rxQueueFull);
+    for (i=0; i<frameLength; i++)
+    {
+      (void)IEEE802154_RADIO_READ_RXFIFO();
+    }
+    return;
   }
-  RFD = txLength;
-  
-  /* Write 2 bytes frame control field, 1 byte sequence number, and 2 bytes destination pan ID */
-  for( i=0; i< IEEE802154_HEADERSIZE_STATIC ;i++ )
+  slot = &IEEE802154_rxQueue[IEEE802154_rxQueueHead & (IEEE802154_RX_QUEUE_SIZE - 1)];
+  frame = &slot->header;
+#endif
+
+  /* Read 2 bytes frame control field and 1 byte sequence number */
+  rxFramePtr = (uint8_t*)&frame->fcf;
+  rxFramePtr[0] = IEEE802154_RADIO_READ_RXFIFO();
+  rxFramePtr[1] = IEEE802154_RADIO_READ_RXFIFO();
+  frame->sequenceNumber = IEEE802154_RADIO_READ_RXFIFO();
+  /* position of all addressing fields in one lookup */
+  layout = &IEEE802154_frameLayout[IEEE802154_FRAME_LAYOUT_INDEX(rxFramePtr[0], rxFramePtr[1])];
+  /* remaining bytes of frame without RSSI and Correlation value */
+  payloadLength = frameLength - IEEE802154_CRCLENGTH;
+  if ((layout->headerLength == 0) || (layout->headerLength > payloadLength))
   {
-    RFD = ((uint8_t*)header)[i];
+    /* reserved address mode or truncated frame, skip it including RSSI and Correlation value */
+    IEEE802154_STAT_INC(rxMalformed);
+    for (i=IEEE802154_FRAME_HEADER_MIN; i<frameLength; i++)
+    {
+      (void)IEEE802154_RADIO_READ_RXFIFO();
+    }
+    return;
   }
-  if (header->fcf.destinationAddressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT)
+  payloadLength -= layout->headerLength;
+#ifdef IEEE802154_ENABLE_RX_QUEUE
+  if (payloadLength > IEEE802154_RX_QUEUE_PAYLOAD_SIZE)
   {
-    for( i=0; i< sizeof(IEEE802154_ExtendedAddress_t); i++ )
+    /* does not fit into slot, skip it */
+    IEEE802154_RxQueueDropped++;
+    IEEE802154_STAT_INC(rxTooLong);
+    for (i=IEEE802154_FRAME_HEADER_MIN; i<frameLength; i++)
     {
-      RFD = header->destinationAddress.extendedAdress[i];
+      (void)IEEE802154_RADIO_READ_RXFIFO();
     }
+    return;
   }
-  else if (header->fcf.destinationAddressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT){
-    RFD = LO_UINT16(header->destinationAddress.shortAddress);
-    RFD = HI_UINT16(header->destinationAddress.shortAddress);
+#endif
+#if defined(IEEE802154_ENABLE_SCATTER_GATHER) && !defined(IEEE802154_ENABLE_RX_QUEUE)
+  /* secured frames are decrypted in place and need a contiguous payload */
+  scatter = (IEEE802154_rxSegments != NULL) && (frame->fcf.frameType == IEEE802154_FCF_FRAME_TYPE_DATA);
+#ifdef IEEE802154_ENABLE_SECURITY
+  scatter = scatter && !frame->fcf.securityEnabled;
+#endif
+  if (scatter && (payloadLength > IEEE802154_rxSegmentsCapacity))
+  {
+    /* does not fit into receive segments, skip it */
+    IEEE802154_STAT_INC(rxTooLong);
+    for (i=IEEE802154_FRAME_HEADER_MIN; i<frameLength; i++)
+    {
+      (void)IEEE802154_RADIO_READ_RXFIFO();
+    }
+    return;
   }
-  else {
-    /* nothing if IEEE802154_FCF_ADDRESS_MODE_NONE */
+#endif
+
+  if (layout->destinationAddressOffset != 0)
+  {
+    frame->destinationPANID = IEEE802154_RADIO_READ_RXFIFO();
+    frame->destinationPANID |= (uint16_t)IEEE802154_RADIO_READ_RXFIFO() << 8;
+    IEEE802154_readAddress(&frame->destinationAddress, frame->fcf.destinationAddressMode);
   }
+  if (layout->sourcePANIDOffset != 0)
+  {
 #ifndef IEEE802154_ENABLE_PANID_COMPRESSION
-  RFD = header->sourcePANID;
+    frame->sourcePANID = IEEE802154_RADIO_READ_RXFIFO();
+    frame->sourcePANID |= (uint16_t)IEEE802154_RADIO_READ_RXFIFO() << 8;
+#else
+    (void)IEEE802154_RADIO_READ_RXFIFO();
+    (void)IEEE802154_RADIO_READ_RXFIFO();
 #endif
-  if (header->fcf.sourceAddressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT)
+  }
+#ifndef IEEE802154_ENABLE_PANID_COMPRESSION
+  else
   {
-    for( i=0; i< sizeof(IEEE802154_ExtendedAddress_t); i++ )
+    /* compressed or no source address: source PAN is destination PAN */
+    frame->sourcePANID = frame->destinationPANID;
+  }
+#endif
+  if (layout->sourceAddressOffset != 0)
+  {
+    IEEE802154_readAddress(&frame->sourceAddress, frame->fcf.sourceAddressMode);
+#ifdef IEEE802154_ENABLE_DUPLICATE_FILTER
+    if ((frame->fcf.frameType == IEEE802154_FCF_FRAME_TYPE_DATA) || (frame->fcf.frameType == IEEE802154_FCF_FRAME_TYPE_MAC_COMMAND))
     {
-      RFD = header->sourceAddress.extendedAdress[i];
+      now = IEEE802154_RADIO_TIMESTAMP();
+      duplicateEntry = IEEE802154_duplicateFind(frame, now);
+      if ((duplicateEntry->addressMode != IEEE802154_FCF_ADDRESS_MODE_NONE) &&
+          (duplicateEntry->sequenceNumber == frame->sequenceNumber) &&
+          ((IEEE802154_Timestamp_t)(now - duplicateEntry->timestamp) < IEEE802154_DUPLICATE_LIFETIME))
+      {
+        /* retransmission of a frame already received, skip payload, RSSI and Correlation value */
+        IEEE802154_DuplicateHits++;
+        IEEE802154_STAT_INC(rxDuplicates);
+        for (i=0; i<payloadLength + IEEE802154_CRCLENGTH; i++)
+        {
+          (void)IEEE802154_RADIO_READ_RXFIFO();
+        }
+        return;
+      }
+      IEEE802154_DuplicateMisses++;
+      /* only read together with IEEE802154_rxDuplicateEntry */
+      IEEE802154_rxTimestamp = now;
     }
+#endif
   }
-  else if (header->fcf.sourceAddressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT) {
-    RFD = HI_UINT16(header->sourceAddress.shortAddress);
-    RFD = LO_UINT16(header->sourceAddress.shortAddress);
+#ifdef IEEE802154_ENABLE_SECURITY
+  if (frame->fcf.securityEnabled)
+  {
+    /* auxiliary security header follows the addressing fields, its length is given by its first byte */
+    if (payloadLength == 0)
+    {
+      auxLength = 1;
+    }
+    else
+    {
+      auxHeader[0] = IEEE802154_RADIO_READ_RXFIFO();
+      auxLength = IEEE802154_AUX_HEADER_LENGTH(auxHeader[0]);
+    }
+    if (auxLength > payloadLength)
+    {
+      /* truncated, skip rest of frame including RSSI and Correlation value */
+      IEEE802154_STAT_INC(rxMalformed);
+      for (i=(payloadLength == 0) ? 0 : 1; i<payloadLength + IEEE802154_CRCLENGTH; i++)
+      {
+        (void)IEEE802154_RADIO_READ_RXFIFO();
+      }
+      return;
+    }
+    for (i=1; i<auxLength; i++)
+    {
+      auxHeader[i] = IEEE802154_RADIO_READ_RXFIFO();
+    }
+    (void)IEEE802154_securityAuxHeaderParse(&frame->auxSecurityHeader, auxHeader, auxLength);
+    payloadLength -= auxLength;
   }
-  else {
-    /* nothing if IEEE802154_FCF_ADDRESS_MODE_NONE */
+#endif
+  IEEE802154_rxFrame = frame;
+  IEEE802154_rxFrameLength = frameLength;
+  IEEE802154_rxPayloadLength = payloadLength;
+#ifdef IEEE802154_ENABLE_DUPLICATE_FILTER
+  IEEE802154_rxDuplicateEntry = duplicateEntry;
+#endif
+  /* Copy remaining payload, ignore two more bytes with RSSI and Correlation value
+   * instead of CRC (see swru191c.pdf Chapter 23.9.7 Frame-Check Sequence) */
+#if defined(IEEE802154_ENABLE_SCATTER_GATHER) && !defined(IEEE802154_ENABLE_RX_QUEUE)
+  if (scatter)
+  {
+    /* fill receive segments in order, capacity has been checked above. All but the last
+     * segment are read by the CPU, the last one like a contiguous payload. */
+    segment = IEEE802154_rxSegments;
+    for (remaining = payloadLength; remaining > segment->length; segment++)
+    {
+      for (i=0; i<segment->length; i++)
+      {
+        segment->data[i] = IEEE802154_RADIO_READ_RXFIFO();
+      }
+      remaining -= segment->length;
+    }
+    IEEE802154_readPayload(segment->data, remaining);
   }
-
-  /* finally write paylod to buffer */
-  for(i=0;i<payloadLength ;i++)
+  else
+#endif
   {
-    RFD = header->payload[i];
+    IEEE802154_readPayload(frame->payload, payloadLength);
+  }
+  if (!IEEE802154_RX_PENDING())
+  {
+    IEEE802154_receiveFrameEnd();
   }
-  
-  // Enable TX after calibration
-  IEEE802154_ISTXON();
-  
-  // wait until transmission is finished
-  while ((RFIRQF1 & RFIRQF1_TXDONE) == 0) ;
-  clearInterruptFlag(RFIRQF1, RFIRQF1_TXDONE);   // Clear TX interrupt
 }
 
-/** Retransmission of the last frame sent (i.e. in case no ack was received).
- * See Chapter 23.8.4 Retransmission "After a frame has been successfully transmitted, 
- * the FIFO contents are left unchanged. To retransmit the same frame, simply restart 
- * TX by issuing an STXON or STXONCCA command strobe. Note that a retransmission of a 
- * packet is only possible if the packet has been completely transmitted; i.e., a 
- * packet cannot be aborted and then be retransmitted." */
-void IEEE802154_retransmit()
+/**
+ * Second part of IEEE802154_receiveFrame() once the payload of IEEE802154_rxFrame has been
+ * read: reads RSSI and Correlation value, checks CRC and security, publishes the frame to
+ * the receive queue or calls the callback depending on frame type.
+*/
+static void IEEE802154_receiveFrameEnd(void)
 {
-  // Enable TX after calibration
-  IEEE802154_ISTXON();
-}
+  IEEE802154_DataFrameHeader_t *frame = IEEE802154_rxFrame;
+  uint8_t payloadLength = IEEE802154_rxPayloadLength;
+#ifdef IEEE802154_ENABLE_RX_QUEUE
+  IEEE802154_RxQueueSlot_t *slot = &IEEE802154_rxQueue[IEEE802154_rxQueueHead & (IEEE802154_RX_QUEUE_SIZE - 1)];
+
+  (void)frame;   /* header is already in the slot, frame is only used by optional features */
+#endif
+
+#ifdef IEEE802154_ENABLE_SOFTWARE_CRC
+  /* FCS over frame including received FCS is 0 if frame is valid */
+  (void)IEEE802154_RADIO_READ_RXFIFO();
+  (void)IEEE802154_RADIO_READ_RXFIFO();
+  sint8_t rssi = (sint8_t)RSSI;
+  uint8_t crc_ok = (IEEE802154_rxFcs == IEEE802154_CRC16_INIT) ? IEEE802154_CRCOK_MASK : 0;
+#else
+  /* Check CRC and copy RSSI */
+  sint8_t rssi = IEEE802154_RADIO_READ_RXFIFO();
+  uint8_t crc_ok = IEEE802154_RADIO_READ_RXFIFO();
+#endif
+#ifdef IEEE802154_ENABLE_SECURITY
+  if ((crc_ok & IEEE802154_CRCOK_MASK) && frame->fcf.securityEnabled &&
+      !IEEE802154_securityIncomingFrame(frame, &payloadLength))
+  {
+    /* not authentic or replayed, drop silently */
+    IEEE802154_STAT_INC(rxSecurityFailures);
+    return;
+  }
+#endif
+  /* Check which frame was received and call appropriate callback */
+  if (crc_ok & IEEE802154_CRCOK_MASK)
+  {
+    IEEE802154_STAT_INC(rxFrames[(frame->fcf.frameType < IEEE802154_STATISTICS_FRAME_TYPES) ?
+                                 frame->fcf.frameType : IEEE802154_FCF_FRAME_TYPE_MAC_COMMAND]);
+    IEEE802154_STAT_ADD(rxBytes, IEEE802154_rxFrameLength);
+#ifdef IEEE802154_ENABLE_DUPLICATE_FILTER
+    /* only frames with valid CRC update the cache */
+    if (IEEE802154_rxDuplicateEntry != NULL)
+    {
+      IEEE802154_rxDuplicateEntry->sourceAddress = frame->sourceAddress;
+      IEEE802154_rxDuplicateEntry->addressMode = frame->fcf.sourceAddressMode;
+      IEEE802154_rxDuplicateEntry->sequenceNumber = frame->sequenceNumber;
+      IEEE802154_rxDuplicateEntry->timestamp = IEEE802154_rxTimestamp;
+    }
+#endif
+#ifdef IEEE802154_ENABLE_NEIGHBOR_TABLE
+    if (frame->fcf.sourceAddressMode != IEEE802154_FCF_ADDRESS_MODE_NONE)
+    {
+      IEEE802154_neighborUpdate(frame, rssi, crc_ok & (uint8_t)~IEEE802154_CRCOK_MASK, IEEE802154_RADIO_TIMESTAMP());
+    }
+#endif
+#ifdef IEEE802154_ENABLE_INDIRECT_QUEUE
+    /* frame pending was set in ACK by AUTOACK, answer with queued frame right away */
+    if ((frame->fcf.frameType == IEEE802154_FCF_FRAME_TYPE_MAC_COMMAND) && (payloadLength > 0) &&
+        (frame->payload[0] == IEEE802154_MAC_COMMAND_DATA_REQUEST))
+    {
+      IEEE802154_indirectDataRequest(frame);
+    }
+#endif
+#ifdef IEEE802154_ENABLE_CSMA
+    if ((frame->fcf.frameType == IEEE802154_FCF_FRAME_TYPE_ACKNOWLEDGE) &&
+        (IEEE802154_csmaState == IEEE802154_CSMA_STATE_WAIT_ACK) &&
+        (frame->sequenceNumber == IEEE802154_csmaSequenceNumber))
+    {
+      IEEE802154_csmaState = IEEE802154_CSMA_STATE_IDLE;
+      IEEE802154_txComplete(IEEE802154_TX_SUCCESS);
+    }
+#endif
+#ifdef IEEE802154_ENABLE_RX_QUEUE
+    slot->payloadLength = payloadLength;
+    slot->rssi = rssi;
+    slot->lqi = crc_ok & (uint8_t)~IEEE802154_CRCOK_MASK;
+    slot->timestamp = IEEE802154_RADIO_TIMESTAMP();
+    /* publish slot to consumer */
+    IEEE802154_rxQueueHead++;
+#else
+    switch (frame->fcf.frameType)
+    {
+      case IEEE802154_FCF_FRAME_TYPE_BEACON:
+        IEEE802154_UserCbk_BeaconFrameReceived(payloadLength, rssi);
+        break;
+      case IEEE802154_FCF_FRAME_TYPE_DATA:
+        IEEE802154_UserCbk_DataFrameReceived(payloadLength, rssi);
+        break;
+      case IEEE802154_FCF_FRAME_TYPE_ACKNOWLEDGE:
+        IEEE802154_UserCbk_AckFrameReceived(payloadLength, rssi);
+        break;
+      default:
+        IEEE802154_UserCbk_MACCommandFrameReceived(payloadLength, rssi);
+        break;
+    }
+#endif
+  }
+  else {
+    IEEE802154_STAT_INC(rxCrcErrors);
+    IEEE802154_UserCbk_CRCError(payloadLength, rssi);
+  }
+}
+
+/**
+ * ISR for IEEE 802.15.4 radio. ISR must check bits of RFIRQF0 to further check
+ * which situation happend. As of now only RXPKTDONE is used for data reception and,
+ * with IEEE802154_ENABLE_TX_QUEUE, TXDONE of RFIRQF1 to start the next queued frame.
+ * In case a complete frame hase been received (RXPKTDONE) the ISR will first fill fcf 
+ * data and copy data to receive buffer. If crc is ok callback function depending 
+ * frame type is called.
+ * With IEEE802154_ENABLE_RX_DRAIN all complete frames in RXFIFO are handled, RXFIFO is
+ * only flushed on overflow or if a length byte is invalid. Otherwise only the first
+ * frame is handled and RXFIFO is flushed afterwards.
+ * Access global variable declared by IEEE 802.15.4 module but definited by application.
+*/
+#ifndef IEEE802154_SIMULATION
+#pragma vector = RF_VECTOR
+#endif
+IEEE802154_RADIO_ISR_ATTRIBUTES void IEEE802154_radioISR(void)
+{
+#ifdef IEEE802154_ENABLE_STATISTICS
+  uint32_t start = IEEE802154_RADIO_CYCLES();
+#endif
+#if defined(IEEE802154_ENABLE_TX_QUEUE) || defined(IEEE802154_ENABLE_CSMA)
+  /* TXDONE is handled first, an acknowledge received in the same interrupt belongs to it */
+  if( RFIRQF1 & RFIRQF1_TXDONE ) /* A frame has been sent. */
+  {
+    clearInterruptFlag(RFIRQF1, RFIRQF1_TXDONE);
+#ifdef IEEE802154_ENABLE_CSMA
+    /* TXDONE of IEEE802154_retransmit() outside of CSMA-CA is ignored */
+    if (IEEE802154_csmaState == IEEE802154_CSMA_STATE_TX)
+    {
+      if (IEEE802154_csmaAckRequired)
+      {
+        IEEE802154_csmaState = IEEE802154_CSMA_STATE_WAIT_ACK;
+        IEEE802154_csmaTimer = IEEE802154_CsmaConfig.ackWaitPeriods;
+      }
+      else
+      {
+        IEEE802154_csmaState = IEEE802154_CSMA_STATE_IDLE;
+        IEEE802154_txComplete(IEEE802154_TX_SUCCESS);
+      }
+    }
+#else
+    /* TXDONE of IEEE802154_retransmit() while queue is empty is ignored */
+    if (IEEE802154_txQueueHead != IEEE802154_txQueueTail)
+    {
+      IEEE802154_txComplete(IEEE802154_TX_SUCCESS);
+    }
+#endif
+  }
+#endif
+#ifdef IEEE802154_ENABLE_SNIFFER
+  if (IEEE802154_SnifferActive)
+  {
+    if (RFIRQF0 & RFIRQF0_RXPKTDONE)
+    {
+      /* raw capture of all frames instead of MAC processing */
+      clearInterruptFlag(RFIRQF0, RFIRQF0_RXPKTDONE);
+      IEEE802154_snifferDrain();
+    }
+  }
+  else
+#endif
+  if( RFIRQF0 & RFIRQF0_RXPKTDONE ) /* A complete frame has been received. */
+  {
+    /* Clear package received interrupt flag first, a frame completed while reading
+     * RXFIFO will raise it again */
+    clearInterruptFlag(RFIRQF0, RFIRQF0_RXPKTDONE);
+    /* while a payload is copied by DMA RXFIFO is left to IEEE802154_dmaISR(), it handles
+     * the frames received meanwhile once the current one is finished */
+    if (!IEEE802154_RX_PENDING())
+    {
+#ifdef IEEE802154_ENABLE_RX_DRAIN
+      IEEE802154_rxFifoDrain();
+#else
+      /* handle receive interrupt, first read payload length from rx-buffer. */
+      IEEE802154_receiveFrame(IEEE802154_RADIO_READ_RXFIFO());
+      if (!IEEE802154_RX_PENDING())
+      {
+        IEEE802154_rxFifoFlush();
+      }
+#endif
+    }
+  }
+  /* according to (swru191c.pdf) 23.1.2 Interrupt Registers
+     To clear an interrupt from the RF Core, one must clear two flags, both the flag 
+     set in RF Core and the one set in S1CON or TCON (depending on which interrupt
+     is triggered). */
+   S1CON = 0;
+   IEEE802154_STAT_CYCLES(isrCycles, start);
+}
+
+#ifdef IEEE802154_ENABLE_RX_DRAIN
+/**
+ * Handles all complete frames in RXFIFO. Stops at a frame whose payload is copied by
+ * DMA, IEEE802154_dmaISR() calls the function again once that frame is finished. RXFIFO
+ * is only flushed on overflow or if a length byte is invalid.
+*/
+static void IEEE802154_rxFifoDrain(void)
+{
+  uint8_t frameLength;
+  uint8_t framesHandled = 0;
+
+  /* RXFIFO may contain more than one frame, handle all complete ones */
+  while (RXFIFOCNT > 0)
+  {
+    /* peek length byte, frame may still be in reception */
+    frameLength = RXFIRST;
+    if ((frameLength < IEEE802154_ACK_PACKET_SIZE) || (frameLength > IEEE802154_MAX_PHY_PACKET_SIZE))
+    {
+      /* lost synchronisation with frame boundaries */
+      IEEE802154_STAT_INC(rxMalformed);
+      IEEE802154_STAT_INC(rxFlushes);
+      IEEE802154_ISFLUSHRX();
+      break;
+    }
+    if (frameLength >= RXFIFOCNT)
+    {
+      /* incomplete, RXPKTDONE will be raised again once it is received */
+      break;
+    }
+    (void)IEEE802154_RADIO_READ_RXFIFO();
+    IEEE802154_receiveFrame(frameLength);
+    framesHandled++;
+    if (IEEE802154_RX_PENDING())
+    {
+      break;
+    }
+  }
+  if (!IEEE802154_RX_PENDING() && (RFERRF & RFERRF_RXOVERF))
+  {
+    /* frames completed before the overflow have been handled, the remainder is corrupt */
+    IEEE802154_STAT_INC(rxOverflows);
+    IEEE802154_STAT_INC(rxFlushes);
+    IEEE802154_ISFLUSHRX();
+    clearInterruptFlag(RFERRF, RFERRF_RXOVERF);
+  }
+  IEEE802154_RxFramesPerInterrupt = framesHandled;
+  if (framesHandled > IEEE802154_RxFramesPerInterruptMax)
+  {
+    IEEE802154_RxFramesPerInterruptMax = framesHandled;
+  }
+}
+#else
+/**
+ * Discards everything behind the frame handled by the RF ISR.
+*/
+static void IEEE802154_rxFifoFlush(void)
+{
+#ifdef IEEE802154_ENABLE_STATISTICS
+  if (RXFIFOCNT > 0)
+  {
+    IEEE802154_statistics.rxTrailingDropped++;
+  }
+  if (RFERRF & RFERRF_RXOVERF)
+  {
+    /* flag is not evaluated otherwise, clear it to count each overflow once */
+    IEEE802154_statistics.rxOverflows++;
+    clearInterruptFlag(RFERRF, RFERRF_RXOVERF);
+  }
+#endif
+  IEEE802154_ISFLUSHRX();
+}
+#endif
+
+/**
+ * Reads payload from RXFIFO. With IEEE802154_ENABLE_DMA longer payloads are copied by
+ * DMA, the function then returns with IEEE802154_RX_PENDING() set and the frame is
+ * finished by IEEE802154_dmaISR().
+ * @param payload buffer for payload
+ * @param payloadLength number of bytes to read
+*/
+static void IEEE802154_readPayload(IEEE802154_PayloadPointer payload, uint8_t payloadLength)
+{
+  uint8_t i;
+#ifdef IEEE802154_ENABLE_DMA
+  if (payloadLength >= IEEE802154_DMA_MIN_LENGTH)
+  {
+    /* RSSI and Correlation value must not be read before payload has been moved */
+    IEEE802154_dmaRxPending = 1;
+    IEEE802154_RADIO_DMA_FROM_RXFIFO(payload, payloadLength);
+    return;
+  }
+#endif
+  for (i=0; i<payloadLength; i++)
+  {
+    payload[i] = IEEE802154_RADIO_READ_RXFIFO();
+  }
+}
+
+/**
+ * Checks that a frame fits into aMaxPHYPacketSize before anything is written to TXFIFO.
+ * @param headerLength MAC header length, 0 if header uses a reserved address mode
+ * @param payloadLength length of frame payload excluding header and CRC
+ * @return IEEE802154_TX_SUCCESS, IEEE802154_TX_INVALID_PARAMETER for a reserved address
+ * mode or IEEE802154_TX_FRAME_TOO_LONG if header, payload and FCS exceed aMaxPHYPacketSize
+*/
+static uint8_t IEEE802154_frameLengthCheck(uint8_t headerLength, uint16_t payloadLength)
+{
+  if (headerLength == 0)
+  {
+    return IEEE802154_TX_INVALID_PARAMETER;
+  }
+  if (headerLength + payloadLength + IEEE802154_CRCLENGTH > IEEE802154_MAX_PHY_PACKET_SIZE)
+  {
+    return IEEE802154_TX_FRAME_TOO_LONG;
+  }
+  return IEEE802154_TX_SUCCESS;
+}
+
+/**
+ * Writes length byte, header and payload of data frame to TXFIFO and starts
+ * transmission, see IEEE802154_writePayload(). With IEEE802154_ENABLE_SECURITY frames
+ * with security enabled are secured by IEEE802154_securityOutgoingFrame() first.
+ * @param header header of frame including pointer to payload
+ * @param payloadLength length of frame payload excluding header and CRC
+ * @return IEEE802154_TX_SUCCESS if transmission was started, otherwise reason why the
+ * frame could not be sent, see IEEE802154_frameLengthCheck(), or could not be secured
+ * @note FCS is appended by AUTOCRC or, with IEEE802154_ENABLE_SOFTWARE_CRC, by IEEE802154_writePayload()
+*/
+static uint8_t IEEE802154_writeDataFrame(IEEE802154_DataFrameHeader_t* header, uint8_t payloadLength)
+{
+  uint8_t status;
+#ifdef IEEE802154_ENABLE_SECURITY
+  uint8_t length;
+
+  if (header->fcf.securityEnabled)
+  {
+    /* header, auxiliary security header, payload and MIC are secured in RAM and written like a payload */
+    status = IEEE802154_securityOutgoingFrame(header, payloadLength, IEEE802154_securedFrame, &length);
+    if (status != IEEE802154_TX_SUCCESS)
+    {
+      return status;
+    }
+    IEEE802154_ISFLUSHTX();
+    clearInterruptFlag(RFIRQF1, RFIRQF1_TXDONE);
+    IEEE802154_RADIO_WRITE_TXFIFO(length + IEEE802154_CRCLENGTH);
+    IEEE802154_STAT_INC(txFrames);
+    IEEE802154_STAT_ADD(txBytes, length + IEEE802154_CRCLENGTH);
+#ifdef IEEE802154_ENABLE_SOFTWARE_CRC
+    IEEE802154_txFcs = IEEE802154_CRC16_INIT;
+#endif
+    IEEE802154_writePayload(IEEE802154_securedFrame, length, header->fcf.ackRequired, header->sequenceNumber);
+    return IEEE802154_TX_SUCCESS;
+  }
+#endif
+
+  status = IEEE802154_frameLengthCheck(IEEE802154_HEADER_LENGTH(header), payloadLength);
+  if (status != IEEE802154_TX_SUCCESS)
+  {
+    return status;
+  }
+  IEEE802154_writeDataFrameHeader(header, payloadLength);
+
+  /* finally write paylod to buffer */
+  IEEE802154_writePayload(header->payload, payloadLength, header->fcf.ackRequired, header->sequenceNumber);
+  return IEEE802154_TX_SUCCESS;
+}
+
+/**
+ * Writes length byte and MAC header of an unsecured data frame to TXFIFO, the payload
+ * has to follow.
+ * @param header header of frame
+ * @param payloadLength length of frame payload excluding header and CRC
+*/
+static void IEEE802154_writeDataFrameHeader(const IEEE802154_DataFrameHeader_t* header, uint8_t payloadLength)
+{
+  const IEEE802154_FrameLayout_t *layout;
+  const uint8_t *fcf = (const uint8_t*)&header->fcf;
+
+  layout = &IEEE802154_frameLayout[IEEE802154_FRAME_LAYOUT_INDEX(fcf[0], fcf[1])];
+
+  IEEE802154_ISFLUSHTX();          /* Flush TX FIFO */
+
+  clearInterruptFlag(RFIRQF1, RFIRQF1_TXDONE);   /* Clear TX interrupt */
+  
+  /* write length first: header, payload and 2 bytes CRC */
+  IEEE802154_RADIO_WRITE_TXFIFO(layout->headerLength + payloadLength + IEEE802154_CRCLENGTH);
+  IEEE802154_STAT_INC(txFrames);
+  IEEE802154_STAT_ADD(txBytes, layout->headerLength + payloadLength + IEEE802154_CRCLENGTH);
+#ifdef IEEE802154_ENABLE_SOFTWARE_CRC
+  IEEE802154_txFcs = IEEE802154_CRC16_INIT;   /* length byte is not covered by FCS */
+#endif
+  
+  /* Write 2 bytes frame control field and 1 byte sequence number */
+  IEEE802154_RADIO_WRITE_TXFIFO(fcf[0]);
+  IEEE802154_RADIO_WRITE_TXFIFO(fcf[1]);
+  IEEE802154_RADIO_WRITE_TXFIFO(header->sequenceNumber);
+  if (layout->destinationAddressOffset != 0)
+  {
+    IEEE802154_RADIO_WRITE_TXFIFO(LO_UINT16(header->destinationPANID));
+    IEEE802154_RADIO_WRITE_TXFIFO(HI_UINT16(header->destinationPANID));
+    IEEE802154_writeAddress(&header->destinationAddress, header->fcf.destinationAddressMode);
+  }
+  if (layout->sourcePANIDOffset != 0)
+  {
+#ifndef IEEE802154_ENABLE_PANID_COMPRESSION
+    IEEE802154_RADIO_WRITE_TXFIFO(LO_UINT16(header->sourcePANID));
+    IEEE802154_RADIO_WRITE_TXFIFO(HI_UINT16(header->sourcePANID));
+#else
+    IEEE802154_RADIO_WRITE_TXFIFO(LO_UINT16(header->destinationPANID));
+    IEEE802154_RADIO_WRITE_TXFIFO(HI_UINT16(header->destinationPANID));
+#endif
+  }
+  if (layout->sourceAddressOffset != 0)
+  {
+    IEEE802154_writeAddress(&header->sourceAddress, header->fcf.sourceAddressMode);
+  }
+}
+
+/**
+ * Writes length byte, flow header template with sequence number filled in and payload
+ * to TXFIFO and starts transmission, see IEEE802154_writePayload().
+ * @param flow prepared flow
+ * @param sequenceNumber sequence number of frame
+ * @param payload payload of frame
+ * @param payloadLength length of frame payload excluding header and CRC
+ * @return IEEE802154_TX_SUCCESS if transmission was started, IEEE802154_TX_FRAME_TOO_LONG
+ * if nothing was written as the frame exceeds aMaxPHYPacketSize
+*/
+static uint8_t IEEE802154_writeFlowFrame(const IEEE802154_Flow_t *flow, uint8_t sequenceNumber, IEEE802154_PayloadPointer payload, uint8_t payloadLength)
+{
+  uint8_t status;
+  uint8_t i;
+
+  status = IEEE802154_frameLengthCheck(IEEE802154_FLOW_HEADER_LENGTH(flow), payloadLength);
+  if (status != IEEE802154_TX_SUCCESS)
+  {
+    return status;
+  }
+  IEEE802154_ISFLUSHTX();          /* Flush TX FIFO */
+
+  clearInterruptFlag(RFIRQF1, RFIRQF1_TXDONE);   /* Clear TX interrupt */
+
+  IEEE802154_RADIO_WRITE_TXFIFO(IEEE802154_FLOW_HEADER_LENGTH(flow) + payloadLength + IEEE802154_CRCLENGTH);
+  IEEE802154_STAT_INC(txFrames);
+  IEEE802154_STAT_ADD(txBytes, IEEE802154_FLOW_HEADER_LENGTH(flow) + payloadLength + IEEE802154_CRCLENGTH);
+#ifdef IEEE802154_ENABLE_SOFTWARE_CRC
+  IEEE802154_txFcs = IEEE802154_CRC16_INIT;   /* length byte is not covered by FCS */
+#endif
+  IEEE802154_RADIO_WRITE_TXFIFO(flow->header[0]);
+  IEEE802154_RADIO_WRITE_TXFIFO(flow->header[1]);
+  IEEE802154_RADIO_WRITE_TXFIFO(sequenceNumber);
+  /* loop bound is a constant if a flow shape is selected in Config.h */
+  for (i=IEEE802154_FRAME_HEADER_MIN; i<IEEE802154_FLOW_HEADER_LENGTH(flow); i++)
+  {
+    IEEE802154_RADIO_WRITE_TXFIFO(flow->header[i]);
+  }
+  IEEE802154_writePayload(payload, payloadLength, flow->header[0] & IEEE802154_FCF0_ACKNOWLEDGE_REQUIRED_MASK, sequenceNumber);
+  return IEEE802154_TX_SUCCESS;
+}
+
+/**
+ * Writes payload to TXFIFO after the header and starts transmission. With
+ * IEEE802154_ENABLE_DMA longer payloads are copied by DMA and transmission is started by
+ * IEEE802154_dmaISR() when the copy is complete.
+ * @param payload payload of frame
+ * @param payloadLength length of frame payload excluding header and CRC
+ * @param ackRequired non zero if frame requests an acknowledge
+ * @param sequenceNumber sequence number of frame
+*/
+static void IEEE802154_writePayload(const IEEE802154_Payload *payload, uint8_t payloadLength, uint8_t ackRequired, uint8_t sequenceNumber)
+{
+  uint8_t i;
+#ifdef IEEE802154_ENABLE_DMA
+  if (payloadLength >= IEEE802154_DMA_MIN_LENGTH)
+  {
+    IEEE802154_dmaTxAckRequired = ackRequired;
+    IEEE802154_dmaTxSequenceNumber = sequenceNumber;
+    IEEE802154_dmaTxPending = 1;
+    IEEE802154_RADIO_DMA_TO_TXFIFO(payload, payloadLength);
+    return;
+  }
+#endif
+  for (i=0; i<payloadLength; i++)
+  {
+    IEEE802154_RADIO_WRITE_TXFIFO(payload[i]);
+  }
+#ifdef IEEE802154_ENABLE_SOFTWARE_CRC
+  /* FCS is transmitted low byte first */
+  IEEE802154_RADIO_WRITE_RFD(LO_UINT16(IEEE802154_txFcs));
+  IEEE802154_RADIO_WRITE_RFD(HI_UINT16(IEEE802154_txFcs));
+#endif
+  IEEE802154_txStart(ackRequired, sequenceNumber);
+}
+
+/**
+ * Blocking send of data frame via radio.
+ * With IEEE802154_ENABLE_TX_QUEUE TXDONE is handled by the ISR, the frame is put into
+ * the transmit queue and the function waits until the queue is empty.
+ * @param header header of frame including pointer to payload
+ * @param payloadLength length of frame payload excluding header and CRC
+ * @return IEEE802154_TX_SUCCESS if frame was sent, otherwise reason why it was not sent:
+ * IEEE802154_TX_FRAME_TOO_LONG if header, payload and FCS exceed aMaxPHYPacketSize,
+ * IEEE802154_TX_INVALID_PARAMETER or the reason why it could not be secured. With
+ * IEEE802154_ENABLE_CSMA the result of the transmission is in IEEE802154_TxStatus, with
+ * IEEE802154_ENABLE_TX_QUEUE security failures are reported by
+ * IEEE802154_UserCbk_DataFrameSent().
+ * @note FCS is appended by AUTOCRC or, with IEEE802154_ENABLE_SOFTWARE_CRC, by the MAC
+*/
+uint8_t IEEE802154_radioSentDataFrame(IEEE802154_DataFrameHeader_t* header, uint8_t payloadLength)
+{
+  uint8_t status;
+#ifdef IEEE802154_ENABLE_STATISTICS
+  uint32_t start = IEEE802154_RADIO_CYCLES();
+#endif
+#ifdef IEEE802154_ENABLE_TX_QUEUE
+  status = IEEE802154_frameLengthCheck(IEEE802154_HEADER_LENGTH(header), payloadLength);
+  if (status != IEEE802154_TX_SUCCESS)
+  {
+    return status;
+  }
+  while (!IEEE802154_radioSentDataFrameAsync(header, payloadLength))
+  {
+    IEEE802154_RADIO_BUSY_WAIT();
+  }
+  while (IEEE802154_txQueuePending() > 0)
+  {
+    IEEE802154_RADIO_BUSY_WAIT();
+  }
+#else
+  status = IEEE802154_writeDataFrame(header, payloadLength);
+#ifdef IEEE802154_ENABLE_CSMA
+  if (status != IEEE802154_TX_SUCCESS)
+  {
+    /* frame was rejected or could not be secured and was not sent */
+    IEEE802154_TxStatus = status;
+  }
+  /* wait until acknowledged or given up, result in IEEE802154_TxStatus */
+  while (IEEE802154_TX_BUSY())
+  {
+    IEEE802154_RADIO_BUSY_WAIT();
+  }
+#else
+  // wait until transmission is finished
+  while ((status == IEEE802154_TX_SUCCESS) && ((RFIRQF1 & RFIRQF1_TXDONE) == 0))
+  {
+    IEEE802154_RADIO_BUSY_WAIT();
+  }
+  clearInterruptFlag(RFIRQF1, RFIRQF1_TXDONE);   // Clear TX interrupt
+#endif
+#endif
+  IEEE802154_STAT_CYCLES(txCycles, start);
+  return status;
+}
+
+#ifdef IEEE802154_ENABLE_SCATTER_GATHER
+/**
+ * Checks that header and segments fit into a frame and sums up the payload length.
+ * @param header header of frame
+ * @param segments payload of frame
+ * @param segmentCount number of segments
+ * @param payloadLength set to total length of segments
+ * @return status of IEEE802154_frameLengthCheck() for the total length
+*/
+static uint8_t IEEE802154_segmentsLength(const IEEE802154_DataFrameHeader_t* header, const IEEE802154_Segment_t *segments, uint8_t segmentCount, uint8_t *payloadLength)
+{
+  uint16_t length = 0;
+  uint8_t status;
+  uint8_t i;
+
+  for (i=0; i<segmentCount; i++)
+  {
+    length += segments[i].length;
+  }
+  status = IEEE802154_frameLengthCheck(IEEE802154_HEADER_LENGTH(header), length);
+  if (status == IEEE802154_TX_SUCCESS)
+  {
+    *payloadLength = (uint8_t)length;
+  }
+  return status;
+}
+
+/**
+ * Writes length byte, header and segments of data frame to TXFIFO and starts
+ * transmission. All but the last segment are written by the CPU, the last one is
+ * written like the payload of IEEE802154_writeDataFrame().
+ * @param header header of frame, header->payload is not used
+ * @param segments payload of frame
+ * @param segmentCount number of segments
+ * @return IEEE802154_TX_SUCCESS if transmission was started, otherwise reason why the
+ * frame could not be sent
+*/
+static uint8_t IEEE802154_writeDataFrameSegments(IEEE802154_DataFrameHeader_t* header, const IEEE802154_Segment_t *segments, uint8_t segmentCount)
+{
+  uint8_t payloadLength;
+  uint8_t status;
+  uint8_t i;
+#ifdef IEEE802154_ENABLE_SECURITY
+  IEEE802154_PayloadPointer payload;
+  IEEE802154_PayloadPointer gathered;
+#endif
+
+  status = IEEE802154_segmentsLength(header, segments, segmentCount, &payloadLength);
+  if (status != IEEE802154_TX_SUCCESS)
+  {
+    return status;
+  }
+#ifdef IEEE802154_ENABLE_SECURITY
+  if (header->fcf.securityEnabled)
+  {
+    /* CCM* works on the frame in RAM: gather payload at the end of IEEE802154_securedFrame,
+     * IEEE802154_securityOutgoingFrame() moves it forward behind the auxiliary security
+     * header. The header written in front of it is shorter than the space left, the
+     * auxiliary security header is only written once the length has been checked. */
+    gathered = &IEEE802154_securedFrame[sizeof(IEEE802154_securedFrame) - payloadLength];
+    payload = gathered;
+    for (; segmentCount > 0; segmentCount--, segments++)
+    {
+      for (i=0; i<segments->length; i++)
+      {
+        *payload++ = segments->data[i];
+      }
+    }
+    payload = header->payload;
+    header->payload = gathered;
+    status = IEEE802154_writeDataFrame(header, payloadLength);
+    header->payload = payload;
+    return status;
+  }
+#endif
+
+  IEEE802154_writeDataFrameHeader(header, payloadLength);
+  for (; segmentCount > 1; segmentCount--, segments++)
+  {
+    for (i=0; i<segments->length; i++)
+    {
+      IEEE802154_RADIO_WRITE_TXFIFO(segments->data[i]);
+    }
+  }
+  if (segmentCount == 0)
+  {
+    IEEE802154_writePayload(NULL, 0, header->fcf.ackRequired, header->sequenceNumber);
+  }
+  else
+  {
+    IEEE802154_writePayload(segments->data, segments->length, header->fcf.ackRequired, header->sequenceNumber);
+  }
+  return IEEE802154_TX_SUCCESS;
+}
+
+/**
+ * Blocking send of data frame with payload given as segments, behaves like
+ * IEEE802154_radioSentDataFrame(). Upper layers can pass their headers and data
+ * without copying them into one buffer first.
+ * @param header header of frame, header->payload is not used
+ * @param segments payload of frame, streamed to TXFIFO in order
+ * @param segmentCount number of segments
+ * @return IEEE802154_TX_SUCCESS if frame was sent, otherwise reason why it was not sent:
+ * IEEE802154_TX_FRAME_TOO_LONG if header, segments and FCS exceed aMaxPHYPacketSize,
+ * IEEE802154_TX_INVALID_PARAMETER or the reason why it could not be secured. With
+ * IEEE802154_ENABLE_CSMA the result of the transmission is in IEEE802154_TxStatus, with
+ * IEEE802154_ENABLE_TX_QUEUE security failures are reported by
+ * IEEE802154_UserCbk_DataFrameSent().
+*/
+uint8_t IEEE802154_radioSentDataFrameSegments(IEEE802154_DataFrameHeader_t* header, const IEEE802154_Segment_t *segments, uint8_t segmentCount)
+{
+  uint8_t status;
+#ifdef IEEE802154_ENABLE_STATISTICS
+  uint32_t start = IEEE802154_RADIO_CYCLES();
+#endif
+#ifdef IEEE802154_ENABLE_TX_QUEUE
+  uint8_t payloadLength;
+
+  status = IEEE802154_segmentsLength(header, segments, segmentCount, &payloadLength);
+  if (status != IEEE802154_TX_SUCCESS)
+  {
+    return status;
+  }
+  while (!IEEE802154_radioSentDataFrameSegmentsAsync(header, segments, segmentCount))
+  {
+    IEEE802154_RADIO_BUSY_WAIT();
+  }
+  while (IEEE802154_txQueuePending() > 0)
+  {
+    IEEE802154_RADIO_BUSY_WAIT();
+  }
+#else
+  status = IEEE802154_writeDataFrameSegments(header, segments, segmentCount);
+#ifdef IEEE802154_ENABLE_CSMA
+  if (status != IEEE802154_TX_SUCCESS)
+  {
+    IEEE802154_TxStatus = status;
+  }
+  while (IEEE802154_TX_BUSY())
+  {
+    IEEE802154_RADIO_BUSY_WAIT();
+  }
+#else
+  while ((status == IEEE802154_TX_SUCCESS) && ((RFIRQF1 & RFIRQF1_TXDONE) == 0))
+  {
+    IEEE802154_RADIO_BUSY_WAIT();
+  }
+  clearInterruptFlag(RFIRQF1, RFIRQF1_TXDONE);
+#endif
+#endif
+  IEEE802154_STAT_CYCLES(txCycles, start);
+  return status;
+}
+
+#ifndef IEEE802154_ENABLE_RX_QUEUE
+/**
+ * Sets segments the RF ISR reads the payload of received data frames into, in order.
+ * Data frames with a longer payload are dropped. The segments are filled when
+ * IEEE802154_UserCbk_DataFrameReceived() is called and overwritten by the next data
+ * frame. Other frame types and secured frames still use IEEE802154_RxDataFrame.payload.
+ * @param segments receive segments, must stay valid until replaced, NULL to receive
+ * into IEEE802154_RxDataFrame.payload again
+ * @param segmentCount number of segments
+*/
+void IEEE802154_radioSetRxSegments(const IEEE802154_Segment_t *segments, uint8_t segmentCount)
+{
+  uint16_t capacity = 0;
+  uint8_t saved;
+  uint8_t i;
+
+  for (i=0; i<segmentCount; i++)
+  {
+    capacity += segments[i].length;
+  }
+  /* RF and DMA ISR must not see segments and capacity of different lists */
+  IEEE802154_CRITICAL_ENTER(saved);
+  IEEE802154_rxSegments = (segmentCount != 0) ? segments : NULL;
+  IEEE802154_rxSegmentsCapacity = capacity;
+  IEEE802154_CRITICAL_EXIT(saved);
+}
+#endif
+#endif
+
+/**
+ * Blocking send of next frame of a prepared flow. Behaves like
+ * IEEE802154_radioSentDataFrame() but the header is taken from the flow template.
+ * A frame exceeding aMaxPHYPacketSize is not sent and does not use up a sequence number,
+ * with IEEE802154_ENABLE_CSMA IEEE802154_TxStatus is set to IEEE802154_TX_FRAME_TOO_LONG.
+ * @param flow flow set up by IEEE802154_flowPrepare()
+ * @param payload payload of frame
+ * @param payloadLength length of frame payload excluding header and CRC
+ * @return sequence number used for the frame
+*/
+uint8_t IEEE802154_flowSent(IEEE802154_Flow_t *flow, IEEE802154_PayloadPointer payload, uint8_t payloadLength)
+{
+  uint8_t sequenceNumber = flow->sequenceNumber;
+#ifdef IEEE802154_ENABLE_STATISTICS
+  uint32_t start = IEEE802154_RADIO_CYCLES();
+#endif
+
+  if (IEEE802154_frameLengthCheck(IEEE802154_FLOW_HEADER_LENGTH(flow), payloadLength) != IEEE802154_TX_SUCCESS)
+  {
+#ifdef IEEE802154_ENABLE_CSMA
+    IEEE802154_TxStatus = IEEE802154_TX_FRAME_TOO_LONG;
+#endif
+    return sequenceNumber;
+  }
+#ifdef IEEE802154_ENABLE_TX_QUEUE
+  while (!IEEE802154_flowSentAsync(flow, payload, payloadLength))
+  {
+    IEEE802154_RADIO_BUSY_WAIT();
+  }
+  while (IEEE802154_txQueuePending() > 0)
+  {
+    IEEE802154_RADIO_BUSY_WAIT();
+  }
+#else
+  flow->sequenceNumber++;
+  (void)IEEE802154_writeFlowFrame(flow, sequenceNumber, payload, payloadLength);   /* length checked above */
+#ifdef IEEE802154_ENABLE_CSMA
+  while (IEEE802154_TX_BUSY())
+  {
+    IEEE802154_RADIO_BUSY_WAIT();
+  }
+#else
+  while ((RFIRQF1 & RFIRQF1_TXDONE) == 0)
+  {
+    IEEE802154_RADIO_BUSY_WAIT();
+  }
+  clearInterruptFlag(RFIRQF1, RFIRQF1_TXDONE);
+#endif
+#endif
+  IEEE802154_STAT_CYCLES(txCycles, start);
+  return sequenceNumber;
+}
+
+#ifdef IEEE802154_ENABLE_TX_QUEUE
+/**
+ * Writes frame of transmit queue entry to TXFIFO and starts transmission.
+*/
+static void IEEE802154_writeQueueEntry(const IEEE802154_TxQueueEntry_t *entry)
+{
+  IEEE802154_DataFrameHeader_t *header = entry->header;
+  uint8_t status;
+  if (header != NULL)
+  {
+#ifdef IEEE802154_ENABLE_INDIRECT_QUEUE
+    if (entry->framePending)
+    {
+      /* header belongs to the application, frame pending is set in a copy */
+      IEEE802154_txHeader = *header;
+      IEEE802154_txHeader.fcf.framePending = 1;
+      header = &IEEE802154_txHeader;
+    }
+#endif
+#ifdef IEEE802154_ENABLE_SCATTER_GATHER
+    if (entry->segments != NULL)
+    {
+      status = IEEE802154_writeDataFrameSegments(header, entry->segments, entry->segmentCount);
+    }
+    else
+#endif
+    status = IEEE802154_writeDataFrame(header, entry->payloadLength);
+#if defined(IEEE802154_ENABLE_INDIRECT_QUEUE) && defined(IEEE802154_ENABLE_SECURITY)
+    if (header != entry->header)
+    {
+      /* frame counter used is reported in the header like for other secured frames */
+      entry->header->auxSecurityHeader.frameCounter = header->auxSecurityHeader.frameCounter;
+    }
+#endif
+  }
+  else
+  {
+    status = IEEE802154_writeFlowFrame(entry->flow, entry->sequenceNumber, entry->payload, entry->payloadLength);
+  }
+  if (status != IEEE802154_TX_SUCCESS)
+  {
+    /* frame was not sent, report it and go on with the next one */
+    IEEE802154_txComplete(status);
+  }
+}
+
+/**
+ * Returns the entry of the transmit queue to be filled next. The RF ISR also queues
+ * frames (indirect transmission), callers hold the MAC critical section from here
+ * until the entry is published or given up.
+ * @return free entry, NULL if queue is full
+*/
+static IEEE802154_TxQueueEntry_t* IEEE802154_txQueueReserve(void)
+{
+  if ((uint8_t)(IEEE802154_txQueueHead - IEEE802154_txQueueTail) >= IEEE802154_TX_QUEUE_SIZE)
+  {
+    return NULL;
+  }
+  return &IEEE802154_txQueue[IEEE802154_txQueueHead & (IEEE802154_TX_QUEUE_SIZE - 1)];
+}
+
+/**
+ * Appends a filled entry to the transmit queue and starts transmission if radio is idle.
+ * @return 1 if frame was queued, 0 if queue is full
+*/
+static uint8_t IEEE802154_txQueueAdd(IEEE802154_DataFrameHeader_t* header, IEEE802154_Flow_t *flow, IEEE802154_PayloadPointer payload, uint8_t payloadLength)
+{
+  IEEE802154_TxQueueEntry_t *entry;
+  uint8_t saved;
+
+  IEEE802154_CRITICAL_ENTER(saved);
+  entry = IEEE802154_txQueueReserve();
+  if (entry == NULL)
+  {
+    IEEE802154_CRITICAL_EXIT(saved);
+    return 0;
+  }
+  entry->header = header;
+  entry->flow = flow;
+  entry->payload = payload;
+  entry->payloadLength = payloadLength;
+  if (flow != NULL)
+  {
+    entry->sequenceNumber = flow->sequenceNumber++;
+  }
+#ifdef IEEE802154_ENABLE_SCATTER_GATHER
+  entry->segments = NULL;
+#endif
+#ifdef IEEE802154_ENABLE_INDIRECT_QUEUE
+  entry->framePending = 0;
+#endif
+  IEEE802154_txQueuePublish(entry);
+  IEEE802154_CRITICAL_EXIT(saved);
+  return 1;
+}
+
+/**
+ * Publishes an entry returned by IEEE802154_txQueueReserve() and starts transmission if
+ * radio is idle.
+*/
+static void IEEE802154_txQueuePublish(IEEE802154_TxQueueEntry_t *entry)
+{
+  uint8_t saved;
+  /* MAC interrupts are masked while publishing the entry, the RF, MAC timer and DMA ISR
+   * all complete frames. Otherwise an ISR could find the queue empty after the last
+   * completion while this function still sees a frame in flight and nobody would start
+   * the new one, or start the new entry which is then written a second time here. */
+  IEEE802154_CRITICAL_ENTER(saved);
+  IEEE802154_txQueueHead++;
+  if ((uint8_t)(IEEE802154_txQueueHead - IEEE802154_txQueueTail) == 1)
+  {
+    /* radio idle, start right away */
+    IEEE802154_writeQueueEntry(entry);
+  }
+  IEEE802154_CRITICAL_EXIT(saved);
+}
+
+/**
+ * Non-blocking send of data frame via radio. The frame is appended to the transmit
+ * queue and sent as soon as all frames queued before are sent. Completion is reported
+ * by IEEE802154_UserCbk_DataFrameSent() from RF ISR. Header and payload are not copied
+ * and must stay valid until then. A frame exceeding aMaxPHYPacketSize is not written to
+ * TXFIFO and reported with IEEE802154_TX_FRAME_TOO_LONG.
+ * @param header header of frame including pointer to payload
+ * @param payloadLength length of frame payload excluding header and CRC
+ * @return 1 if frame was queued, 0 if queue is full
+*/
+uint8_t IEEE802154_radioSentDataFrameAsync(IEEE802154_DataFrameHeader_t* header, uint8_t payloadLength)
+{
+  return IEEE802154_txQueueAdd(header, NULL, NULL, payloadLength);
+}
+
+/**
+ * Non-blocking send of next frame of a prepared flow, see IEEE802154_radioSentDataFrameAsync().
+ * Completion is reported by IEEE802154_UserCbk_FlowFrameSent() from RF ISR, a frame
+ * exceeding aMaxPHYPacketSize with IEEE802154_TX_FRAME_TOO_LONG.
+ * @param flow flow set up by IEEE802154_flowPrepare()
+ * @param payload payload of frame, must stay valid until frame is sent
+ * @param payloadLength length of frame payload excluding header and CRC
+ * @return 1 if frame was queued, 0 if queue is full
+*/
+uint8_t IEEE802154_flowSentAsync(IEEE802154_Flow_t *flow, IEEE802154_PayloadPointer payload, uint8_t payloadLength)
+{
+  return IEEE802154_txQueueAdd(NULL, flow, payload, payloadLength);
+}
+
+#ifdef IEEE802154_ENABLE_SCATTER_GATHER
+/**
+ * Non-blocking send of data frame with payload given as segments, see
+ * IEEE802154_radioSentDataFrameAsync(). A frame exceeding aMaxPHYPacketSize is reported by
+ * IEEE802154_UserCbk_DataFrameSent() with IEEE802154_TX_FRAME_TOO_LONG.
+ * @param header header of frame, header->payload is not used
+ * @param segments payload of frame, list and data must stay valid until frame is sent
+ * @param segmentCount number of segments
+ * @return 1 if frame was queued, 0 if queue is full
+*/
+uint8_t IEEE802154_radioSentDataFrameSegmentsAsync(IEEE802154_DataFrameHeader_t* header, const IEEE802154_Segment_t *segments, uint8_t segmentCount)
+{
+  IEEE802154_TxQueueEntry_t *entry;
+  uint8_t saved;
+
+  IEEE802154_CRITICAL_ENTER(saved);
+  entry = IEEE802154_txQueueReserve();
+  if (entry == NULL)
+  {
+    IEEE802154_CRITICAL_EXIT(saved);
+    return 0;
+  }
+  entry->header = header;
+  entry->flow = NULL;
+  entry->payloadLength = 0;             /* without segments sent as frame without payload */
+  entry->segments = segments;
+  entry->segmentCount = segmentCount;
+#ifdef IEEE802154_ENABLE_INDIRECT_QUEUE
+  entry->framePending = 0;
+#endif
+  IEEE802154_txQueuePublish(entry);
+  IEEE802154_CRITICAL_EXIT(saved);
+  return 1;
+}
+#endif
+
+#ifdef IEEE802154_ENABLE_INDIRECT_QUEUE
+/**
+ * Non-blocking send of a frame of the indirect transmission pool, see
+ * IEEE802154_radioSentDataFrameAsync(). Called by the ISR receiving the data request, the
+ * header is not modified.
+ * @param header header of frame including pointer to payload
+ * @param payloadLength length of frame payload excluding header and CRC
+ * @param framePending non zero to send the frame with frame pending set
+ * @return 1 if frame was queued, 0 if queue is full
+*/
+uint8_t IEEE802154_radioSentIndirectFrameAsync(IEEE802154_DataFrameHeader_t* header, uint8_t payloadLength, uint8_t framePending)
+{
+  IEEE802154_TxQueueEntry_t *entry;
+  uint8_t saved;
+
+  IEEE802154_CRITICAL_ENTER(saved);
+  entry = IEEE802154_txQueueReserve();
+  if (entry == NULL)
+  {
+    IEEE802154_CRITICAL_EXIT(saved);
+    return 0;
+  }
+  entry->header = header;
+  entry->flow = NULL;
+  entry->payload = NULL;
+  entry->payloadLength = payloadLength;
+#ifdef IEEE802154_ENABLE_SCATTER_GATHER
+  entry->segments = NULL;
+#endif
+  entry->framePending = framePending;
+  IEEE802154_txQueuePublish(entry);
+  IEEE802154_CRITICAL_EXIT(saved);
+  return 1;
+}
+#endif
+
+/**
+ * Number of frames in transmit queue including the one currently sent.
+ */
+uint8_t IEEE802154_txQueuePending(void)
+{
+  return (uint8_t)(IEEE802154_txQueueHead - IEEE802154_txQueueTail);
+}
+#endif
+
+/**
+ * Starts transmission of the frame in TXFIFO. With IEEE802154_ENABLE_CSMA the frame
+ * is sent by the CSMA-CA engine after a random backoff and retransmitted until it is
+ * acknowledged, otherwise it is sent immediately.
+ * @param ackRequired non zero if frame requests an acknowledge
+ * @param sequenceNumber sequence number of frame, used to match the acknowledge
+*/
+static void IEEE802154_txStart(uint8_t ackRequired, uint8_t sequenceNumber)
+{
+#ifdef IEEE802154_ENABLE_CSMA
+  IEEE802154_csmaAckRequired = ackRequired;
+  IEEE802154_csmaSequenceNumber = sequenceNumber;
+  IEEE802154_csmaRetries = 0;
+  IEEE802154_csmaNB = 0;
+  IEEE802154_csmaBE = IEEE802154_CsmaConfig.minBE;
+  IEEE802154_csmaBackoff();
+#else
+  (void)ackRequired;
+  (void)sequenceNumber;
+  // Enable TX after calibration
+  IEEE802154_ISTXON();
+#endif
+}
+
+#if defined(IEEE802154_ENABLE_TX_QUEUE) || defined(IEEE802154_ENABLE_CSMA)
+/**
+ * Called from interrupt context when the transmission started by IEEE802154_txStart()
+ * is finished. Reports the result and starts the next queued frame.
+ * @param status IEEE802154_TX_SUCCESS or reason of failure
+*/
+static void IEEE802154_txComplete(uint8_t status)
+{
+#ifdef IEEE802154_ENABLE_CSMA
+  IEEE802154_TxStatus = status;
+#endif
+#ifdef IEEE802154_ENABLE_TX_QUEUE
+  IEEE802154_TxQueueEntry_t *entry = &IEEE802154_txQueue[IEEE802154_txQueueTail & (IEEE802154_TX_QUEUE_SIZE - 1)];
+  IEEE802154_txQueueTail++;
+  if (entry->header != NULL)
+  {
+    IEEE802154_UserCbk_DataFrameSent(entry->header, status);
+  }
+  else
+  {
+    IEEE802154_UserCbk_FlowFrameSent(entry->flow, entry->sequenceNumber, status);
+  }
+  if (IEEE802154_txQueueHead != IEEE802154_txQueueTail)
+  {
+    /* send next frame back-to-back */
+    IEEE802154_writeQueueEntry(&IEEE802154_txQueue[IEEE802154_txQueueTail & (IEEE802154_TX_QUEUE_SIZE - 1)]);
+  }
+#else
+  (void)status;
+#endif
+}
+#endif
+
+#ifdef IEEE802154_ENABLE_CSMA
+/**
+ * 16 bit Galois LFSR used to randomize backoff periods.
+*/
+static uint8_t IEEE802154_nextRandom(void)
+{
+  uint8_t i;
+  for (i=0; i<8; i++)
+  {
+    if (IEEE802154_random & 0x0001)
+    {
+      IEEE802154_random = (IEEE802154_random >> 1) ^ IEEE802154_RANDOM_POLYNOMIAL;
+    }
+    else
+    {
+      IEEE802154_random >>= 1;
+    }
+  }
+  return (uint8_t)IEEE802154_random;
+}
+
+/**
+ * Waits a random number of 0 to 2^BE - 1 backoff periods before the next CCA, see
+ * 802.15.4-2006 Chapter "7.5.1.4 CSMA-CA algorithm".
+*/
+static void IEEE802154_csmaBackoff(void)
+{
+  /* CCA is done on the timer tick after the delay, thus one period more */
+  IEEE802154_csmaTimer = (IEEE802154_nextRandom() & (uint8_t)((1 << IEEE802154_csmaBE) - 1)) + 1;
+  IEEE802154_csmaState = IEEE802154_CSMA_STATE_BACKOFF;
+}
+
+/**
+ * Advances the CSMA-CA engine by one backoff period. Does CCA with ISTXONCCA when the
+ * backoff has expired and retransmits the frame still loaded in TXFIFO if no matching
+ * acknowledge arrived within the ACK wait duration.
+*/
+static void IEEE802154_csmaTick(void)
+{
+  if ((IEEE802154_csmaState == IEEE802154_CSMA_STATE_IDLE) || (IEEE802154_csmaState == IEEE802154_CSMA_STATE_TX))
+  {
+    return;
+  }
+  if (--IEEE802154_csmaTimer != 0)
+  {
+    return;
+  }
+  if (IEEE802154_csmaState == IEEE802154_CSMA_STATE_BACKOFF)
+  {
+    /* radio samples CCA and only starts TX if channel is clear */
+    IEEE802154_ISTXONCCA();
+    if (FSMSTAT1 & FSMSTAT1_SAMPLED_CCA)
+    {
+      IEEE802154_csmaState = IEEE802154_CSMA_STATE_TX;
+      return;
+    }
+    IEEE802154_csmaNB++;
+    if (IEEE802154_csmaBE < IEEE802154_CsmaConfig.maxBE)
+    {
+      IEEE802154_csmaBE++;
+    }
+    if (IEEE802154_csmaNB > IEEE802154_CsmaConfig.maxCsmaBackoffs)
+    {
+      IEEE802154_csmaState = IEEE802154_CSMA_STATE_IDLE;
+      IEEE802154_STAT_INC(txChannelAccessFailures);
+      IEEE802154_txComplete(IEEE802154_TX_CHANNEL_ACCESS_FAILURE);
+      return;
+    }
+    IEEE802154_csmaBackoff();
+  }
+  else
+  {
+    /* no acknowledge within ACK wait duration */
+    if (IEEE802154_csmaRetries >= IEEE802154_CsmaConfig.maxFrameRetries)
+    {
+      IEEE802154_csmaState = IEEE802154_CSMA_STATE_IDLE;
+      IEEE802154_STAT_INC(txNoAck);
+      IEEE802154_txComplete(IEEE802154_TX_NO_ACK);
+      return;
+    }
+    /* TXFIFO still holds the frame, see IEEE802154_retransmit() */
+    IEEE802154_csmaRetries++;
+    IEEE802154_STAT_INC(txRetries);
+    IEEE802154_csmaNB = 0;
+    IEEE802154_csmaBE = IEEE802154_CsmaConfig.minBE;
+    IEEE802154_csmaBackoff();
+  }
+}
+
+/**
+ * ISR for MAC timer (Timer 2). The timer overflows once per backoff period and drives
+ * the CSMA-CA engine. Must have the same interrupt priority as the RF ISR as both
+ * modify the engine state.
+*/
+#ifndef IEEE802154_SIMULATION
+#pragma vector = T2_VECTOR
+#endif
+IEEE802154_RADIO_ISR_ATTRIBUTES void IEEE802154_macTimerISR(void)
+{
+  if (T2IRQF & T2IRQF_TIMER2_PERF)
+  {
+    clearInterruptFlag(T2IRQF, T2IRQF_TIMER2_PERF);
+    IEEE802154_csmaTick();
+  }
+  /* clear CPU interrupt flag T2IF */
+  clearInterruptFlag(IRCON, IRCON_T2IF);
+}
+#endif
+
+#ifdef IEEE802154_ENABLE_DMA
+/**
+ * ISR for DMA. Starts transmission once the payload has been copied to TXFIFO by
+ * IEEE802154_writePayload(). Finishes the received frame once its payload has been
+ * copied out of RXFIFO by IEEE802154_readPayload() and handles the frames received
+ * meanwhile.
+*/
+#ifndef IEEE802154_SIMULATION
+#pragma vector = DMA_VECTOR
+#endif
+IEEE802154_RADIO_ISR_ATTRIBUTES void IEEE802154_dmaISR(void)
+{
+  /* clear CPU interrupt flag DMAIF first, channel flags are checked afterwards */
+  clearInterruptFlag(IRCON, IRCON_DMAIF);
+  if (DMAIRQ & IEEE802154_DMA_TX_MASK)
+  {
+    clearInterruptFlag(DMAIRQ, IEEE802154_DMA_TX_MASK);
+    IEEE802154_dmaTxPending = 0;
+    IEEE802154_txStart(IEEE802154_dmaTxAckRequired, IEEE802154_dmaTxSequenceNumber);
+  }
+  if (DMAIRQ & IEEE802154_DMA_RX_MASK)
+  {
+    clearInterruptFlag(DMAIRQ, IEEE802154_DMA_RX_MASK);
+    IEEE802154_dmaRxPending = 0;
+    IEEE802154_receiveFrameEnd();
+#ifdef IEEE802154_ENABLE_RX_DRAIN
+    IEEE802154_rxFifoDrain();
+#else
+    IEEE802154_rxFifoFlush();
+#endif
+  }
+}
+#endif
+
+#ifdef IEEE802154_ENABLE_STATISTICS
+/**
+ * Adds a measured duration to a cycle statistic.
+ * @param stat statistic to update
+ * @param cycles duration in cycles
+*/
+static void IEEE802154_statisticsCycles(IEEE802154_CycleStatistics_t *stat, uint32_t cycles)
+{
+  if (cycles < stat->min)
+  {
+    stat->min = cycles;
+  }
+  if (cycles > stat->max)
+  {
+    stat->max = cycles;
+  }
+  if ((stat->total > (uint32_t)0xFFFFFFFFUL - cycles) || (stat->count == 0xFFFF))
+  {
+    /* keep the average, weight of older measurements is halved */
+    stat->total >>= 1;
+    stat->count >>= 1;
+  }
+  stat->total += cycles;
+  stat->count++;
+}
+
+/**
+ * Copies the statistics consistently, counters updated by the RF, MAC timer and DMA
+ * ISR are not changed while they are copied.
+ * @param snapshot copy of the statistics
+*/
+void IEEE802154_statisticsSnapshot(IEEE802154_Statistics_t *snapshot)
+{
+  uint8_t saved;
+  IEEE802154_CRITICAL_ENTER(saved);
+  *snapshot = IEEE802154_statistics;
+  IEEE802154_CRITICAL_EXIT(saved);
+}
+
+/**
+ * Clears all counters and cycle statistics.
+*/
+void IEEE802154_statisticsReset(void)
+{
+  IEEE802154_Statistics_t *stat = &IEEE802154_statistics;
+  uint8_t saved;
+  uint8_t i;
+  IEEE802154_CRITICAL_ENTER(saved);
+  for (i=0; i<sizeof(IEEE802154_Statistics_t); i++)
+  {
+    ((uint8_t*)stat)[i] = 0;
+  }
+  stat->isrCycles.min = (uint32_t)0xFFFFFFFFUL;
+  stat->txCycles.min = (uint32_t)0xFFFFFFFFUL;
+  IEEE802154_CRITICAL_EXIT(saved);
+}
+#endif
+
+/**
+ * Moves the radio to another channel without re-initialization. Only the frequency
+ * synthesizer is retuned, it is calibrated by ISRXON. A frame in reception is lost, a
+ * frame in transmission must be completed by the caller before.
+ * @param channel 11 to 26
+ * @return 1 on success, 0 if channel is invalid
+*/
+uint8_t IEEE802154_radioSetChannel(uint8_t channel)
+{
+  if ((channel < IEEE802154_CHANNEL_FIRST) || (channel > IEEE802154_CHANNEL_LAST))
+  {
+    return 0;
+  }
+  IEEE802154_ISRFOFF();
+  FREQCTRL = FREQCTRL_CHANNEL(channel);
+  IEEE802154_channel = channel;
+  IEEE802154_ISFLUSHRX();
+  IEEE802154_ISRXON();
+  return 1;
+}
+
+/**
+ * @return channel radio is tuned to
+*/
+uint8_t IEEE802154_radioGetChannel(void)
+{
+  return IEEE802154_channel;
+}
+
+#ifdef IEEE802154_ENABLE_ED_SCAN
+/**
+ * Energy detection scan. Each channel is measured for the dwell time, afterwards the
+ * radio is tuned back to the channel used before. Frames received during the scan are
+ * handled as usual.
+ * @param channels bit n set to scan channel n, e.g. IEEE802154_CHANNEL_MASK_ALL
+ * @param dwell measurement time per channel in backoff periods, at least 1
+ * @param mode FRMCTRL0_ENERGY_SCAN_PEAK for the peak RSSI during the dwell time,
+ * FRMCTRL0_ENERGY_SCAN_RECENT for the maximum of the RSSI samples read by the CPU
+ * @param report measured energy per channel
+ * @return scanned channel with lowest energy, 0 if no valid channel was given
+*/
+uint8_t IEEE802154_edScan(uint32_t channels, uint8_t dwell, uint8_t mode, IEEE802154_EdScanReport_t *report)
+{
+  uint8_t channel;
+  uint8_t quietest = 0;
+  sint8_t energy;
+  sint8_t sample;
+  IEEE802154_Timestamp_t start;
+  uint8_t previous = IEEE802154_channel;
+
+  report->scannedChannels = 0;
+  FRMCTRL0 = (FRMCTRL0 & (uint8_t)~FRMCTRL0_ENERGY_SCAN_PEAK) | mode;
+  for (channel=IEEE802154_CHANNEL_FIRST; channel<=IEEE802154_CHANNEL_LAST; channel++)
+  {
+    if ((channels & ((uint32_t)1 << channel)) == 0)
+    {
+      continue;
+    }
+    /* entering RX resets the peak value */
+    IEEE802154_radioSetChannel(channel);
+    while ((RSSISTAT & RSSISTAT_RSSI_VALID) == 0)
+    {
+      IEEE802154_RADIO_BUSY_WAIT();
+    }
+    energy = (sint8_t)RSSI;
+    start = IEEE802154_RADIO_TIMESTAMP();
+    while ((IEEE802154_Timestamp_t)(IEEE802154_RADIO_TIMESTAMP() - start) < dwell)
+    {
+      sample = (sint8_t)RSSI;
+      if (sample > energy)
+      {
+        energy = sample;
+      }
+      IEEE802154_RADIO_BUSY_WAIT();
+    }
+    /* with ENERGY_SCAN_PEAK the register holds the peak of the whole dwell time */
+    sample = (sint8_t)RSSI;
+    if (sample > energy)
+    {
+      energy = sample;
+    }
+    report->energy[channel - IEEE802154_CHANNEL_FIRST] = energy;
+    report->scannedChannels |= (uint32_t)1 << channel;
+    if ((quietest == 0) || (energy < report->energy[quietest - IEEE802154_CHANNEL_FIRST]))
+    {
+      quietest = channel;
+    }
+  }
+  FRMCTRL0 &= (uint8_t)~FRMCTRL0_ENERGY_SCAN_PEAK;
+  IEEE802154_radioSetChannel(previous);
+  return quietest;
+}
+#endif
+
+/** Retransmission of the last frame sent (i.e. in case no ack was received).
+ * See Chapter 23.8.4 Retransmission "After a frame has been successfully transmitted, 
+ * the FIFO contents are left unchanged. To retransmit the same frame, simply restart 
+ * TX by issuing an STXON or STXONCCA command strobe. Note that a retransmission of a 
+ * packet is only possible if the packet has been completely transmitted; i.e., a 
+ * packet cannot be aborted and then be retransmitted." */
+void IEEE802154_retransmit()
+{
+  // Enable TX after calibration
+  IEEE802154_ISTXON();
+}
+
+#ifdef IEEE802154_ENABLE_RX_QUEUE
+/**
+ * Number of received frames waiting in the receive queue. To be called from application
+ * context only (single consumer).
+ */
+uint8_t IEEE802154_rxQueuePoll(void)
+{
+  return (uint8_t)(IEEE802154_rxQueueHead - IEEE802154_rxQueueTail);
+}
+
+/**
+ * Oldest received frame in the receive queue. The slot stays owned by the application
+ * and is not overwritten by the ISR until IEEE802154_rxQueueRelease() is called.
+ * @return pointer to slot or NULL if queue is empty
+ */
+IEEE802154_RxQueueSlot_t* IEEE802154_rxQueuePeek(void)
+{
+  if (IEEE802154_rxQueueHead == IEEE802154_rxQueueTail)
+  {
+    return NULL;
+  }
+  return &IEEE802154_rxQueue[IEEE802154_rxQueueTail & (IEEE802154_RX_QUEUE_SIZE - 1)];
+}
+
+/**
+ * Hands the oldest slot returned by IEEE802154_rxQueuePeek() back to the ISR.
+ */
+void IEEE802154_rxQueueRelease(void)
+{
+  if (IEEE802154_rxQueueHead != IEEE802154_rxQueueTail)
+  {
+    IEEE802154_rxQueueTail++;
+  }
+}
+#endif
 /** @}*/
\ No newline at end of file
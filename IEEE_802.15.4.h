@@ -21,6 +21,16 @@
 */
 #define IEEE802154_ACK_PACKET_SIZE              (uint8_t)0x03 + IEEE802154_CRCLENGTH
 
+/**
+ * Smallest MAC header: 2 bytes frame control field and 1 byte sequence number
+*/
+#define IEEE802154_FRAME_HEADER_MIN             (uint8_t)0x03
+
+/**
+ * Maximum PHY packet size (aMaxPHYPacketSize) according to 802.15.4 "6.4.1 PHY constants"
+*/
+#define IEEE802154_MAX_PHY_PACKET_SIZE          (uint8_t)127
+
 /**
  * Selected strobes for IEEE 802.15.4. See swru191d.pdf Chapter 23.14 Command 
  * Strobe/CSMA-CA Processor. Quote: "The CSP interfaces with the CPU through the 
@@ -30,32 +40,40 @@
  * Timer by observing MAC Timer events."
  * For an explanation see swru191d.pdf Chapter 23.14.8 Instruction Set Summary and
  * Chapter 23.14.9 23.14.9 Instruction Set Definition
+* The strobes are issued via IEEE802154_RADIO_STROBE() of the radio backend, see
+ * IEEE_802.15.4_Radio.h.
 */
+#define IEEE802154_CSP_ISRXON                   (uint8_t)0xE3
+#define IEEE802154_CSP_ISTXON                   (uint8_t)0xE9
+#define IEEE802154_CSP_ISTXONCCA                (uint8_t)0xEA
+#define IEEE802154_CSP_ISRFOFF                  (uint8_t)0xEF
+#define IEEE802154_CSP_ISFLUSHRX                (uint8_t)0xED  /* was EC?? */
+#define IEEE802154_CSP_ISFLUSHTX                (uint8_t)0xEE
 /**
  * The ISRXON instruction immediately enables and calibrates the frequency synthesizer for RX.
 */
-#define IEEE802154_ISRXON()                     RFST = 0xE3
+#define IEEE802154_ISRXON()                     IEEE802154_RADIO_STROBE(IEEE802154_CSP_ISRXON)
 /**
  * The ISTXON instruction immediately enables TX after calibration. The instruction waits
  * for the radio to acknowledge the command before executing the next instruction.
 */
-#define IEEE802154_ISTXON()                     RFST = 0xE9
+#define IEEE802154_ISTXON()                     IEEE802154_RADIO_STROBE(IEEE802154_CSP_ISTXON)
 /**
  * The ISTXONCCA instruction immediately enables TX after calibration if CCA indicates a clear channel.
 */
-#define IEEE802154_ISTXONCCA()                  RFST = 0xEA
+#define IEEE802154_ISTXONCCA()                  IEEE802154_RADIO_STROBE(IEEE802154_CSP_ISTXONCCA)
 /**
  * The ISRFOFF instruction immediately disables RX/TX and the frequency synthesizer.
 */
-#define IEEE802154_ISRFOFF()                    RFST = 0xEF
+#define IEEE802154_ISRFOFF()                    IEEE802154_RADIO_STROBE(IEEE802154_CSP_ISRFOFF)
 /**
  * The ISFLUSHRX instruction immediately flushes the RXFIFO buffer and resets the demodulator 
 */
-#define IEEE802154_ISFLUSHRX()                  RFST = 0xED  /* was EC?? */
+#define IEEE802154_ISFLUSHRX()                  IEEE802154_RADIO_STROBE(IEEE802154_CSP_ISFLUSHRX)
 /**
 * The ISFLUSHTX instruction immediately flushes the TXFIFO buffer.
 */
-#define IEEE802154_ISFLUSHTX()                  RFST = 0xEE
+#define IEEE802154_ISFLUSHTX()                  IEEE802154_RADIO_STROBE(IEEE802154_CSP_ISFLUSHTX)
 
 /**
  * For detailed explenation see 802.15.4-2006 Chapter "7.2.1.1 Frame Control field"
@@ -84,6 +102,38 @@
 #define IEEE802154_FCF_ADDRESS_MODE_64BIT           0x03
 /* frame version 2 bit 12:13 */
 
+/**
+ * Frame control field as transmitted: byte 0 holds bit 0:7, byte 1 holds bit 8:15
+*/
+#define IEEE802154_FCF0_FRAME_TYPE_MASK             0x07
+#define IEEE802154_FCF0_ACKNOWLEDGE_REQUIRED_MASK   0x20
+#define IEEE802154_FCF0_PANIDCOMPRESSION_MASK       0x40
+#define IEEE802154_FCF1_DESTINATION_MODE_SHIFT      2
+#define IEEE802154_FCF1_SOURCE_MODE_SHIFT           6
+#define IEEE802154_FCF1_ADDRESS_MODE_MASK           0x03
+
+/**
+ * Index into #IEEE802154_frameLayout for the two bytes of a frame control field
+*/
+#define IEEE802154_FRAME_LAYOUT_INDEX(fcf0, fcf1)   ((((fcf1) >> IEEE802154_FCF1_DESTINATION_MODE_SHIFT) & 0x03) | \
+                                                     (((fcf1) >> (IEEE802154_FCF1_SOURCE_MODE_SHIFT - 2)) & 0x0C) | \
+                                                     (((fcf0) & IEEE802154_FCF0_PANIDCOMPRESSION_MASK) >> 2))
+
+/**
+ * Multi byte fields are transmitted little endian (802.15.4-2006 Chapter "7.2 MAC frame formats")
+*/
+#define IEEE802154_GET_UINT16(ptr)                  (uint16_t)((uint16_t)(ptr)[0] | ((uint16_t)(ptr)[1] << 8))
+
+/**
+ * Accessors for #IEEE802154_FrameView_t
+*/
+#define IEEE802154_FRAMEVIEW_FRAME_TYPE(view)                   ((view)->frame[0] & IEEE802154_FCF0_FRAME_TYPE_MASK)
+#define IEEE802154_FRAMEVIEW_DESTINATION_ADDRESS_MODE(view)     (((view)->frame[1] >> IEEE802154_FCF1_DESTINATION_MODE_SHIFT) & IEEE802154_FCF1_ADDRESS_MODE_MASK)
+#define IEEE802154_FRAMEVIEW_SOURCE_ADDRESS_MODE(view)          (((view)->frame[1] >> IEEE802154_FCF1_SOURCE_MODE_SHIFT) & IEEE802154_FCF1_ADDRESS_MODE_MASK)
+#define IEEE802154_FRAMEVIEW_SEQUENCE_NUMBER(view)              ((view)->frame[2])
+#define IEEE802154_FRAMEVIEW_PAYLOAD(view)                      (&(view)->frame[(view)->layout->headerLength])
+#define IEEE802154_FRAMEVIEW_PAYLOAD_LENGTH(view)               (uint8_t)((view)->length - (view)->layout->headerLength)
+
 #define IEEE802154_BROADCAST_PAN_ID             (IEEE802154_PANIdentifier_t)0xffff
 #define IEEE802154_BROADCAST_ADDRESS_16BIT      (IEEE802154_ShortAddress_t)0xffff
 
@@ -101,6 +151,21 @@
 
 #define FREQCTRL_CHANNEL_OFFSET                 (uint8_t)11
 #define FREQCTRL_CHANNEL_FAKTOR                 (uint8_t)5
+#define FREQCTRL_CHANNEL(channel)               (uint8_t)(FREQCTRL_CHANNEL_OFFSET + FREQCTRL_CHANNEL_FAKTOR * ((channel) - FREQCTRL_CHANNEL_OFFSET))
+#define RSSISTAT_RSSI_VALID                     0x01
+
+/**
+ * Channels of the 2450 MHz O-QPSK PHY
+*/
+#define IEEE802154_CHANNEL_FIRST                (uint8_t)11
+#define IEEE802154_CHANNEL_LAST                 (uint8_t)26
+#define IEEE802154_CHANNEL_COUNT                (uint8_t)16
+#define IEEE802154_CHANNEL_MASK_ALL             (uint32_t)0x07FFF800UL   /**< bit n set for channel n, as ScanChannels of 802.15.4 */
+/**
+ * Offset of RSSI register and of the RSSI appended to received frames, RSSI - offset is
+ * the input power in dBm (swru191c.pdf Chapter 23.10.3 RSSI)
+*/
+#define IEEE802154_RSSI_OFFSET                  (sint8_t)73
 
 /**
  * interrupt flag bits 
@@ -108,6 +173,67 @@
 #define RFIRQF0_RXPKTDONE                       0x40
 #define RFIRQF1_TXDONE                          0x02
 #define IEN2_RFIE                               0x01
+#define RFERRF_RXOVERF                          0x04
+#define FRMFILT0_FRAME_FILTER_EN                0x01
+#define FSMSTAT1_SAMPLED_CCA                    0x08
+#define T2CTRL_RUN                              0x01
+#define T2MSEL_T2MSEL_PERIOD                    0x02
+#define T2IRQF_TIMER2_PERF                      0x01
+#define IEN1_T2IE                               0x04
+#define IRCON_T2IF                              0x04
+#define IEN1_DMAIE                              0x01
+#define IRCON_DMAIF                             0x01
+
+/**
+ * Critical section of the MAC. Masks every interrupt whose ISR runs MAC code: the RF
+ * interrupt, the MAC timer interrupt with IEEE802154_ENABLE_CSMA and the DMA interrupt
+ * with IEEE802154_ENABLE_DMA. The previous mask is kept in a uint8_t of the caller,
+ * IEN1 bits as they are and IEN2_RFIE as bit 7, which is unused in IEN1, so sections
+ * nest and may also be used by the ISRs.
+*/
+#if defined(IEEE802154_ENABLE_CSMA) && defined(IEEE802154_ENABLE_DMA)
+#define IEEE802154_IEN1_MAC                     (IEN1_T2IE | IEN1_DMAIE)
+#elif defined(IEEE802154_ENABLE_CSMA)
+#define IEEE802154_IEN1_MAC                     IEN1_T2IE
+#elif defined(IEEE802154_ENABLE_DMA)
+#define IEEE802154_IEN1_MAC                     IEN1_DMAIE
+#endif
+#define IEEE802154_CRITICAL_RFIE                0x80
+#ifdef IEEE802154_IEN1_MAC
+#define IEEE802154_CRITICAL_ENTER(saved)        do { (saved) = (uint8_t)((IEN1 & IEEE802154_IEN1_MAC) | ((IEN2 & IEN2_RFIE) ? IEEE802154_CRITICAL_RFIE : 0)); \
+                                                     disableInterrupt(IEN2, IEN2_RFIE); disableInterrupt(IEN1, IEEE802154_IEN1_MAC); } while (0)
+#define IEEE802154_CRITICAL_EXIT(saved)         do { enableInterrupt(IEN1, (saved) & IEEE802154_IEN1_MAC); \
+                                                     if ((saved) & IEEE802154_CRITICAL_RFIE) { enableInterrupt(IEN2, IEN2_RFIE); } } while (0)
+#else
+#define IEEE802154_CRITICAL_ENTER(saved)        do { (saved) = (uint8_t)((IEN2 & IEN2_RFIE) ? IEEE802154_CRITICAL_RFIE : 0); \
+                                                     disableInterrupt(IEN2, IEN2_RFIE); } while (0)
+#define IEEE802154_CRITICAL_EXIT(saved)         do { if ((saved) & IEEE802154_CRITICAL_RFIE) { enableInterrupt(IEN2, IEN2_RFIE); } } while (0)
+#endif
+
+/**
+ * DMA descriptor fields, see swru191c.pdf Chapter 8.2.8 DMA Configuration Data Structure
+*/
+#define DMA_VLEN_USE_LEN                        0x00
+#define DMA_WORDSIZE_BYTE                       0x00
+#define DMA_TMODE_BLOCK                         0x20
+#define DMA_TRIG_NONE                           0x00
+#define DMA_SRCINC_0                            0x00
+#define DMA_SRCINC_1                            0x40
+#define DMA_DESTINC_0                           0x00
+#define DMA_DESTINC_1                           0x10
+#define DMA_IRQMASK_ENABLE                      0x08
+#define DMA_M8_USE_8_BITS                       0x00
+#define DMA_PRI_HIGH                            0x02
+#define DMA_RFD_XADDR                           (uint16_t)0x70D9    /**< RFD mapped to XDATA */
+
+/**
+ * AES coprocessor control, see swru191c.pdf Chapter 17.2 AES Operation
+*/
+#define ENCCS_ST                                0x01
+#define ENCCS_CMD_ENCRYPT                       0x00
+#define ENCCS_CMD_LOAD_KEY                      0x04
+#define ENCCS_RDY                               0x08
+#define ENCCS_MODE_ECB                          0x40
 
 /**
  * IEEE 802.15.4 unique IEEE address from the TI range of addresses.
@@ -121,23 +247,491 @@
 #define IEEE_EXTENDED_ADDRESS6                  XREG( 0x7812 )
 #define IEEE_EXTENDED_ADDRESS7                  XREG( 0x7813 )
 
+/**
+ * Source address table of the source address matching unit, 96 bytes shared by up to 24
+ * short (PAN ID and short address, 4 bytes) and 12 extended (8 bytes) entries. Extended
+ * entry n occupies short entries 2n and 2n+1. See swru191c.pdf Chapter 23.8 Source
+ * Address Matching.
+ */
+#define IEEE802154_SRC_ADDRESS_TABLE(offset)    XREG( 0x6100 + (offset) )
+#define IEEE802154_SRCMATCH_SHORT_ENTRIES       24
+#define IEEE802154_SRCMATCH_EXTENDED_ENTRIES    12
+#define IEEE802154_SRCMATCH_EXTENDED            0x20    /**< entry handle flag of extended entries, as in SRCRESINDEX */
+#define IEEE802154_SRCMATCH_INVALID             0xFF
+#define SRCMATCH_SRC_MATCH_EN                   0x01
+#define SRCMATCH_AUTOPEND                       0x02
+#define SRCMATCH_PEND_DATAREQ_ONLY              0x04
+
+/**
+ * MAC command frame identifiers, see 802.15.4-2006 Chapter "7.3 MAC command frames"
+ */
+#define IEEE802154_MAC_COMMAND_DATA_REQUEST     0x04
+
+/**
+ * Largest MAC header without security: frame control field, sequence number, two PAN IDs
+ * and two extended addresses
+*/
+#define IEEE802154_MAX_HEADER_SIZE              (uint8_t)23
+
+/**
+ * Prepared flows, see IEEE802154_flowPrepare(). If all traffic uses one header shape the
+ * flow template can be specialized in Config.h:
+ * - IEEE802154_FLOW_SHAPE_SHORT_SHORT: 16 bit destination and source address, PAN ID compression
+ * - IEEE802154_FLOW_SHAPE_EXTENDED_SHORT: 64 bit destination, 16 bit source address, PAN ID compression
+ * Header length is then a compile time constant and IEEE802154_flowPrepare() rejects other shapes.
+ */
+#if defined(IEEE802154_FLOW_SHAPE_SHORT_SHORT)
+#define IEEE802154_FLOW_LAYOUT_INDEX            (IEEE802154_FCF_ADDRESS_MODE_16BIT | (IEEE802154_FCF_ADDRESS_MODE_16BIT << 2) | 0x10)
+#define IEEE802154_FLOW_HEADER_SIZE             (uint8_t)9
+#elif defined(IEEE802154_FLOW_SHAPE_EXTENDED_SHORT)
+#define IEEE802154_FLOW_LAYOUT_INDEX            (IEEE802154_FCF_ADDRESS_MODE_64BIT | (IEEE802154_FCF_ADDRESS_MODE_16BIT << 2) | 0x10)
+#define IEEE802154_FLOW_HEADER_SIZE             (uint8_t)15
+#else
+#define IEEE802154_FLOW_HEADER_SIZE             IEEE802154_MAX_HEADER_SIZE
+#endif
+#ifdef IEEE802154_FLOW_LAYOUT_INDEX
+#define IEEE802154_FLOW_HEADER_LENGTH(flow)     IEEE802154_FLOW_HEADER_SIZE
+#else
+#define IEEE802154_FLOW_HEADER_LENGTH(flow)     ((flow)->headerLength)
+#endif
+
+/**
+ * Receive queue. If IEEE802154_ENABLE_RX_QUEUE is defined received frames are not
+ * handed out via IEEE802154_RxDataFrame and callbacks but are put into a queue of
+ * IEEE802154_RX_QUEUE_SIZE slots (power of two) with room for
+ * IEEE802154_RX_QUEUE_PAYLOAD_SIZE payload bytes each. Both can be set in Config.h.
+ */
+#ifndef IEEE802154_RX_QUEUE_SIZE
+#define IEEE802154_RX_QUEUE_SIZE                4
+#endif
+#ifndef IEEE802154_RX_QUEUE_PAYLOAD_SIZE
+#define IEEE802154_RX_QUEUE_PAYLOAD_SIZE        (IEEE802154_MAX_PHY_PACKET_SIZE - IEEE802154_CRCLENGTH)
+#endif
+
+/**
+ * Transmit queue. If IEEE802154_ENABLE_TX_QUEUE is defined frames can be sent without
+ * waiting for TXDONE, up to IEEE802154_TX_QUEUE_SIZE (power of two) frames are queued
+ * and sent back-to-back from RF ISR.
+ */
+#ifndef IEEE802154_TX_QUEUE_SIZE
+#define IEEE802154_TX_QUEUE_SIZE                4
+#endif
+
+/**
+ * Unslotted CSMA-CA with acknowledge wait and retransmission. If IEEE802154_ENABLE_CSMA
+ * is defined every frame is sent after a random backoff and a CCA and is retransmitted
+ * until acknowledged, see 802.15.4-2006 Chapter "7.5.1.4 CSMA-CA algorithm" and
+ * "7.5.6.4 Retransmissions". The engine is driven by the MAC timer which overflows once
+ * per backoff period (aUnitBackoffPeriod = 20 symbols = 320us = 10240 cycles at 32MHz).
+ * Defaults of #IEEE802154_CsmaConfig can be set in Config.h.
+ */
+#define IEEE802154_MAC_TIMER_BACKOFF_PERIOD     (uint16_t)10240
+#ifndef IEEE802154_MAC_MIN_BE
+#define IEEE802154_MAC_MIN_BE                   3
+#endif
+#ifndef IEEE802154_MAC_MAX_BE
+#define IEEE802154_MAC_MAX_BE                   5
+#endif
+#ifndef IEEE802154_MAC_MAX_CSMA_BACKOFFS
+#define IEEE802154_MAC_MAX_CSMA_BACKOFFS        4
+#endif
+#ifndef IEEE802154_MAC_MAX_FRAME_RETRIES
+#define IEEE802154_MAC_MAX_FRAME_RETRIES        3
+#endif
+#ifndef IEEE802154_MAC_ACK_WAIT_PERIODS
+#define IEEE802154_MAC_ACK_WAIT_PERIODS         3       /**< macAckWaitDuration of 54 symbols rounded up to backoff periods */
+#endif
+
+/**
+ * Result of a transmission, see IEEE802154_TxStatus and the FrameSent callbacks.
+ * Values of MAC enumerations according to 802.15.4-2006 Table 78
+ */
+#define IEEE802154_TX_SUCCESS                   (uint8_t)0x00
+#define IEEE802154_TX_CHANNEL_ACCESS_FAILURE    (uint8_t)0xE1
+#define IEEE802154_TX_NO_ACK                    (uint8_t)0xE9
+#define IEEE802154_TX_COUNTER_ERROR             (uint8_t)0xDB   /**< outgoing frame counter exhausted */
+#define IEEE802154_TX_FRAME_TOO_LONG            (uint8_t)0xE5   /**< header, payload and FCS exceed aMaxPHYPacketSize */
+#define IEEE802154_TX_INVALID_PARAMETER         (uint8_t)0xE8   /**< header uses a reserved address mode */
+#define IEEE802154_TX_UNAVAILABLE_KEY           (uint8_t)0xF3   /**< no key set by IEEE802154_securitySetKey() */
+
+/**
+ * DMA transfers. If IEEE802154_ENABLE_DMA is defined payloads of at least
+ * IEEE802154_DMA_MIN_LENGTH bytes are moved between RFD and the payload buffer by the
+ * DMA controller, headers are still written and parsed by the CPU.
+ * - TX: IEEE802154_DMA_TX_CHANNEL copies the payload to TXFIFO, transmission is started
+ *   from the DMA ISR once the transfer is complete
+ * - RX: IEEE802154_DMA_RX_CHANNEL copies the payload out of RXFIFO, the RF ISR returns
+ *   and the DMA ISR finishes the frame once the transfer is complete. Further frames in
+ *   RXFIFO are handled by the DMA ISR afterwards.
+ * The driver owns DMA_VECTOR and the descriptors of channel 1-4 (see
+ * IEEE802154_DmaDescriptor), the application may use the other two of these channels
+ * without interrupt. Payload buffers must be located in XDATA. The DMA ISR must have the
+ * same interrupt priority as the RF ISR.
+ */
+#ifndef IEEE802154_DMA_TX_CHANNEL
+#define IEEE802154_DMA_TX_CHANNEL               1
+#endif
+#ifndef IEEE802154_DMA_RX_CHANNEL
+#define IEEE802154_DMA_RX_CHANNEL               2
+#endif
+#ifndef IEEE802154_DMA_MIN_LENGTH
+#define IEEE802154_DMA_MIN_LENGTH               8       /**< shorter payloads are cheaper to copy than to set up the DMA */
+#endif
+#define IEEE802154_DMA_TX_MASK                  (uint8_t)(1 << IEEE802154_DMA_TX_CHANNEL)
+#define IEEE802154_DMA_RX_MASK                  (uint8_t)(1 << IEEE802154_DMA_RX_CHANNEL)
+
+/**
+ * Software frame check sequence, see IEEE_802.15.4_Crc.c. If IEEE802154_ENABLE_SOFTWARE_CRC
+ * is defined AUTOCRC (and thus AUTOACK) is disabled and the MAC computes and checks the
+ * FCS itself. RXFIFO then holds the FCS instead of RSSI and correlation value, RSSI is read
+ * from register RSSI and LQI is 0. Not available together with IEEE802154_ENABLE_DMA.
+ */
+#define IEEE802154_CRC16_INIT                   (uint16_t)0x0000
+#define IEEE802154_CRC16_UPDATE(crc, data)      (uint16_t)(((crc) >> 8) ^ IEEE802154_crc16Table[(uint8_t)((crc) ^ (data))])
+#define IEEE802154_CRC32_INIT                   (uint32_t)0xFFFFFFFFUL
+#define IEEE802154_CRC32_FINAL(crc)             (uint32_t)((crc) ^ 0xFFFFFFFFUL)
+#if defined(IEEE802154_ENABLE_SOFTWARE_CRC) && defined(IEEE802154_ENABLE_DMA)
+#error "IEEE802154_ENABLE_SOFTWARE_CRC requires all frame bytes to pass the CPU, disable IEEE802154_ENABLE_DMA"
+#endif
+
+/**
+ * Duplicate frame rejection. If IEEE802154_ENABLE_DUPLICATE_FILTER is defined the last
+ * sequence number of up to IEEE802154_DUPLICATE_CACHE_SIZE sources is remembered for
+ * IEEE802154_DUPLICATE_LIFETIME (unit of #IEEE802154_Timestamp_t). Data and MAC command
+ * frames repeating it are dropped by the RF ISR before their payload is read, see
+ * 802.15.4-2006 Chapter "7.5.6.6 Rejection of duplicate frames"
+ */
+#ifndef IEEE802154_DUPLICATE_CACHE_SIZE
+#define IEEE802154_DUPLICATE_CACHE_SIZE         8
+#endif
+#ifndef IEEE802154_DUPLICATE_LIFETIME
+#define IEEE802154_DUPLICATE_LIFETIME           (IEEE802154_Timestamp_t)1000
+#endif
+
+/**
+ * Statistics. If IEEE802154_ENABLE_STATISTICS is defined the MAC counts frames, bytes and
+ * drops by reason and measures the duration of the RF ISR and of blocking sends in
+ * cycles of the MAC timer (32MHz). Read with IEEE802154_statisticsSnapshot(). Without it
+ * no code is generated for the counters.
+ */
+#define IEEE802154_STATISTICS_FRAME_TYPES       4       /**< beacon, data, acknowledge, MAC command (reserved types are counted as MAC command) */
+/** average of a cycle statistic, 0 if nothing was measured */
+#define IEEE802154_CYCLES_AVERAGE(stat)         ((stat).count ? (stat).total / (stat).count : 0)
+
+/**
+ * Sniffer. If IEEE802154_ENABLE_SNIFFER is defined IEEE802154_snifferStart() disables
+ * frame filtering and AUTOACK. The RF ISR then stores every frame, including frames with
+ * invalid CRC, with timestamp, channel, RSSI and correlation value in a ring buffer of
+ * IEEE802154_SNIFFER_BUFFER_SIZE bytes (power of 2) instead of handling it. A frame takes
+ * its PHY length plus IEEE802154_SNIFFER_RECORD_OVERHEAD bytes. At 250 kbit/s the channel
+ * delivers at most 31.25 bytes per ms, the default buffer covers 25 ms between two reads.
+ * IEEE802154_snifferPcapRecord() converts the oldest frame into a pcap record of link
+ * type LINKTYPE_IEEE802_15_4_TAP with FCS type, RSS, LQI and channel TLVs.
+ */
+#ifndef IEEE802154_SNIFFER_BUFFER_SIZE
+#define IEEE802154_SNIFFER_BUFFER_SIZE          1024
+#endif
+#if (IEEE802154_SNIFFER_BUFFER_SIZE & (IEEE802154_SNIFFER_BUFFER_SIZE - 1)) || (IEEE802154_SNIFFER_BUFFER_SIZE > 32768)
+#error "IEEE802154_SNIFFER_BUFFER_SIZE must be a power of 2 not above 32768"
+#endif
+#define IEEE802154_SNIFFER_RECORD_OVERHEAD      (uint8_t)8      /**< length, timestamp, timer count and channel */
+#define IEEE802154_PCAP_HEADER_SIZE             (uint8_t)24     /**< pcap global header */
+#define IEEE802154_PCAP_TAP_HEADER_SIZE         (uint8_t)36     /**< TAP header with 4 TLVs */
+#define IEEE802154_PCAP_RECORD_MAX              (16 + IEEE802154_PCAP_TAP_HEADER_SIZE + IEEE802154_MAX_PHY_PACKET_SIZE)
+#define IEEE802154_PCAP_LINKTYPE_IEEE802_15_4_TAP  283
+
+/**
+ * Address interning. If IEEE802154_ENABLE_ADDRESS_INTERNING is defined extended addresses
+ * can be stored once in a table of IEEE802154_ADDRESS_TABLE_SIZE entries and referenced
+ * by a 1 byte handle, see IEEE802154_addressIntern(). The neighbor table then holds
+ * #IEEE802154_CompactAddress_t instead of full addresses.
+ */
+#ifndef IEEE802154_ADDRESS_TABLE_SIZE
+#define IEEE802154_ADDRESS_TABLE_SIZE           16
+#endif
+#if IEEE802154_ADDRESS_TABLE_SIZE > 255
+#error "IEEE802154_ADDRESS_TABLE_SIZE must be below 256"
+#endif
+#define IEEE802154_ADDRESS_HANDLE_INVALID       (uint8_t)0xFF
+
+/**
+ * Link quality of neighbors. If IEEE802154_ENABLE_NEIGHBOR_TABLE is defined the RF ISR
+ * keeps RSSI and LQI of each source in a table of IEEE802154_NEIGHBOR_TABLE_SIZE entries
+ * (power of 2). A source is hashed onto a pair of entries, so lookup and update take
+ * constant time, on a miss the older entry of the pair is replaced. RSSI and LQI are
+ * smoothed by an exponentially weighted moving average with weight
+ * 2^-IEEE802154_NEIGHBOR_EWMA_SHIFT of the new sample.
+ */
+#ifndef IEEE802154_NEIGHBOR_TABLE_SIZE
+#define IEEE802154_NEIGHBOR_TABLE_SIZE          16
+#endif
+#ifndef IEEE802154_NEIGHBOR_EWMA_SHIFT
+#define IEEE802154_NEIGHBOR_EWMA_SHIFT          3
+#endif
+#if (IEEE802154_NEIGHBOR_TABLE_SIZE < 2) || (IEEE802154_NEIGHBOR_TABLE_SIZE & (IEEE802154_NEIGHBOR_TABLE_SIZE - 1))
+#error "IEEE802154_NEIGHBOR_TABLE_SIZE must be a power of 2"
+#endif
+/** smoothed RSSI of a neighbor entry, unit of RSSI register. Average is mostly negative,
+ * it is divided rather than shifted as right shift of a negative value is implementation defined. */
+#define IEEE802154_NEIGHBOR_RSSI(entry)         (sint8_t)((entry)->rssiAverage / (1 << IEEE802154_NEIGHBOR_EWMA_SHIFT))
+/** smoothed LQI (correlation value) of a neighbor entry */
+#define IEEE802154_NEIGHBOR_LQI(entry)          (uint8_t)((entry)->lqiAverage >> IEEE802154_NEIGHBOR_EWMA_SHIFT)
+
+/**
+ * Indirect transmission. If IEEE802154_ENABLE_INDIRECT_QUEUE is defined frames for sleepy
+ * children are queued per source match entry in a pool of IEEE802154_INDIRECT_POOL_SIZE
+ * frames. The pending bit of the entry is set while frames are queued so AUTOACK sets
+ * frame pending in the ACK of a data request, and the RF ISR answers the data request
+ * with the first queued frame via the transmit queue.
+ */
+#ifndef IEEE802154_INDIRECT_POOL_SIZE
+#define IEEE802154_INDIRECT_POOL_SIZE           8
+#endif
+#if defined(IEEE802154_ENABLE_INDIRECT_QUEUE) && (!defined(IEEE802154_ENABLE_SOURCE_MATCH) || !defined(IEEE802154_ENABLE_TX_QUEUE))
+#error "IEEE802154_ENABLE_INDIRECT_QUEUE requires IEEE802154_ENABLE_SOURCE_MATCH and IEEE802154_ENABLE_TX_QUEUE"
+#endif
+
+/**
+ * Energy detection scan. If IEEE802154_ENABLE_ED_SCAN is defined IEEE802154_edScan()
+ * measures the energy on a set of channels. The MAC timer is then run with one overflow
+ * per backoff period as with IEEE802154_ENABLE_CSMA, dwell time is given in these units.
+ */
+#ifndef IEEE802154_ED_SCAN_DWELL
+#define IEEE802154_ED_SCAN_DWELL                (uint8_t)8      /**< default dwell time, 8 backoff periods = 2.56ms */
+#endif
+
+/**
+ * MAC security. If IEEE802154_ENABLE_SECURITY is defined frames with security enabled in
+ * the frame control field carry an auxiliary security header and are secured by CCM*
+ * with AES-128, see IEEE_802.15.4_Security.c. The block cipher is the AES coprocessor,
+ * with IEEE802154_ENABLE_SOFTWARE_AES or IEEE802154_SIMULATION a software AES.
+ * Frame counters of up to IEEE802154_SECURITY_DEVICE_TABLE_SIZE sources are tracked.
+ */
+#ifndef IEEE802154_SECURITY_DEVICE_TABLE_SIZE
+#define IEEE802154_SECURITY_DEVICE_TABLE_SIZE   8
+#endif
+#define IEEE802154_SECURITY_DEVICE_INVALID      (uint8_t)0xFF
+#define IEEE802154_AES_BLOCK_SIZE               (uint8_t)16
+#define IEEE802154_CCM_NONCE_SIZE               (uint8_t)13
+#if defined(IEEE802154_SIMULATION) || defined(IEEE802154_ENABLE_SOFTWARE_AES)
+#define IEEE802154_SOFTWARE_AES
+#endif
+/* security control field of auxiliary security header: level bit 0:2, key identifier mode bit 3:4 */
+#define IEEE802154_SECURITY_LEVEL_MASK          0x07
+#define IEEE802154_SECURITY_LEVEL_ENC           0x04    /**< levels 4-7 encrypt the payload */
+#define IEEE802154_KEY_ID_MODE_SHIFT            3
+#define IEEE802154_KEY_ID_MODE_MASK             0x03
+#define IEEE802154_SECURITY_CONTROL(level, keyIdMode)   (uint8_t)((level) | ((keyIdMode) << IEEE802154_KEY_ID_MODE_SHIFT))
+/** MIC length of a security level: 0, 4, 8 or 16 bytes */
+#define IEEE802154_MIC_LENGTH(level)            (uint8_t)(((level) & 0x03) ? 2 << ((level) & 0x03) : 0)
+/** key identifier length of key identifier mode 0-3: 0, 1, 5 or 9 bytes */
+#define IEEE802154_KEY_ID_LENGTH(keyIdMode)     (uint8_t)((keyIdMode) ? 4 * (keyIdMode) - 3 : 0)
+/** auxiliary security header length for a security control field */
+#define IEEE802154_AUX_HEADER_LENGTH(control)   (uint8_t)(IEEE802154_AUX_HEADER_MIN_SIZE + \
+                                                          IEEE802154_KEY_ID_LENGTH(((control) >> IEEE802154_KEY_ID_MODE_SHIFT) & IEEE802154_KEY_ID_MODE_MASK))
+#define IEEE802154_AUX_HEADER_MIN_SIZE          (uint8_t)5      /**< security control and frame counter */
+#define IEEE802154_AUX_HEADER_MAX_SIZE          (uint8_t)14
+
+/**
+ * Instances. All mutable state of the driver and of the emulated radio of
+ * IEEE_802.15.4_Sim.c is kept in an #IEEE802154_Context_t reached through
+ * IEEE802154_Instance. The modules access the members through macros named like
+ * globals, e.g. IEEE802154_TxStatus. By default IEEE802154_Instance is the address of the only
+ * context IEEE802154_Context, a constant, so the 8051 still addresses every member
+ * directly.
+ * Network simulation. If IEEE802154_ENABLE_NETSIM is defined together with
+ * IEEE802154_SIMULATION IEEE802154_Instance is a thread local pointer, initially to
+ * IEEE802154_Context, and IEEE802154_TxDataFrame and IEEE802154_RxDataFrame are part of the
+ * context as well. IEEE_802.15.4_NetSim.c runs the context of every node of a network on a
+ * pool of worker threads, each pointing IEEE802154_Instance to the node it works on.
+ */
+#ifdef IEEE802154_ENABLE_NETSIM
+#if !defined(IEEE802154_SIMULATION) || !defined(IEEE802154_ENABLE_TX_QUEUE)
+#error "IEEE802154_ENABLE_NETSIM requires IEEE802154_SIMULATION and IEEE802154_ENABLE_TX_QUEUE"
+#endif
+#endif
+
+/**
+ * Scatter-gather payloads. If IEEE802154_ENABLE_SCATTER_GATHER is defined the payload of a
+ * frame can be given as a list of #IEEE802154_Segment_t instead of a single buffer:
+ * - TX: IEEE802154_radioSentDataFrameSegments() streams the segments into TXFIFO in order
+ *   behind the header, header->payload is not used. Only the last segment may be copied
+ *   by DMA, segments of secured frames are gathered in RAM for CCM*.
+ * - RX: after IEEE802154_radioSetRxSegments() the RF ISR reads the payload of data frames
+ *   into the given segments instead of IEEE802154_RxDataFrame.payload. Frames exceeding
+ *   the segments are dropped. Secured frames are decrypted in place and still use
+ *   IEEE802154_RxDataFrame.payload. Not available with IEEE802154_ENABLE_RX_QUEUE, whose
+ *   slots hold the payload.
+ */
+
+/**
+ * 6LoWPAN. If IEEE802154_ENABLE_LOWPAN is defined IEEE_802.15.4_Lowpan.c carries IPv6
+ * packets in data frames with IPHC header compression and fragmentation, see
+ * IEEE_802.15.4_Lowpan.h. Frames are sent with IEEE802154_radioSentDataFrameSegments().
+ * Packets of up to IEEE802154_LOWPAN_MTU bytes are reassembled in
+ * IEEE802154_LOWPAN_REASSEMBLY_BUFFERS buffers.
+ */
+#if defined(IEEE802154_ENABLE_LOWPAN) && !defined(IEEE802154_ENABLE_SCATTER_GATHER)
+#error "IEEE802154_ENABLE_LOWPAN requires IEEE802154_ENABLE_SCATTER_GATHER"
+#endif
+#ifndef IEEE802154_LOWPAN_MTU
+#define IEEE802154_LOWPAN_MTU                   1280    /**< largest IPv6 packet sent or reassembled, IPv6 minimum MTU */
+#endif
+#ifndef IEEE802154_LOWPAN_REASSEMBLY_BUFFERS
+#define IEEE802154_LOWPAN_REASSEMBLY_BUFFERS    2
+#endif
+#ifndef IEEE802154_LOWPAN_REASSEMBLY_TIMEOUT
+#define IEEE802154_LOWPAN_REASSEMBLY_TIMEOUT    (IEEE802154_Timestamp_t)187500  /**< 60 s in backoff periods, unit of #IEEE802154_Timestamp_t */
+#endif
+#if (IEEE802154_LOWPAN_MTU < 1280) || (IEEE802154_LOWPAN_MTU > 2047) || (IEEE802154_LOWPAN_MTU & 7)
+#error "IEEE802154_LOWPAN_MTU must be a multiple of 8 from 1280 to 2047"
+#endif
+#define IEEE802154_LOWPAN_IPV6_HEADER_SIZE      (uint8_t)40
+#define IEEE802154_LOWPAN_UDP_HEADER_SIZE       (uint8_t)8
+/** largest packet carried unfragmented in one frame */
+#define IEEE802154_LOWPAN_FRAME_PACKET_SIZE     (IEEE802154_LOWPAN_IPV6_HEADER_SIZE + IEEE802154_LOWPAN_UDP_HEADER_SIZE + IEEE802154_MAX_PHY_PACKET_SIZE)
+
 #define IEEE802154_HEADERSIZE_STATIC            sizeof(IEEE802154_FCF_t) + sizeof(uint8_t) + sizeof(IEEE802154_PANIdentifier_t)     /**< IEEE 802.15.4 header size without addresses as they may vary but including destination panID */
 
 /*******************| Type definitions |*******************************/
-
 typedef uint16_t IEEE802154_ShortAddress_t;             /**< 16bit short address for IEEE 802.15.4 radio */
 typedef uint8_t IEEE802154_ExtendedAddress_t[8];         /**< 64bit short address for IEEE 802.15.4 radio */
 typedef uint16_t IEEE802154_PANIdentifier_t;            /**< 16bit PAN Identifier */
+typedef uint32_t IEEE802154_Timestamp_t;                /**< MAC timer overflow count (backoff periods with IEEE802154_ENABLE_CSMA or IEEE802154_ENABLE_ED_SCAN), see IEEE802154_radioReadMacTimer() */
+
+/**
+ * Result of an energy detection scan
+*/
+typedef struct
+{
+  uint32_t scannedChannels;                     /**< bit n set if channel n was measured */
+  sint8_t energy[IEEE802154_CHANNEL_COUNT];     /**< RSSI register value per channel, index 0 is channel 11 */
+} IEEE802154_EdScanReport_t;
 
 /**
-  For later use as address type when switching from 16 to 32bit addressing
+ * DMA configuration data structure of one channel
 */
 typedef struct
+{
+  uint8_t sourceAddressHigh;
+  uint8_t sourceAddressLow;
+  uint8_t destinationAddressHigh;
+  uint8_t destinationAddressLow;
+  uint8_t lengthHigh;                   /**< VLEN 7:5, LEN 12:8 */
+  uint8_t lengthLow;                    /**< LEN 7:0 */
+  uint8_t trigger;                      /**< WORDSIZE 7, TMODE 6:5, TRIG 4:0 */
+  uint8_t config;                       /**< SRCINC 7:6, DESTINC 5:4, IRQMASK 3, M8 2, PRIORITY 1:0 */
+} IEEE802154_DmaDescriptor_t;
+
+/**
+ * Runtime parameters of the CSMA-CA engine
+*/
+typedef struct
+{
+  uint8_t minBE;                        /**< macMinBE */
+  uint8_t maxBE;                        /**< macMaxBE */
+  uint8_t maxCsmaBackoffs;              /**< macMaxCSMABackoffs */
+  uint8_t maxFrameRetries;              /**< macMaxFrameRetries */
+  uint8_t ackWaitPeriods;               /**< backoff periods to wait for an acknowledge */
+} IEEE802154_CsmaConfig_t;
+
+/**
+ * Short or extended address, which one is valid is given by the address mode of the
+ * frame control field or of the structure holding the address
+*/
+typedef union
 {
   IEEE802154_ShortAddress_t shortAddress;
   IEEE802154_ExtendedAddress_t extendedAdress;
 } IEEE802154_Adress_t;
 
+/**
+ * Short address or handle of an interned extended address, see
+ * IEEE802154_ENABLE_ADDRESS_INTERNING. Like #IEEE802154_Adress_t the valid member is
+ * given by the address mode stored next to it.
+*/
+typedef union
+{
+  IEEE802154_ShortAddress_t shortAddress;
+  uint8_t handle;                       /**< index into address table, see IEEE802154_addressIntern() */
+} IEEE802154_CompactAddress_t;
+
+/**
+ * Entry of duplicate frame cache
+*/
+typedef struct
+{
+  IEEE802154_Adress_t sourceAddress;    /**< short or extended address depending on addressMode */
+  uint8_t addressMode;                  /**< IEEE802154_FCF_ADDRESS_MODE_NONE marks an unused entry */
+  uint8_t sequenceNumber;               /**< last sequence number received from source */
+  IEEE802154_Timestamp_t timestamp;     /**< time of last frame from source */
+} IEEE802154_DuplicateEntry_t;
+
+/**
+ * Entry of security device table, see IEEE802154_securityDeviceAdd()
+*/
+typedef struct
+{
+  IEEE802154_ExtendedAddress_t extendedAddress;  /**< transmitted order, used for the nonce */
+  IEEE802154_ShortAddress_t shortAddress;        /**< 0xFFFE if device has no short address */
+  uint32_t frameCounter;                /**< lowest frame counter accepted next */
+  uint8_t used;
+} IEEE802154_SecurityDevice_t;
+
+/**
+ * Minimum, maximum and sum of a measured duration in cycles
+*/
+typedef struct
+{
+  uint32_t min;                         /**< 0xFFFFFFFF if nothing was measured */
+  uint32_t max;
+  uint32_t total;                       /**< sum of measurements, halved together with count before it overflows */
+  uint16_t count;                       /**< measurements in total */
+} IEEE802154_CycleStatistics_t;
+
+/**
+ * Counters of the MAC, see IEEE802154_ENABLE_STATISTICS
+*/
+typedef struct
+{
+  uint16_t rxFrames[IEEE802154_STATISTICS_FRAME_TYPES];  /**< frames with valid CRC by frame type */
+  uint32_t rxBytes;                     /**< PHY payload of frames with valid CRC */
+  uint16_t rxCrcErrors;                 /**< frames with invalid CRC */
+  uint16_t rxMalformed;                 /**< frames dropped due to reserved address mode, truncated header or invalid length byte */
+  uint16_t rxDuplicates;                /**< frames dropped by IEEE802154_ENABLE_DUPLICATE_FILTER */
+  uint16_t rxQueueFull;                 /**< frames dropped as receive queue was full */
+  uint16_t rxTooLong;                   /**< frames dropped as payload exceeds receive queue slot or receive segments */
+  uint16_t rxSecurityFailures;          /**< secured frames dropped due to unknown source, old frame counter or MIC mismatch */
+  uint16_t rxOverflows;                 /**< RXFIFO overflows */
+  uint16_t rxFlushes;                   /**< RXFIFO flushes on overflow or invalid length byte */
+  uint16_t rxTrailingDropped;           /**< flushes discarding data behind the first frame (without IEEE802154_ENABLE_RX_DRAIN) */
+  uint16_t txFrames;                    /**< frames written to TXFIFO */
+  uint32_t txBytes;                     /**< PHY payload of frames written to TXFIFO */
+  uint16_t txRetries;                   /**< retransmissions by CSMA-CA engine */
+  uint16_t txChannelAccessFailures;     /**< frames given up as channel was busy */
+  uint16_t txNoAck;                     /**< frames given up without acknowledge */
+  IEEE802154_CycleStatistics_t isrCycles;  /**< duration of RF ISR */
+  IEEE802154_CycleStatistics_t txCycles;   /**< duration of blocking sends including wait for completion */
+} IEEE802154_Statistics_t;
+
+/**
+ * Entry of neighbor table, averages are scaled by 2^IEEE802154_NEIGHBOR_EWMA_SHIFT, use
+ * IEEE802154_NEIGHBOR_RSSI() and IEEE802154_NEIGHBOR_LQI() to read them
+*/
+typedef struct
+{
+#ifdef IEEE802154_ENABLE_ADDRESS_INTERNING
+  IEEE802154_CompactAddress_t address;  /**< short address or handle of extended address depending on addressMode */
+#else
+  IEEE802154_Adress_t address;          /**< short or extended address depending on addressMode */
+#endif
+  uint8_t addressMode;                  /**< IEEE802154_FCF_ADDRESS_MODE_NONE marks an unused entry */
+  sint16_t rssiAverage;                 /**< smoothed RSSI */
+  uint16_t lqiAverage;                  /**< smoothed correlation value, 0 with IEEE802154_ENABLE_SOFTWARE_CRC */
+  uint16_t frames;                      /**< frames with valid CRC received from neighbor, saturating */
+  IEEE802154_Timestamp_t lastSeen;      /**< time of last frame from neighbor */
+} IEEE802154_NeighborEntry_t;
+
 /**
   * \brief IEEE 802.15.4 config.
   */
@@ -165,9 +759,27 @@ typedef struct {
   uint16_t sourceAddressMode : 2;       /**< 2 bit. Source address mode, see 802.15.4 */
 } IEEE802154_FCF_t;
   
+/**
+  * \brief Auxiliary security header, see 802.15.4-2006 Chapter "7.6.2 Auxiliary security header"
+  */
+typedef struct {
+  uint8_t securityControl;              /**< security level and key identifier mode, see IEEE802154_SECURITY_CONTROL() */
+  uint32_t frameCounter;                /**< filled in by the MAC on transmission */
+  uint8_t keySource[8];                 /**< 4 bytes with key identifier mode 2, 8 bytes with mode 3 */
+  uint8_t keyIndex;                     /**< key identifier mode 1-3 */
+} IEEE802154_AuxSecurityHeader_t;
+
 typedef uint8_t IEEE802154_Payload;
 typedef IEEE802154_Payload *IEEE802154_PayloadPointer;
 
+/**
+  * \brief Part of a payload, see IEEE802154_ENABLE_SCATTER_GATHER
+  */
+typedef struct {
+  IEEE802154_PayloadPointer data;
+  uint8_t length;
+} IEEE802154_Segment_t;
+
 /**
   * \brief IEEE 802.15.4 frame header according to 802.15.4g-2012 Chapter 7.2.1 General MAC frame format
   * NOTE: No CRC is added here as hardware will add it automatically
@@ -181,29 +793,416 @@ typedef struct {
   IEEE802154_PANIdentifier_t sourcePANID;
 #endif
   IEEE802154_Adress_t sourceAddress;
-  /* @todo add security stuff here */
+#ifdef IEEE802154_ENABLE_SECURITY
+  IEEE802154_AuxSecurityHeader_t auxSecurityHeader;  /**< used if fcf.securityEnabled is set */
+#endif
   IEEE802154_PayloadPointer payload;   /**< pointer to payload */
 } IEEE802154_DataFrameHeader_t;
 
+/**
+  * \brief Position of addressing fields in a MAC header, see #IEEE802154_frameLayout.
+  * Offsets are counted from the first byte of the frame control field, 0 means
+  * the field is not present. Destination PAN ID, if present, is always at offset 3.
+  */
+typedef struct {
+  uint8_t destinationAddressOffset;
+  uint8_t sourcePANIDOffset;            /**< 0 also if omitted due to PAN ID compression */
+  uint8_t sourceAddressOffset;
+  uint8_t headerLength;                 /**< MAC header length, 0 if a reserved address mode is used */
+} IEEE802154_FrameLayout_t;
+
+/**
+  * \brief Zero-copy view on a raw MAC frame, see IEEE802154_frameViewInit()
+  */
+typedef struct {
+  uint8_t *frame;                       /**< MAC frame starting with frame control field */
+  uint8_t length;                       /**< length of frame without FCS */
+  const IEEE802154_FrameLayout_t *layout;
+} IEEE802154_FrameView_t;
+
+/**
+  * \brief Prepared flow: MAC header serialized once by IEEE802154_flowPrepare(), only
+  * sequence number and length are filled in per frame.
+  */
+typedef struct {
+#ifndef IEEE802154_FLOW_LAYOUT_INDEX
+  uint8_t headerLength;
+#endif
+  uint8_t sequenceNumber;               /**< sequence number of next frame, incremented per frame */
+  uint8_t header[IEEE802154_FLOW_HEADER_SIZE];
+} IEEE802154_Flow_t;
+
+/**
+  * \brief Entry of transmit queue. Header and payload are referenced, not copied.
+  */
+typedef struct {
+  IEEE802154_DataFrameHeader_t *header; /**< header of frame, NULL for frame of a prepared flow */
+  IEEE802154_Flow_t *flow;              /**< prepared flow if header is NULL */
+  IEEE802154_PayloadPointer payload;    /**< payload of flow frame */
+  uint8_t payloadLength;
+  uint8_t sequenceNumber;               /**< sequence number of flow frame */
+#ifdef IEEE802154_ENABLE_SCATTER_GATHER
+  const IEEE802154_Segment_t *segments; /**< payload of header frame, NULL if it is at header->payload */
+  uint8_t segmentCount;
+#endif
+#ifdef IEEE802154_ENABLE_INDIRECT_QUEUE
+  uint8_t framePending;                 /**< header frame is sent with frame pending set, header is not modified */
+#endif
+} IEEE802154_TxQueueEntry_t;
+
+/**
+  * \brief Frame of indirect transmission pool. Header and payload are referenced, not copied.
+  */
+typedef struct {
+  IEEE802154_DataFrameHeader_t *header; /**< header of frame including pointer to payload */
+  uint8_t payloadLength;
+  uint8_t next;                         /**< pool index of next frame for same child, IEEE802154_SRCMATCH_INVALID at end */
+} IEEE802154_IndirectFrame_t;
+
+/**
+  * \brief Slot of receive queue, filled by Rx ISR. header.payload points to payload.
+  */
+typedef struct {
+  IEEE802154_DataFrameHeader_t header;
+  uint8_t payloadLength;                /**< length of payload excluding header and CRC */
+  sint8_t rssi;                         /**< RSSI value appended by radio */
+  uint8_t lqi;                          /**< correlation value appended by radio, used as LQI */
+  IEEE802154_Timestamp_t timestamp;     /**< time frame was read from RXFIFO */
+  IEEE802154_Payload payload[IEEE802154_RX_QUEUE_PAYLOAD_SIZE];
+} IEEE802154_RxQueueSlot_t;
+
+/**
+  * \brief 6LoWPAN reassembly buffer, a fragmented packet is identified by addresses, size and tag
+  */
+typedef struct {
+  IEEE802154_Adress_t sourceAddress;
+  IEEE802154_Adress_t destinationAddress;
+  uint8_t sourceAddressMode;
+  uint8_t destinationAddressMode;
+  uint16_t size;                        /**< datagram size, 0 if buffer is unused */
+  uint16_t tag;                         /**< datagram tag */
+  uint16_t received;                    /**< bytes of uncompressed packet received */
+  uint8_t headerStored;                 /**< FRAG1 with the decompressed headers has been stored */
+  IEEE802154_Timestamp_t start;         /**< time first fragment was received */
+  uint8_t blocks[(IEEE802154_LOWPAN_MTU + 63) / 64];  /**< bitmap of received 8 byte blocks */
+  uint8_t packet[IEEE802154_LOWPAN_MTU];
+} IEEE802154_LowpanReassembly_t;
+
+#ifdef IEEE802154_SIMULATION
+#include "IEEE_802.15.4_Sim.h"          /* the emulated radio is part of the context */
+#endif
+
+/**
+  * \brief State of an instance of the MAC, see IEEE802154_Instance. Each module defines
+  * macros named like globals for the members it uses.
+  */
+typedef struct {
+#ifdef IEEE802154_ENABLE_CSMA
+  IEEE802154_CsmaConfig_t csmaConfig;   /**< initialized with the defaults in the definition of IEEE802154_Context */
+#endif
+#ifdef IEEE802154_ENABLE_NETSIM
+  IEEE802154_DataFrameHeader_t txDataFrame;
+#ifndef IEEE802154_ENABLE_RX_QUEUE
+  IEEE802154_DataFrameHeader_t rxDataFrame;
+#endif
+#endif
+  /* IEEE_802.15.4.c */
+  uint8_t channel;                      /**< channel radio is tuned to */
+#ifdef IEEE802154_ENABLE_STATISTICS
+  IEEE802154_Statistics_t statistics;
+#endif
+#ifdef IEEE802154_ENABLE_RX_DRAIN
+  uint8_t rxFramesPerInterrupt;
+  uint8_t rxFramesPerInterruptMax;
+#endif
+#ifdef IEEE802154_ENABLE_TX_QUEUE
+  IEEE802154_TxQueueEntry_t txQueue[IEEE802154_TX_QUEUE_SIZE];
+  volatile uint8_t txQueueHead;         /**< free running index of next entry filled by application */
+  volatile uint8_t txQueueTail;         /**< free running index of frame currently sent */
+#endif
+#ifdef IEEE802154_ENABLE_INDIRECT_QUEUE
+  IEEE802154_DataFrameHeader_t txHeader;  /**< copy of header of a queue entry sent with frame pending set */
+#endif
+#ifdef IEEE802154_ENABLE_CSMA
+  volatile uint8_t txStatus;
+  volatile uint8_t csmaState;
+  uint8_t csmaNB;                       /**< number of backoffs for current transmission attempt */
+  uint8_t csmaBE;                       /**< backoff exponent */
+  uint8_t csmaRetries;                  /**< retransmissions done for current frame */
+  uint8_t csmaTimer;                    /**< backoff periods until backoff or ACK wait expires */
+  uint8_t csmaAckRequired;
+  uint8_t csmaSequenceNumber;           /**< sequence number of outstanding frame */
+  uint16_t random;                      /**< LFSR state for random backoff */
+#endif
+#ifdef IEEE802154_ENABLE_DMA
+  volatile uint8_t dmaTxPending;        /**< payload is copied to TXFIFO, transmission not yet started */
+  uint8_t dmaTxAckRequired;
+  uint8_t dmaTxSequenceNumber;
+  volatile uint8_t dmaRxPending;        /**< payload is copied out of RXFIFO, frame is finished by IEEE802154_dmaISR() */
+#endif
+  /* frame being read from RXFIFO, handed from IEEE802154_receiveFrame() to IEEE802154_receiveFrameEnd() */
+  IEEE802154_DataFrameHeader_t *rxFrame;
+  uint8_t rxFrameLength;
+  uint8_t rxPayloadLength;
+#ifdef IEEE802154_ENABLE_DUPLICATE_FILTER
+  IEEE802154_DuplicateEntry_t duplicateCache[IEEE802154_DUPLICATE_CACHE_SIZE];
+  IEEE802154_DuplicateEntry_t *rxDuplicateEntry;  /**< cache entry updated once the CRC of rxFrame is known */
+  IEEE802154_Timestamp_t rxTimestamp;
+  uint16_t duplicateHits;
+  uint16_t duplicateMisses;
+#endif
+#ifdef IEEE802154_ENABLE_SOFTWARE_CRC
+  uint16_t rxFcs;                       /**< FCS over bytes read from RXFIFO since start of frame */
+  uint16_t txFcs;                       /**< FCS over bytes written to TXFIFO since length byte */
+#endif
+#ifdef IEEE802154_ENABLE_RX_QUEUE
+  IEEE802154_RxQueueSlot_t rxQueue[IEEE802154_RX_QUEUE_SIZE];
+  volatile uint8_t rxQueueHead;         /**< free running index of next slot filled by ISR */
+  volatile uint8_t rxQueueTail;         /**< free running index of oldest slot not yet released by application */
+  uint8_t rxQueueDropped;
+#endif
+#ifdef IEEE802154_ENABLE_SECURITY
+  uint8_t securedFrame[IEEE802154_MAX_PHY_PACKET_SIZE];  /**< frame secured before it is written to TXFIFO */
+#endif
+#if defined(IEEE802154_ENABLE_SCATTER_GATHER) && !defined(IEEE802154_ENABLE_RX_QUEUE)
+  const IEEE802154_Segment_t *rxSegments;  /**< receive segments of data frames, NULL: IEEE802154_RxDataFrame.payload */
+  uint16_t rxSegmentsCapacity;          /**< sum of length of receive segments */
+#endif
+  /* IEEE_802.15.4_Address.c */
+#ifdef IEEE802154_ENABLE_ADDRESS_INTERNING
+  IEEE802154_ExtendedAddress_t addressTable[IEEE802154_ADDRESS_TABLE_SIZE];
+  uint8_t addressReferences[IEEE802154_ADDRESS_TABLE_SIZE];  /**< 0 marks a free entry */
+#endif
+  /* IEEE_802.15.4_Neighbor.c */
+#ifdef IEEE802154_ENABLE_NEIGHBOR_TABLE
+  IEEE802154_NeighborEntry_t neighborTable[IEEE802154_NEIGHBOR_TABLE_SIZE];
+#endif
+  /* IEEE_802.15.4_SrcMatch.c */
+#ifdef IEEE802154_ENABLE_SOURCE_MATCH
+  uint32_t srcMatchUsed;                /**< short sized slots of the address table in use */
+  uint32_t srcMatchShortEnable;         /**< shadow of SRCSHORTEN */
+  uint32_t srcMatchExtendedEnable;      /**< shadow of SRCEXTEN, bit 2n for extended entry n */
+  uint32_t srcMatchShortPending;        /**< shadow of SRCSHORTPENDEN */
+  uint32_t srcMatchExtendedPending;     /**< shadow of SRCEXTPENDEN */
+#endif
+#ifdef IEEE802154_ENABLE_INDIRECT_QUEUE
+  IEEE802154_IndirectFrame_t indirectPool[IEEE802154_INDIRECT_POOL_SIZE];
+  uint8_t indirectFree;                 /**< first unused frame of pool */
+  uint8_t indirectHead[IEEE802154_SRCMATCH_SHORT_ENTRIES + IEEE802154_SRCMATCH_EXTENDED_ENTRIES];
+#endif
+  /* IEEE_802.15.4_Security.c */
+#ifdef IEEE802154_ENABLE_SECURITY
+  uint32_t securityFrameCounter;
+  IEEE802154_SecurityDevice_t securityDevices[IEEE802154_SECURITY_DEVICE_TABLE_SIZE];
+  uint8_t securityKeyLoaded;
+  uint8_t securityBuffer[IEEE802154_MAX_PHY_PACKET_SIZE];  /**< additional data of received frames */
+#ifdef IEEE802154_SOFTWARE_AES
+  uint8_t aesRoundKeys[11 * IEEE802154_AES_BLOCK_SIZE];
+#endif
+#endif
+  /* IEEE_802.15.4_Sniffer.c */
+#ifdef IEEE802154_ENABLE_SNIFFER
+  volatile uint8_t snifferActive;
+  uint16_t snifferDropped;
+  uint8_t snifferBuffer[IEEE802154_SNIFFER_BUFFER_SIZE];
+  volatile uint16_t snifferHead;        /**< free running index of next byte written by ISR */
+  volatile uint16_t snifferTail;        /**< free running index of oldest byte not yet read */
+  uint8_t snifferFrmfilt0;              /**< FRMFILT0 before sniffer was started */
+  uint8_t snifferFrmctrl0;              /**< FRMCTRL0 before sniffer was started */
+#endif
+  /* IEEE_802.15.4_Lowpan.c */
+#ifdef IEEE802154_ENABLE_LOWPAN
+  uint16_t lowpanReassembled;
+  uint16_t lowpanTimeouts;
+  uint16_t lowpanDropped;
+  IEEE802154_LowpanReassembly_t lowpanReassembly[IEEE802154_LOWPAN_REASSEMBLY_BUFFERS];
+  uint8_t lowpanPacket[IEEE802154_LOWPAN_FRAME_PACKET_SIZE];  /**< unfragmented packet decompressed for delivery */
+  uint16_t lowpanTag;                   /**< datagram tag of next fragmented packet */
+#endif
+#ifdef IEEE802154_SIMULATION
+  IEEE802154_Sim_t sim;                 /**< emulated radio, IEEE_802.15.4_Sim.c */
+#endif
+} IEEE802154_Context_t;
+
 /*******************| Global variables |*******************************/
+extern const IEEE802154_FrameLayout_t IEEE802154_frameLayout[32];
+extern const uint16_t IEEE802154_crc16Table[256];
+
+/**
+ * Context of the MAC, the only one unless IEEE802154_ENABLE_NETSIM is defined.
+ */
+extern IEEE802154_Context_t IEEE802154_Context;
+#ifdef IEEE802154_ENABLE_NETSIM
+/**
+ * Context the calling thread works on, IEEE802154_Context until it is changed.
+ */
+extern __thread IEEE802154_Context_t *IEEE802154_Instance;
+#else
+#define IEEE802154_Instance                     (&IEEE802154_Context)
+#endif
+
+#ifndef IEEE802154_ENABLE_NETSIM
 /**
  * Variable used to sent data via IEEE 802.15.4. Module only provides declaration, definition
  * must be done by application. Important: Not only definition but also valid payload pointer
- * must be provided.
+ * must be provided. With IEEE802154_ENABLE_NETSIM it is part of the context.
  */
 extern IEEE802154_DataFrameHeader_t  IEEE802154_TxDataFrame; 
+#ifndef IEEE802154_ENABLE_RX_QUEUE
 /**
  * Variable used to receive data via IEEE 802.15.4. Module only provides declaration, definition
  * must be done by application. Important: Not only definition but also valid payload pointer
- * must be provided.
+ * must be provided. With IEEE802154_ENABLE_NETSIM it is part of the context.
  */
 extern IEEE802154_DataFrameHeader_t  IEEE802154_RxDataFrame;
+#endif
+#else
+#define IEEE802154_TxDataFrame                  (IEEE802154_Instance->txDataFrame)
+#define IEEE802154_RxDataFrame                  (IEEE802154_Instance->rxDataFrame)
+#endif
+#ifdef IEEE802154_ENABLE_RX_QUEUE
+/**
+ * Number of frames dropped because the receive queue was full or the payload did
+ * not fit into a slot.
+ */
+#define IEEE802154_RxQueueDropped               (IEEE802154_Instance->rxQueueDropped)
+#endif
+#ifdef IEEE802154_ENABLE_DUPLICATE_FILTER
+/**
+ * Frames dropped as duplicates and frames checked against the cache without a match.
+ */
+#define IEEE802154_DuplicateHits                (IEEE802154_Instance->duplicateHits)
+#define IEEE802154_DuplicateMisses              (IEEE802154_Instance->duplicateMisses)
+#endif
+#ifdef IEEE802154_ENABLE_CSMA
+/**
+ * Parameters of the CSMA-CA engine, may be changed while no transmission is pending.
+ */
+#define IEEE802154_CsmaConfig                   (IEEE802154_Instance->csmaConfig)
+/**
+ * Result of the last transmission, one of IEEE802154_TX_SUCCESS,
+ * IEEE802154_TX_CHANNEL_ACCESS_FAILURE or IEEE802154_TX_NO_ACK.
+ */
+#define IEEE802154_TxStatus                     (IEEE802154_Instance->txStatus)
+#endif
+#ifdef IEEE802154_ENABLE_RX_DRAIN
+/**
+ * Number of frames handled by the last RF interrupt and maximum number of frames
+ * handled by a single RF interrupt since startup.
+ */
+#define IEEE802154_RxFramesPerInterrupt         (IEEE802154_Instance->rxFramesPerInterrupt)
+#define IEEE802154_RxFramesPerInterruptMax      (IEEE802154_Instance->rxFramesPerInterruptMax)
+#endif
+#ifdef IEEE802154_ENABLE_SECURITY
+/**
+ * Frame counter of the next secured frame sent. The application should keep it in
+ * non-volatile memory and restore it after IEEE802154_radioInit().
+ */
+#define IEEE802154_SecurityFrameCounter         (IEEE802154_Instance->securityFrameCounter)
+#endif
+#ifdef IEEE802154_ENABLE_SNIFFER
+/**
+ * Set while sniffer is running, frames dropped as the sniffer buffer was full or RXFIFO
+ * overflowed.
+ */
+#define IEEE802154_SnifferActive                (IEEE802154_Instance->snifferActive)
+#define IEEE802154_SnifferDropped               (IEEE802154_Instance->snifferDropped)
+#endif
 
 
 /*******************| Function prototypes |****************************/
 void IEEE802154_radioInit(IEEE802154_Config_t *config);
-void IEEE802154_radioSentDataFrame(IEEE802154_DataFrameHeader_t* header, uint8_t payloadLength);
+uint8_t IEEE802154_radioSentDataFrame(IEEE802154_DataFrameHeader_t* header, uint8_t payloadLength);
 void IEEE802154_retransmit();
+uint8_t IEEE802154_radioSetChannel(uint8_t channel);
+uint8_t IEEE802154_radioGetChannel(void);
+#ifdef IEEE802154_ENABLE_ED_SCAN
+uint8_t IEEE802154_edScan(uint32_t channels, uint8_t dwell, uint8_t mode, IEEE802154_EdScanReport_t *report);
+#endif
+uint8_t IEEE802154_frameViewInit(IEEE802154_FrameView_t *view, uint8_t *frame, uint8_t length);
+IEEE802154_PANIdentifier_t IEEE802154_frameViewDestinationPANID(const IEEE802154_FrameView_t *view);
+IEEE802154_PANIdentifier_t IEEE802154_frameViewSourcePANID(const IEEE802154_FrameView_t *view);
+uint8_t* IEEE802154_frameViewDestinationAddress(const IEEE802154_FrameView_t *view);
+uint8_t* IEEE802154_frameViewSourceAddress(const IEEE802154_FrameView_t *view);
+uint8_t IEEE802154_serializeHeader(const IEEE802154_DataFrameHeader_t *header, uint8_t *buffer);
+uint8_t IEEE802154_flowPrepare(IEEE802154_Flow_t *flow, const IEEE802154_DataFrameHeader_t *header);
+uint8_t IEEE802154_flowSent(IEEE802154_Flow_t *flow, IEEE802154_PayloadPointer payload, uint8_t payloadLength);
+uint16_t IEEE802154_crc16(uint16_t crc, const uint8_t *data, uint8_t length);
+#ifdef IEEE802154_ENABLE_STATISTICS
+void IEEE802154_statisticsSnapshot(IEEE802154_Statistics_t *snapshot);
+void IEEE802154_statisticsReset(void);
+#endif
+#ifdef IEEE802154_ENABLE_SNIFFER
+void IEEE802154_snifferStart(void);
+void IEEE802154_snifferStop(void);
+void IEEE802154_snifferDrain(void);
+uint8_t IEEE802154_snifferPcapHeader(uint8_t *buffer);
+uint8_t IEEE802154_snifferPcapRecord(uint8_t *buffer);
+#endif
+#ifdef IEEE802154_ENABLE_SECURITY
+void IEEE802154_securityInit(void);
+void IEEE802154_securitySetKey(const uint8_t *key);
+uint8_t IEEE802154_securityDeviceAdd(const IEEE802154_ExtendedAddress_t extendedAddress, IEEE802154_ShortAddress_t shortAddress);
+void IEEE802154_securityDeviceRemove(uint8_t index);
+uint8_t IEEE802154_securityAuxHeaderSerialize(const IEEE802154_AuxSecurityHeader_t *header, uint8_t *buffer);
+uint8_t IEEE802154_securityAuxHeaderParse(IEEE802154_AuxSecurityHeader_t *header, const uint8_t *buffer, uint8_t length);
+uint8_t IEEE802154_ccmStar(const uint8_t *nonce, const uint8_t *a, uint8_t aLength, uint8_t *m, uint8_t mLength,
+                           uint8_t *mic, uint8_t micLength, uint8_t decrypt);
+uint8_t IEEE802154_securityOutgoingFrame(IEEE802154_DataFrameHeader_t *header, uint8_t payloadLength, uint8_t *frame, uint8_t *frameLength);
+uint8_t IEEE802154_securityIncomingFrame(IEEE802154_DataFrameHeader_t *frame, uint8_t *payloadLength);
+#endif
+#ifdef IEEE802154_ENABLE_ADDRESS_INTERNING
+void IEEE802154_addressInit(void);
+uint8_t IEEE802154_addressIntern(const IEEE802154_ExtendedAddress_t address);
+uint8_t IEEE802154_addressFind(const IEEE802154_ExtendedAddress_t address);
+void IEEE802154_addressRelease(uint8_t handle);
+const uint8_t* IEEE802154_addressLookup(uint8_t handle);
+uint8_t IEEE802154_addressCompact(IEEE802154_CompactAddress_t *compact, const IEEE802154_Adress_t *address, uint8_t addressMode);
+void IEEE802154_addressExpand(IEEE802154_Adress_t *address, const IEEE802154_CompactAddress_t *compact, uint8_t addressMode);
+#endif
+#ifdef IEEE802154_ENABLE_NEIGHBOR_TABLE
+void IEEE802154_neighborInit(void);
+void IEEE802154_neighborUpdate(const IEEE802154_DataFrameHeader_t *frame, sint8_t rssi, uint8_t lqi, IEEE802154_Timestamp_t now);
+const IEEE802154_NeighborEntry_t* IEEE802154_neighborFind(const IEEE802154_Adress_t *address, uint8_t addressMode);
+const IEEE802154_NeighborEntry_t* IEEE802154_neighborGet(uint8_t index);
+#endif
+#ifdef IEEE802154_ENABLE_SOURCE_MATCH
+void IEEE802154_srcMatchInit(void);
+uint8_t IEEE802154_srcMatchAddShort(IEEE802154_PANIdentifier_t panId, IEEE802154_ShortAddress_t address);
+uint8_t IEEE802154_srcMatchAddExtended(const IEEE802154_ExtendedAddress_t address);
+uint8_t IEEE802154_srcMatchFind(const IEEE802154_DataFrameHeader_t *frame);
+void IEEE802154_srcMatchRemove(uint8_t entry);
+void IEEE802154_srcMatchSetPending(uint8_t entry, uint8_t pending);
+#endif
+#ifdef IEEE802154_ENABLE_INDIRECT_QUEUE
+uint8_t IEEE802154_indirectQueue(uint8_t entry, IEEE802154_DataFrameHeader_t *header, uint8_t payloadLength);
+uint8_t IEEE802154_indirectPending(uint8_t entry);
+void IEEE802154_indirectFlush(uint8_t entry);
+void IEEE802154_indirectDataRequest(const IEEE802154_DataFrameHeader_t *frame);
+uint8_t IEEE802154_radioSentIndirectFrameAsync(IEEE802154_DataFrameHeader_t* header, uint8_t payloadLength, uint8_t framePending);
+#endif
+#ifdef IEEE802154_ENABLE_CRC32
+uint32_t IEEE802154_crc32(uint32_t crc, const uint8_t *data, uint8_t length);
+#endif
+#ifdef IEEE802154_ENABLE_TX_QUEUE
+uint8_t IEEE802154_radioSentDataFrameAsync(IEEE802154_DataFrameHeader_t* header, uint8_t payloadLength);
+uint8_t IEEE802154_flowSentAsync(IEEE802154_Flow_t *flow, IEEE802154_PayloadPointer payload, uint8_t payloadLength);
+uint8_t IEEE802154_txQueuePending(void);
+#endif
+#ifdef IEEE802154_ENABLE_SCATTER_GATHER
+uint8_t IEEE802154_radioSentDataFrameSegments(IEEE802154_DataFrameHeader_t* header, const IEEE802154_Segment_t *segments, uint8_t segmentCount);
+#ifdef IEEE802154_ENABLE_TX_QUEUE
+uint8_t IEEE802154_radioSentDataFrameSegmentsAsync(IEEE802154_DataFrameHeader_t* header, const IEEE802154_Segment_t *segments, uint8_t segmentCount);
+#endif
+#ifndef IEEE802154_ENABLE_RX_QUEUE
+void IEEE802154_radioSetRxSegments(const IEEE802154_Segment_t *segments, uint8_t segmentCount);
+#endif
+#endif
+#ifdef IEEE802154_ENABLE_RX_QUEUE
+uint8_t IEEE802154_rxQueuePoll(void);
+IEEE802154_RxQueueSlot_t* IEEE802154_rxQueuePeek(void);
+void IEEE802154_rxQueueRelease(void);
+#endif
 
 /* callbacks from Rx ISR to notify application */
 extern void IEEE802154_UserCbk_BeaconFrameReceived(uint8_t payloadLength, sint8_t rssi);
@@ -211,6 +1210,11 @@ extern void IEEE802154_UserCbk_DataFrameReceived(uint8_t payloadLength, sint8_t
 extern void IEEE802154_UserCbk_AckFrameReceived(uint8_t payloadLength, sint8_t rssi);
 extern void IEEE802154_UserCbk_MACCommandFrameReceived(uint8_t payloadLength, sint8_t rssi);
 extern void IEEE802154_UserCbk_CRCError(uint8_t payloadLength, sint8_t rssi);
+#ifdef IEEE802154_ENABLE_TX_QUEUE
+/* callback from RF ISR when a frame of the transmit queue has been sent */
+extern void IEEE802154_UserCbk_DataFrameSent(IEEE802154_DataFrameHeader_t* header, uint8_t status);
+extern void IEEE802154_UserCbk_FlowFrameSent(IEEE802154_Flow_t *flow, uint8_t sequenceNumber, uint8_t status);
+#endif
 
 
 #endif
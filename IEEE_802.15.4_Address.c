@@ -0,0 +1,199 @@
+/** @ingroup IEEE_802.15.4
+ * @{
+ */
+/*******************| Inclusions |*************************************/
+#include "IEEE_802.15.4.h"
+#include "IEEE_802.15.4_Radio.h"
+#include <stddef.h>
+
+/**
+ * Interning of extended addresses. Each extended address is stored once and referenced
+ * by its handle, the index into the table. Entries are reference counted, an entry is
+ * free again when its last reference is released. Lookup starts at a position derived
+ * from the address so a known address is usually found with one comparison.
+ * The table is used by the ISRs receiving frames (neighbor table), the application must
+ * call IEEE802154_addressIntern() and IEEE802154_addressRelease() inside
+ * IEEE802154_CRITICAL_ENTER() and IEEE802154_CRITICAL_EXIT().
+ * Only compiled in if IEEE802154_ENABLE_ADDRESS_INTERNING is defined.
+*/
+#ifdef IEEE802154_ENABLE_ADDRESS_INTERNING
+
+/*******************| Macros |*****************************************/
+
+/*******************| Type definitions |*******************************/
+
+/*******************| Global variables |*******************************/
+#define IEEE802154_addressTable                 (IEEE802154_Instance->addressTable)
+#define IEEE802154_addressReferences            (IEEE802154_Instance->addressReferences)
+
+/*******************| Function definition |****************************/
+
+/**
+ * Marks all entries free.
+*/
+void IEEE802154_addressInit(void)
+{
+  uint8_t i;
+  for (i=0; i<IEEE802154_ADDRESS_TABLE_SIZE; i++)
+  {
+    IEEE802154_addressReferences[i] = 0;
+  }
+}
+
+/**
+ * @return position lookup of the address starts at
+*/
+static uint8_t IEEE802154_addressHash(const IEEE802154_ExtendedAddress_t address)
+{
+  uint8_t i;
+  uint8_t hash = 0;
+  for (i=0; i<sizeof(IEEE802154_ExtendedAddress_t); i++)
+  {
+    hash ^= address[i];
+  }
+  return hash % IEEE802154_ADDRESS_TABLE_SIZE;
+}
+
+/**
+ * @return 1 if entry holds the address
+*/
+static uint8_t IEEE802154_addressMatch(uint8_t handle, const IEEE802154_ExtendedAddress_t address)
+{
+  uint8_t i;
+  for (i=0; i<sizeof(IEEE802154_ExtendedAddress_t); i++)
+  {
+    if (IEEE802154_addressTable[handle][i] != address[i])
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/**
+ * Looks up an extended address without taking a reference.
+ * @return handle of address, IEEE802154_ADDRESS_HANDLE_INVALID if it is not interned
+*/
+uint8_t IEEE802154_addressFind(const IEEE802154_ExtendedAddress_t address)
+{
+  uint8_t i;
+  uint8_t handle = IEEE802154_addressHash(address);
+  for (i=0; i<IEEE802154_ADDRESS_TABLE_SIZE; i++)
+  {
+    if ((IEEE802154_addressReferences[handle] != 0) && IEEE802154_addressMatch(handle, address))
+    {
+      return handle;
+    }
+    if (++handle == IEEE802154_ADDRESS_TABLE_SIZE)
+    {
+      handle = 0;
+    }
+  }
+  return IEEE802154_ADDRESS_HANDLE_INVALID;
+}
+
+/**
+ * Takes a reference to an extended address, the address is added if it is not interned
+ * yet. Each successful call must be balanced by IEEE802154_addressRelease().
+ * @return handle of address, IEEE802154_ADDRESS_HANDLE_INVALID if table is full
+*/
+uint8_t IEEE802154_addressIntern(const IEEE802154_ExtendedAddress_t address)
+{
+  uint8_t i;
+  uint8_t handle = IEEE802154_addressFind(address);
+  if (handle == IEEE802154_ADDRESS_HANDLE_INVALID)
+  {
+    /* first free entry from the position of the address on */
+    handle = IEEE802154_addressHash(address);
+    for (i=0; IEEE802154_addressReferences[handle] != 0; i++)
+    {
+      if (i == IEEE802154_ADDRESS_TABLE_SIZE - 1)
+      {
+        return IEEE802154_ADDRESS_HANDLE_INVALID;
+      }
+      if (++handle == IEEE802154_ADDRESS_TABLE_SIZE)
+      {
+        handle = 0;
+      }
+    }
+    for (i=0; i<sizeof(IEEE802154_ExtendedAddress_t); i++)
+    {
+      IEEE802154_addressTable[handle][i] = address[i];
+    }
+  }
+  else if (IEEE802154_addressReferences[handle] == 0xFF)
+  {
+    /* reference count would overflow */
+    return IEEE802154_ADDRESS_HANDLE_INVALID;
+  }
+  IEEE802154_addressReferences[handle]++;
+  return handle;
+}
+
+/**
+ * Drops a reference taken by IEEE802154_addressIntern().
+*/
+void IEEE802154_addressRelease(uint8_t handle)
+{
+  if ((handle < IEEE802154_ADDRESS_TABLE_SIZE) && (IEEE802154_addressReferences[handle] != 0))
+  {
+    IEEE802154_addressReferences[handle]--;
+  }
+}
+
+/**
+ * @return extended address of a handle, NULL if handle is not in use
+*/
+const uint8_t* IEEE802154_addressLookup(uint8_t handle)
+{
+  if ((handle >= IEEE802154_ADDRESS_TABLE_SIZE) || (IEEE802154_addressReferences[handle] == 0))
+  {
+    return NULL;
+  }
+  return IEEE802154_addressTable[handle];
+}
+
+/**
+ * Converts an address to its compact form. An extended address is interned and must be
+ * released by IEEE802154_addressRelease() when the compact address is dropped.
+ * @param compact converted address
+ * @param address short or extended address
+ * @param addressMode IEEE802154_FCF_ADDRESS_MODE_16BIT or IEEE802154_FCF_ADDRESS_MODE_64BIT
+ * @return 1 on success, 0 if address table is full
+*/
+uint8_t IEEE802154_addressCompact(IEEE802154_CompactAddress_t *compact, const IEEE802154_Adress_t *address, uint8_t addressMode)
+{
+  if (addressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
+  {
+    compact->shortAddress = address->shortAddress;
+    return 1;
+  }
+  compact->handle = IEEE802154_addressIntern(address->extendedAdress);
+  return compact->handle != IEEE802154_ADDRESS_HANDLE_INVALID;
+}
+
+/**
+ * Converts a compact address back to a short or extended address.
+ * @param address converted address
+ * @param compact address created by IEEE802154_addressCompact()
+ * @param addressMode address mode the compact address was created with
+*/
+void IEEE802154_addressExpand(IEEE802154_Adress_t *address, const IEEE802154_CompactAddress_t *compact, uint8_t addressMode)
+{
+  uint8_t i;
+  const uint8_t *extended;
+  if (addressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
+  {
+    address->shortAddress = compact->shortAddress;
+    return;
+  }
+  extended = IEEE802154_addressLookup(compact->handle);
+  for (i=0; i<sizeof(IEEE802154_ExtendedAddress_t); i++)
+  {
+    address->extendedAdress[i] = (extended != NULL) ? extended[i] : 0;
+  }
+}
+
+#endif
+
+/** @}*/
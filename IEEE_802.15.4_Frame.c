@@ -0,0 +1,254 @@
+/** @ingroup IEEE_802.15.4
+ * @{
+ */
+/*******************| Inclusions |*************************************/
+#include "IEEE_802.15.4.h"
+#include "IEEE_802.15.4_Radio.h"
+#include <stddef.h>
+
+/**
+ * Table driven decoding of the MAC header layout. Position of all addressing fields
+ * only depends on destination address mode, source address mode and PAN ID
+ * compression bit of the frame control field (802.15.4-2006 Chapter "7.2.1 General
+ * MAC frame format"), thus all 32 combinations are precomputed and looked up with
+ * IEEE802154_FRAME_LAYOUT_INDEX(). Used by Rx ISR, Tx path and frame view.
+*/
+
+/*******************| Macros |*****************************************/
+#define IEEE802154_ADDRESS_SIZE(mode)                   ((mode) == IEEE802154_FCF_ADDRESS_MODE_16BIT ? sizeof(IEEE802154_ShortAddress_t) : \
+                                                        ((mode) == IEEE802154_FCF_ADDRESS_MODE_64BIT ? sizeof(IEEE802154_ExtendedAddress_t) : 0))
+/* source PAN ID is omitted if PAN ID compression is set and both addresses are present */
+#define IEEE802154_SOURCE_PANID_SIZE(dst, src, comp)    (((src) && !((comp) && (dst))) ? sizeof(IEEE802154_PANIdentifier_t) : 0)
+/* offset behind destination PAN ID and address */
+#define IEEE802154_DESTINATION_END(dst)                 (IEEE802154_FRAME_HEADER_MIN + ((dst) ? sizeof(IEEE802154_PANIdentifier_t) + IEEE802154_ADDRESS_SIZE(dst) : 0))
+
+#define IEEE802154_FRAME_LAYOUT(dst, src, comp) { \
+  (dst) ? IEEE802154_FRAME_HEADER_MIN + sizeof(IEEE802154_PANIdentifier_t) : 0, \
+  IEEE802154_SOURCE_PANID_SIZE(dst, src, comp) ? IEEE802154_DESTINATION_END(dst) : 0, \
+  (src) ? IEEE802154_DESTINATION_END(dst) + IEEE802154_SOURCE_PANID_SIZE(dst, src, comp) : 0, \
+  ((dst) == 1 || (src) == 1) ? 0 : IEEE802154_DESTINATION_END(dst) + IEEE802154_SOURCE_PANID_SIZE(dst, src, comp) + IEEE802154_ADDRESS_SIZE(src) }
+
+/*******************| Type definitions |*******************************/
+
+/*******************| Global variables |*******************************/
+/**
+ * Header layout for all addressing modes. Index is built by IEEE802154_FRAME_LAYOUT_INDEX():
+ * bit 1:0 destination address mode, bit 3:2 source address mode, bit 4 PAN ID compression.
+ * Address mode 1 is reserved, its entries have headerLength 0.
+ */
+const IEEE802154_FrameLayout_t IEEE802154_frameLayout[32] =
+{
+  IEEE802154_FRAME_LAYOUT(0, 0, 0),
+  IEEE802154_FRAME_LAYOUT(1, 0, 0),
+  IEEE802154_FRAME_LAYOUT(2, 0, 0),
+  IEEE802154_FRAME_LAYOUT(3, 0, 0),
+  IEEE802154_FRAME_LAYOUT(0, 1, 0),
+  IEEE802154_FRAME_LAYOUT(1, 1, 0),
+  IEEE802154_FRAME_LAYOUT(2, 1, 0),
+  IEEE802154_FRAME_LAYOUT(3, 1, 0),
+  IEEE802154_FRAME_LAYOUT(0, 2, 0),
+  IEEE802154_FRAME_LAYOUT(1, 2, 0),
+  IEEE802154_FRAME_LAYOUT(2, 2, 0),
+  IEEE802154_FRAME_LAYOUT(3, 2, 0),
+  IEEE802154_FRAME_LAYOUT(0, 3, 0),
+  IEEE802154_FRAME_LAYOUT(1, 3, 0),
+  IEEE802154_FRAME_LAYOUT(2, 3, 0),
+  IEEE802154_FRAME_LAYOUT(3, 3, 0),
+  IEEE802154_FRAME_LAYOUT(0, 0, 1),
+  IEEE802154_FRAME_LAYOUT(1, 0, 1),
+  IEEE802154_FRAME_LAYOUT(2, 0, 1),
+  IEEE802154_FRAME_LAYOUT(3, 0, 1),
+  IEEE802154_FRAME_LAYOUT(0, 1, 1),
+  IEEE802154_FRAME_LAYOUT(1, 1, 1),
+  IEEE802154_FRAME_LAYOUT(2, 1, 1),
+  IEEE802154_FRAME_LAYOUT(3, 1, 1),
+  IEEE802154_FRAME_LAYOUT(0, 2, 1),
+  IEEE802154_FRAME_LAYOUT(1, 2, 1),
+  IEEE802154_FRAME_LAYOUT(2, 2, 1),
+  IEEE802154_FRAME_LAYOUT(3, 2, 1),
+  IEEE802154_FRAME_LAYOUT(0, 3, 1),
+  IEEE802154_FRAME_LAYOUT(1, 3, 1),
+  IEEE802154_FRAME_LAYOUT(2, 3, 1),
+  IEEE802154_FRAME_LAYOUT(3, 3, 1)
+};
+
+/*******************| Function definition |****************************/
+
+/**
+ * Sets up a view on a raw MAC frame. Nothing is copied, all fields are accessed in
+ * place via the accessor functions and IEEE802154_FRAMEVIEW_* macros.
+ * @param view view to set up
+ * @param frame MAC frame starting with frame control field
+ * @param length length of frame without FCS
+ * @return 1 if frame is long enough for its header and uses no reserved address mode,
+ * 0 otherwise
+ */
+uint8_t IEEE802154_frameViewInit(IEEE802154_FrameView_t *view, uint8_t *frame, uint8_t length)
+{
+  const IEEE802154_FrameLayout_t *layout;
+  if (length < IEEE802154_FRAME_HEADER_MIN)
+  {
+    return 0;
+  }
+  layout = &IEEE802154_frameLayout[IEEE802154_FRAME_LAYOUT_INDEX(frame[0], frame[1])];
+  if ((layout->headerLength == 0) || (layout->headerLength > length))
+  {
+    return 0;
+  }
+  view->frame = frame;
+  view->length = length;
+  view->layout = layout;
+  return 1;
+}
+
+/**
+ * Destination PAN ID of frame, #IEEE802154_BROADCAST_PAN_ID if frame has no destination address.
+ */
+IEEE802154_PANIdentifier_t IEEE802154_frameViewDestinationPANID(const IEEE802154_FrameView_t *view)
+{
+  if (view->layout->destinationAddressOffset == 0)
+  {
+    return IEEE802154_BROADCAST_PAN_ID;
+  }
+  return IEEE802154_GET_UINT16(&view->frame[IEEE802154_FRAME_HEADER_MIN]);
+}
+
+/**
+ * Source PAN ID of frame. With PAN ID compression this is the destination PAN ID.
+ */
+IEEE802154_PANIdentifier_t IEEE802154_frameViewSourcePANID(const IEEE802154_FrameView_t *view)
+{
+  if (view->layout->sourcePANIDOffset == 0)
+  {
+    return IEEE802154_frameViewDestinationPANID(view);
+  }
+  return IEEE802154_GET_UINT16(&view->frame[view->layout->sourcePANIDOffset]);
+}
+
+/**
+ * Pointer to destination address in frame, little endian as transmitted. Length is given by
+ * IEEE802154_FRAMEVIEW_DESTINATION_ADDRESS_MODE().
+ * @return pointer into frame or NULL if frame has no destination address
+ */
+uint8_t* IEEE802154_frameViewDestinationAddress(const IEEE802154_FrameView_t *view)
+{
+  if (view->layout->destinationAddressOffset == 0)
+  {
+    return NULL;
+  }
+  return &view->frame[view->layout->destinationAddressOffset];
+}
+
+/**
+ * Pointer to source address in frame, little endian as transmitted. Length is given by
+ * IEEE802154_FRAMEVIEW_SOURCE_ADDRESS_MODE().
+ * @return pointer into frame or NULL if frame has no source address
+ */
+uint8_t* IEEE802154_frameViewSourceAddress(const IEEE802154_FrameView_t *view)
+{
+  if (view->layout->sourceAddressOffset == 0)
+  {
+    return NULL;
+  }
+  return &view->frame[view->layout->sourceAddressOffset];
+}
+
+/**
+ * Copies a short or extended address into a frame buffer, least significant byte first.
+ * @return number of bytes written
+ */
+static uint8_t IEEE802154_serializeAddress(const IEEE802154_Adress_t *address, uint8_t addressMode, uint8_t *buffer)
+{
+  uint8_t i;
+  if (addressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
+  {
+    buffer[0] = LO_UINT16(address->shortAddress);
+    buffer[1] = HI_UINT16(address->shortAddress);
+    return sizeof(IEEE802154_ShortAddress_t);
+  }
+  for( i=0; i< sizeof(IEEE802154_ExtendedAddress_t); i++ )
+  {
+    buffer[i] = address->extendedAdress[i];
+  }
+  return sizeof(IEEE802154_ExtendedAddress_t);
+}
+
+/**
+ * Serializes a MAC header the same way IEEE802154_radioSentDataFrame() writes it to TXFIFO.
+ * @param header header to serialize, payload pointer is not used
+ * @param buffer buffer of at least #IEEE802154_MAX_HEADER_SIZE bytes
+ * @return header length, 0 if a reserved address mode is used
+ */
+uint8_t IEEE802154_serializeHeader(const IEEE802154_DataFrameHeader_t *header, uint8_t *buffer)
+{
+  const uint8_t *fcf = (const uint8_t*)&header->fcf;
+  const IEEE802154_FrameLayout_t *layout = &IEEE802154_frameLayout[IEEE802154_FRAME_LAYOUT_INDEX(fcf[0], fcf[1])];
+  IEEE802154_PANIdentifier_t sourcePANID;
+
+  if (layout->headerLength == 0)
+  {
+    return 0;
+  }
+  buffer[0] = fcf[0];
+  buffer[1] = fcf[1];
+  buffer[2] = header->sequenceNumber;
+  if (layout->destinationAddressOffset != 0)
+  {
+    buffer[IEEE802154_FRAME_HEADER_MIN] = LO_UINT16(header->destinationPANID);
+    buffer[IEEE802154_FRAME_HEADER_MIN + 1] = HI_UINT16(header->destinationPANID);
+    IEEE802154_serializeAddress(&header->destinationAddress, header->fcf.destinationAddressMode, &buffer[layout->destinationAddressOffset]);
+  }
+  if (layout->sourcePANIDOffset != 0)
+  {
+#ifndef IEEE802154_ENABLE_PANID_COMPRESSION
+    sourcePANID = header->sourcePANID;
+#else
+    sourcePANID = header->destinationPANID;
+#endif
+    buffer[layout->sourcePANIDOffset] = LO_UINT16(sourcePANID);
+    buffer[layout->sourcePANIDOffset + 1] = HI_UINT16(sourcePANID);
+  }
+  if (layout->sourceAddressOffset != 0)
+  {
+    IEEE802154_serializeAddress(&header->sourceAddress, header->fcf.sourceAddressMode, &buffer[layout->sourceAddressOffset]);
+  }
+  return layout->headerLength;
+}
+
+/**
+ * Serializes header into flow template. Sequence number of header is used for the
+ * first frame sent with the flow.
+ * @param flow flow to prepare
+ * @param header header used for all frames of flow, payload pointer is not used
+ * @return 1 if successful, 0 if header uses a reserved address mode, has security enabled
+ * or does not match the flow shape selected in Config.h
+ */
+uint8_t IEEE802154_flowPrepare(IEEE802154_Flow_t *flow, const IEEE802154_DataFrameHeader_t *header)
+{
+#ifdef IEEE802154_FLOW_LAYOUT_INDEX
+  const uint8_t *fcf = (const uint8_t*)&header->fcf;
+#endif
+  /* template has no room for auxiliary security header and MIC */
+  if (header->fcf.securityEnabled)
+  {
+    return 0;
+  }
+#ifdef IEEE802154_FLOW_LAYOUT_INDEX
+  if (IEEE802154_FRAME_LAYOUT_INDEX(fcf[0], fcf[1]) != IEEE802154_FLOW_LAYOUT_INDEX)
+  {
+    return 0;
+  }
+  (void)IEEE802154_serializeHeader(header, flow->header);
+#else
+  /* generic flow template has room for the largest header */
+  flow->headerLength = IEEE802154_serializeHeader(header, flow->header);
+  if (flow->headerLength == 0)
+  {
+    return 0;
+  }
+#endif
+  flow->sequenceNumber = header->sequenceNumber;
+  return 1;
+}
+
+/** @}*/
@@ -0,0 +1,941 @@
+/** @ingroup IEEE_802.15.4
+ * @{
+ */
+/*******************| Inclusions |*************************************/
+#include "IEEE_802.15.4.h"
+#include "IEEE_802.15.4_Radio.h"
+#ifdef IEEE802154_ENABLE_LOWPAN
+#include "IEEE_802.15.4_Lowpan.h"
+#endif
+#include <stddef.h>
+
+/**
+ * 6LoWPAN adaptation layer, see IEEE_802.15.4_Lowpan.h. Frames are sent by
+ * IEEE802154_radioSentDataFrameSegments(), compressed header, fragment header and the
+ * data of the packet are passed as segments and not copied. Only compiled in if
+ * IEEE802154_ENABLE_LOWPAN is defined.
+*/
+#ifdef IEEE802154_ENABLE_LOWPAN
+
+/*******************| Macros |*****************************************/
+/* first byte of IPHC: traffic class and flow label, next header, hop limit */
+#define IEEE802154_IPHC_TF_MASK                 (uint8_t)0x18
+#define IEEE802154_IPHC_TF_SHIFT                3
+#define IEEE802154_IPHC_TF_INLINE               (uint8_t)0x00   /**< ECN, DSCP and flow label, 4 bytes */
+#define IEEE802154_IPHC_TF_NO_DSCP              (uint8_t)0x08   /**< ECN and flow label, 3 bytes */
+#define IEEE802154_IPHC_TF_NO_FLOW_LABEL        (uint8_t)0x10   /**< ECN and DSCP, 1 byte */
+#define IEEE802154_IPHC_TF_ELIDED               (uint8_t)0x18
+#define IEEE802154_IPHC_NH                      (uint8_t)0x04   /**< next header compressed by NHC */
+#define IEEE802154_IPHC_HLIM_MASK               (uint8_t)0x03   /**< 0: inline, 1-3: hop limit 1, 64, 255 */
+/* second byte of IPHC: source and destination address */
+#define IEEE802154_IPHC_CID                     (uint8_t)0x80
+#define IEEE802154_IPHC_SAC                     (uint8_t)0x40
+#define IEEE802154_IPHC_SAM_SHIFT               4
+#define IEEE802154_IPHC_M                       (uint8_t)0x08
+#define IEEE802154_IPHC_DAC                     (uint8_t)0x04
+#define IEEE802154_IPHC_DAM_SHIFT               0
+#define IEEE802154_IPHC_AM_MASK                 (uint8_t)0x03
+/* address modes: 0 inline, 1 64 bits, 2 16 bits, 3 elided */
+#define IEEE802154_IPHC_AM_INLINE               (uint8_t)0x00
+#define IEEE802154_IPHC_AM_ELIDED               (uint8_t)0x03
+
+/* NHC UDP header 11110CPP */
+#define IEEE802154_NHC_UDP                      (uint8_t)0xF0
+#define IEEE802154_NHC_UDP_MASK                 (uint8_t)0xF8
+#define IEEE802154_NHC_UDP_CHECKSUM_ELIDED      (uint8_t)0x04
+#define IEEE802154_NHC_UDP_PORTS_MASK           (uint8_t)0x03   /**< 1: destination port 0xF0xx, 2: source port 0xF0xx, 3: both 0xF0Bx */
+#define IEEE802154_NHC_UDP_PORT_PREFIX          (uint16_t)0xF000
+#define IEEE802154_NHC_UDP_PORT_PREFIX_SHORT    (uint16_t)0xF0B0
+
+/* offsets in IPv6 and UDP header */
+#define IEEE802154_IPV6_PAYLOAD_LENGTH          4
+#define IEEE802154_IPV6_NEXT_HEADER             6
+#define IEEE802154_IPV6_HOP_LIMIT               7
+#define IEEE802154_IPV6_SOURCE                  8
+#define IEEE802154_IPV6_DESTINATION             24
+#define IEEE802154_IPV6_ADDRESS_SIZE            16
+#define IEEE802154_UDP_SOURCE_PORT              40
+#define IEEE802154_UDP_DESTINATION_PORT         42
+#define IEEE802154_UDP_LENGTH                   44
+#define IEEE802154_UDP_CHECKSUM                 46
+
+#define IEEE802154_LOWPAN_ADDRESS_UNKNOWN       (uint8_t)0xFF
+
+/*******************| Type definitions |*******************************/
+
+/*******************| Global variables |*******************************/
+#define IEEE802154_lowpanReassembly             (IEEE802154_Instance->lowpanReassembly)
+#define IEEE802154_lowpanPacket                 (IEEE802154_Instance->lowpanPacket)
+#define IEEE802154_lowpanTag                    (IEEE802154_Instance->lowpanTag)
+
+/* inline part of an address by address mode: first byte of the address carried inline,
+ * multicast addresses carry their second byte inline in mode 1 and 2 as well */
+static const uint8_t IEEE802154_lowpanUnicastInline[4] = { 0, 8, 14, 16 };
+static const uint8_t IEEE802154_lowpanMulticastInline[4] = { 0, 11, 13, 15 };
+/* link-local prefix fe80::/64 followed by the first 6 bytes of an IID derived from a short address */
+static const uint8_t IEEE802154_lowpanLinkLocal[14] = { 0xFE, 0x80, 0, 0, 0, 0, 0, 0, 0x00, 0x00, 0x00, 0xFF, 0xFE, 0x00 };
+/* inline length of traffic class and flow label by TF */
+static const uint8_t IEEE802154_lowpanTfLength[4] = { 4, 3, 1, 0 };
+static const uint8_t IEEE802154_lowpanHopLimit[4] = { 0, 1, 64, 255 };
+
+/*******************| Function definition |****************************/
+
+/**
+ * Frees all reassembly buffers.
+*/
+void IEEE802154_lowpanInit(void)
+{
+  uint8_t i;
+  for (i=0; i<IEEE802154_LOWPAN_REASSEMBLY_BUFFERS; i++)
+  {
+    IEEE802154_lowpanReassembly[i].size = 0;
+  }
+}
+
+/**
+ * @return 1 if length bytes of data are 0
+*/
+static uint8_t IEEE802154_lowpanIsZero(const uint8_t *data, uint8_t length)
+{
+  uint8_t i;
+  for (i=0; i<length; i++)
+  {
+    if (data[i] != 0)
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/**
+ * Derives the interface identifier of a link-local address from a MAC address, see
+ * RFC 6282 Chapter 3.2.2: the EUI-64 with universal/local bit inverted or
+ * 0000:00ff:fe00:XXXX for a short address.
+ * @param iid 8 bytes interface identifier
+ * @return 0 if the frame does not carry the address
+*/
+static uint8_t IEEE802154_lowpanIid(uint8_t *iid, const IEEE802154_Adress_t *address, uint8_t addressMode)
+{
+  uint8_t i;
+  if (addressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT)
+  {
+    /* extended address is stored in transmitted order, least significant byte first */
+    for (i=0; i<sizeof(IEEE802154_ExtendedAddress_t); i++)
+    {
+      iid[i] = address->extendedAdress[sizeof(IEEE802154_ExtendedAddress_t) - 1 - i];
+    }
+    iid[0] ^= 0x02;
+    return 1;
+  }
+  if (addressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
+  {
+    for (i=0; i<6; i++)
+    {
+      iid[i] = IEEE802154_lowpanLinkLocal[8 + i];
+    }
+    iid[6] = HI_UINT16(address->shortAddress);
+    iid[7] = LO_UINT16(address->shortAddress);
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * Selects the address mode of SAM or DAM for a unicast address.
+ * @param address IPv6 address
+ * @param macAddress MAC address of frame the address belongs to
+ * @param macAddressMode address mode of MAC address
+ * @return address mode, the address is carried inline from
+ * IEEE802154_lowpanUnicastInline[mode]
+*/
+static uint8_t IEEE802154_lowpanUnicastMode(const uint8_t *address, const IEEE802154_Adress_t *macAddress, uint8_t macAddressMode)
+{
+  uint8_t iid[8];
+  uint8_t i;
+  for (i=0; i<8; i++)
+  {
+    if (address[i] != IEEE802154_lowpanLinkLocal[i])
+    {
+      return IEEE802154_IPHC_AM_INLINE;
+    }
+  }
+  if (IEEE802154_lowpanIid(iid, macAddress, macAddressMode))
+  {
+    for (i=0; (i<8) && (address[8 + i] == iid[i]); i++) ;
+    if (i == 8)
+    {
+      return IEEE802154_IPHC_AM_ELIDED;
+    }
+  }
+  for (i=8; (i<14) && (address[i] == IEEE802154_lowpanLinkLocal[i]); i++) ;
+  return (i == 14) ? 2 : 1;
+}
+
+/**
+ * Selects DAM for a multicast address: ff02::00XX, ffXX::00XX:XXXX, ffXX::00XX:XXXX:XXXX
+ * or inline.
+*/
+static uint8_t IEEE802154_lowpanMulticastMode(const uint8_t *address)
+{
+  if ((address[1] == 0x02) && IEEE802154_lowpanIsZero(&address[2], 13))
+  {
+    return 3;
+  }
+  if (IEEE802154_lowpanIsZero(&address[2], 11))
+  {
+    return 2;
+  }
+  if (IEEE802154_lowpanIsZero(&address[2], 9))
+  {
+    return 1;
+  }
+  return IEEE802154_IPHC_AM_INLINE;
+}
+
+/**
+ * Compresses IPv6 header and, if the next header is UDP, the UDP header by IPHC and NHC.
+ * The addresses are compared with the MAC addresses of the frame the packet is sent in.
+ * The payload length of the IPv6 and the UDP header is taken from packetLength.
+ * @param header header of frame the packet is sent in
+ * @param packet IPv6 packet
+ * @param packetLength length of packet
+ * @param buffer compressed header, at least IEEE802154_LOWPAN_HEADER_MAX_SIZE bytes
+ * @param headerLength set to number of bytes of packet covered by the compressed header
+ * @return length of compressed header, 0 if packet is no IPv6 packet
+*/
+uint8_t IEEE802154_lowpanCompress(const IEEE802154_DataFrameHeader_t *header, const uint8_t *packet, uint16_t packetLength, uint8_t *buffer, uint8_t *headerLength)
+{
+  uint8_t *inlineField = &buffer[2];
+  uint8_t trafficClass;
+  uint8_t ecnDscp;
+  uint8_t flowLabel[3];
+  uint8_t mode;
+  uint8_t i;
+  uint16_t sourcePort;
+  uint16_t destinationPort;
+  uint8_t udp;
+
+  if ((packetLength < IEEE802154_LOWPAN_IPV6_HEADER_SIZE) || ((packet[0] & 0xF0) != 0x60))
+  {
+    return 0;
+  }
+  buffer[0] = IEEE802154_LOWPAN_DISPATCH_IPHC;
+  buffer[1] = 0;
+
+  /* traffic class is carried as ECN and DSCP */
+  trafficClass = (uint8_t)((packet[0] << 4) | (packet[1] >> 4));
+  ecnDscp = (uint8_t)((trafficClass << 6) | (trafficClass >> 2));
+  flowLabel[0] = packet[1] & 0x0F;
+  flowLabel[1] = packet[2];
+  flowLabel[2] = packet[3];
+  if (IEEE802154_lowpanIsZero(flowLabel, 3))
+  {
+    if (trafficClass == 0)
+    {
+      buffer[0] |= IEEE802154_IPHC_TF_ELIDED;
+    }
+    else
+    {
+      buffer[0] |= IEEE802154_IPHC_TF_NO_FLOW_LABEL;
+      *inlineField++ = ecnDscp;
+    }
+  }
+  else if ((trafficClass >> 2) == 0)
+  {
+    buffer[0] |= IEEE802154_IPHC_TF_NO_DSCP;
+    *inlineField++ = (uint8_t)(ecnDscp & 0xC0) | flowLabel[0];
+    *inlineField++ = flowLabel[1];
+    *inlineField++ = flowLabel[2];
+  }
+  else
+  {
+    *inlineField++ = ecnDscp;
+    *inlineField++ = flowLabel[0];
+    *inlineField++ = flowLabel[1];
+    *inlineField++ = flowLabel[2];
+  }
+
+  /* UDP header is compressed if its length field matches the packet */
+  udp = (packet[IEEE802154_IPV6_NEXT_HEADER] == IEEE802154_LOWPAN_NEXT_HEADER_UDP) &&
+        (packetLength >= IEEE802154_LOWPAN_IPV6_HEADER_SIZE + IEEE802154_LOWPAN_UDP_HEADER_SIZE) &&
+        (packet[IEEE802154_UDP_LENGTH] == HI_UINT16(packetLength - IEEE802154_LOWPAN_IPV6_HEADER_SIZE)) &&
+        (packet[IEEE802154_UDP_LENGTH + 1] == LO_UINT16(packetLength - IEEE802154_LOWPAN_IPV6_HEADER_SIZE));
+  if (udp)
+  {
+    buffer[0] |= IEEE802154_IPHC_NH;
+  }
+  else
+  {
+    *inlineField++ = packet[IEEE802154_IPV6_NEXT_HEADER];
+  }
+
+  for (mode=IEEE802154_IPHC_HLIM_MASK; mode>0; mode--)
+  {
+    if (packet[IEEE802154_IPV6_HOP_LIMIT] == IEEE802154_lowpanHopLimit[mode])
+    {
+      break;
+    }
+  }
+  buffer[0] |= mode;
+  if (mode == 0)
+  {
+    *inlineField++ = packet[IEEE802154_IPV6_HOP_LIMIT];
+  }
+
+  /* source address, the unspecified address is elided with SAC */
+  if (IEEE802154_lowpanIsZero(&packet[IEEE802154_IPV6_SOURCE], IEEE802154_IPV6_ADDRESS_SIZE))
+  {
+    buffer[1] |= IEEE802154_IPHC_SAC;
+  }
+  else
+  {
+    mode = IEEE802154_lowpanUnicastMode(&packet[IEEE802154_IPV6_SOURCE], &header->sourceAddress, header->fcf.sourceAddressMode);
+    buffer[1] |= (uint8_t)(mode << IEEE802154_IPHC_SAM_SHIFT);
+    for (i=IEEE802154_lowpanUnicastInline[mode]; i<IEEE802154_IPV6_ADDRESS_SIZE; i++)
+    {
+      *inlineField++ = packet[IEEE802154_IPV6_SOURCE + i];
+    }
+  }
+
+  /* destination address */
+  if (packet[IEEE802154_IPV6_DESTINATION] == 0xFF)
+  {
+    mode = IEEE802154_lowpanMulticastMode(&packet[IEEE802154_IPV6_DESTINATION]);
+    buffer[1] |= IEEE802154_IPHC_M | (uint8_t)(mode << IEEE802154_IPHC_DAM_SHIFT);
+    if ((mode == 1) || (mode == 2))
+    {
+      *inlineField++ = packet[IEEE802154_IPV6_DESTINATION + 1];
+    }
+    for (i=IEEE802154_lowpanMulticastInline[mode]; i<IEEE802154_IPV6_ADDRESS_SIZE; i++)
+    {
+      *inlineField++ = packet[IEEE802154_IPV6_DESTINATION + i];
+    }
+  }
+  else
+  {
+    mode = IEEE802154_lowpanUnicastMode(&packet[IEEE802154_IPV6_DESTINATION], &header->destinationAddress, header->fcf.destinationAddressMode);
+    buffer[1] |= (uint8_t)(mode << IEEE802154_IPHC_DAM_SHIFT);
+    for (i=IEEE802154_lowpanUnicastInline[mode]; i<IEEE802154_IPV6_ADDRESS_SIZE; i++)
+    {
+      *inlineField++ = packet[IEEE802154_IPV6_DESTINATION + i];
+    }
+  }
+
+  *headerLength = IEEE802154_LOWPAN_IPV6_HEADER_SIZE;
+  if (udp)
+  {
+    /* NHC UDP, length is elided and derived from the IPv6 payload length */
+    sourcePort = ((uint16_t)packet[IEEE802154_UDP_SOURCE_PORT] << 8) | packet[IEEE802154_UDP_SOURCE_PORT + 1];
+    destinationPort = ((uint16_t)packet[IEEE802154_UDP_DESTINATION_PORT] << 8) | packet[IEEE802154_UDP_DESTINATION_PORT + 1];
+    if (((sourcePort & 0xFFF0) == IEEE802154_NHC_UDP_PORT_PREFIX_SHORT) && ((destinationPort & 0xFFF0) == IEEE802154_NHC_UDP_PORT_PREFIX_SHORT))
+    {
+      *inlineField++ = IEEE802154_NHC_UDP | 3;
+      *inlineField++ = (uint8_t)((sourcePort & 0x0F) << 4) | (uint8_t)(destinationPort & 0x0F);
+    }
+    else if ((destinationPort & 0xFF00) == IEEE802154_NHC_UDP_PORT_PREFIX)
+    {
+      *inlineField++ = IEEE802154_NHC_UDP | 1;
+      *inlineField++ = HI_UINT16(sourcePort);
+      *inlineField++ = LO_UINT16(sourcePort);
+      *inlineField++ = LO_UINT16(destinationPort);
+    }
+    else if ((sourcePort & 0xFF00) == IEEE802154_NHC_UDP_PORT_PREFIX)
+    {
+      *inlineField++ = IEEE802154_NHC_UDP | 2;
+      *inlineField++ = LO_UINT16(sourcePort);
+      *inlineField++ = HI_UINT16(destinationPort);
+      *inlineField++ = LO_UINT16(destinationPort);
+    }
+    else
+    {
+      *inlineField++ = IEEE802154_NHC_UDP;
+      *inlineField++ = HI_UINT16(sourcePort);
+      *inlineField++ = LO_UINT16(sourcePort);
+      *inlineField++ = HI_UINT16(destinationPort);
+      *inlineField++ = LO_UINT16(destinationPort);
+    }
+    *inlineField++ = packet[IEEE802154_UDP_CHECKSUM];
+    *inlineField++ = packet[IEEE802154_UDP_CHECKSUM + 1];
+    *headerLength += IEEE802154_LOWPAN_UDP_HEADER_SIZE;
+  }
+  return (uint8_t)(inlineField - buffer);
+}
+
+/**
+ * Restores an address compressed by IEEE802154_lowpanCompress().
+ * @param address IPv6 address, 16 bytes
+ * @param inlineField inline part of address
+ * @param mode SAM or DAM
+ * @param multicast M bit of IPHC
+ * @param macAddress MAC address of frame the address belongs to
+ * @param macAddressMode address mode of MAC address
+ * @return number of bytes taken from inlineField, IEEE802154_LOWPAN_ADDRESS_UNKNOWN if
+ * the address is derived from a MAC address the frame does not carry
+*/
+static uint8_t IEEE802154_lowpanAddress(uint8_t *address, const uint8_t *inlineField, uint8_t mode, uint8_t multicast,
+                                        const IEEE802154_Adress_t *macAddress, uint8_t macAddressMode)
+{
+  uint8_t length = 0;
+  uint8_t i;
+
+  if (multicast)
+  {
+    for (i=0; i<IEEE802154_IPV6_ADDRESS_SIZE; i++)
+    {
+      address[i] = 0;
+    }
+    address[0] = 0xFF;
+    address[1] = 0x02;
+    if ((mode == 1) || (mode == 2))
+    {
+      address[1] = inlineField[length++];
+    }
+    for (i=IEEE802154_lowpanMulticastInline[mode]; i<IEEE802154_IPV6_ADDRESS_SIZE; i++)
+    {
+      address[i] = inlineField[length++];
+    }
+    return length;
+  }
+  for (i=0; i<IEEE802154_lowpanUnicastInline[mode]; i++)
+  {
+    address[i] = (i < sizeof(IEEE802154_lowpanLinkLocal)) ? IEEE802154_lowpanLinkLocal[i] : 0;
+  }
+  for (; i<IEEE802154_IPV6_ADDRESS_SIZE; i++)
+  {
+    address[i] = inlineField[length++];
+  }
+  if ((mode == IEEE802154_IPHC_AM_ELIDED) && !IEEE802154_lowpanIid(&address[8], macAddress, macAddressMode))
+  {
+    return IEEE802154_LOWPAN_ADDRESS_UNKNOWN;
+  }
+  return length;
+}
+
+/**
+ * Decompresses IPHC and NHC UDP header. Payload length of IPv6 and UDP header are set
+ * from the size of the uncompressed packet.
+ * @param frame header of frame the packet was received in
+ * @param buffer compressed header followed by data of packet
+ * @param length length of buffer
+ * @param datagramSize size of uncompressed packet for FRAG1, 0 if packet is not
+ * fragmented and ends with buffer
+ * @param packet uncompressed header, at least 48 bytes
+ * @param headerLength set to length of uncompressed header
+ * @return length of compressed header, 0 if it is invalid or uses contexts
+*/
+uint8_t IEEE802154_lowpanDecompress(const IEEE802154_DataFrameHeader_t *frame, const uint8_t *buffer, uint8_t length, uint16_t datagramSize, uint8_t *packet, uint8_t *headerLength)
+{
+  uint8_t position = 2;
+  uint8_t tf;
+  uint8_t trafficClass;
+  uint8_t mode;
+  uint8_t inlineLength;
+  uint8_t nhc = 0;
+  uint8_t required;
+  uint16_t payloadLength;
+
+  if ((length < 2) || ((buffer[0] & IEEE802154_LOWPAN_DISPATCH_IPHC_MASK) != IEEE802154_LOWPAN_DISPATCH_IPHC) ||
+      (buffer[1] & (IEEE802154_IPHC_CID | IEEE802154_IPHC_DAC)) ||
+      ((buffer[1] & IEEE802154_IPHC_SAC) && (buffer[1] & (IEEE802154_IPHC_AM_MASK << IEEE802154_IPHC_SAM_SHIFT))))
+  {
+    return 0;
+  }
+  /* inline fields of IPHC must be present before they are read */
+  tf = (buffer[0] & IEEE802154_IPHC_TF_MASK) >> IEEE802154_IPHC_TF_SHIFT;
+  required = position + IEEE802154_lowpanTfLength[tf];
+  required += (buffer[0] & IEEE802154_IPHC_NH) ? 0 : 1;
+  required += (buffer[0] & IEEE802154_IPHC_HLIM_MASK) ? 0 : 1;
+  mode = (buffer[1] >> IEEE802154_IPHC_SAM_SHIFT) & IEEE802154_IPHC_AM_MASK;
+  required += (buffer[1] & IEEE802154_IPHC_SAC) ? 0 : IEEE802154_IPV6_ADDRESS_SIZE - IEEE802154_lowpanUnicastInline[mode];
+  mode = (buffer[1] >> IEEE802154_IPHC_DAM_SHIFT) & IEEE802154_IPHC_AM_MASK;
+  if (buffer[1] & IEEE802154_IPHC_M)
+  {
+    required += IEEE802154_IPV6_ADDRESS_SIZE - IEEE802154_lowpanMulticastInline[mode] + (((mode == 1) || (mode == 2)) ? 1 : 0);
+  }
+  else
+  {
+    required += IEEE802154_IPV6_ADDRESS_SIZE - IEEE802154_lowpanUnicastInline[mode];
+  }
+  if (required > length)
+  {
+    return 0;
+  }
+
+  /* traffic class is carried as ECN and DSCP, flow label is 20 bits */
+  trafficClass = 0;
+  packet[1] = 0;
+  packet[2] = 0;
+  packet[3] = 0;
+  switch (tf << IEEE802154_IPHC_TF_SHIFT)
+  {
+    case IEEE802154_IPHC_TF_INLINE:
+      trafficClass = (uint8_t)((buffer[position] << 2) | (buffer[position] >> 6));
+      packet[1] = buffer[position + 1] & 0x0F;
+      packet[2] = buffer[position + 2];
+      packet[3] = buffer[position + 3];
+      break;
+    case IEEE802154_IPHC_TF_NO_DSCP:
+      trafficClass = buffer[position] >> 6;
+      packet[1] = buffer[position] & 0x0F;
+      packet[2] = buffer[position + 1];
+      packet[3] = buffer[position + 2];
+      break;
+    case IEEE802154_IPHC_TF_NO_FLOW_LABEL:
+      trafficClass = (uint8_t)((buffer[position] << 2) | (buffer[position] >> 6));
+      break;
+    default:
+      break;
+  }
+  packet[0] = 0x60 | (trafficClass >> 4);
+  packet[1] |= (uint8_t)(trafficClass << 4);
+  position += IEEE802154_lowpanTfLength[tf];
+
+  if (buffer[0] & IEEE802154_IPHC_NH)
+  {
+    packet[IEEE802154_IPV6_NEXT_HEADER] = IEEE802154_LOWPAN_NEXT_HEADER_UDP;
+    nhc = 1;
+  }
+  else
+  {
+    packet[IEEE802154_IPV6_NEXT_HEADER] = buffer[position++];
+  }
+  if (buffer[0] & IEEE802154_IPHC_HLIM_MASK)
+  {
+    packet[IEEE802154_IPV6_HOP_LIMIT] = IEEE802154_lowpanHopLimit[buffer[0] & IEEE802154_IPHC_HLIM_MASK];
+  }
+  else
+  {
+    packet[IEEE802154_IPV6_HOP_LIMIT] = buffer[position++];
+  }
+
+  if (buffer[1] & IEEE802154_IPHC_SAC)
+  {
+    /* unspecified address */
+    for (inlineLength=0; inlineLength<IEEE802154_IPV6_ADDRESS_SIZE; inlineLength++)
+    {
+      packet[IEEE802154_IPV6_SOURCE + inlineLength] = 0;
+    }
+  }
+  else
+  {
+    inlineLength = IEEE802154_lowpanAddress(&packet[IEEE802154_IPV6_SOURCE], &buffer[position],
+                                            (buffer[1] >> IEEE802154_IPHC_SAM_SHIFT) & IEEE802154_IPHC_AM_MASK, 0,
+                                            &frame->sourceAddress, frame->fcf.sourceAddressMode);
+    if (inlineLength == IEEE802154_LOWPAN_ADDRESS_UNKNOWN)
+    {
+      return 0;
+    }
+    position += inlineLength;
+  }
+  inlineLength = IEEE802154_lowpanAddress(&packet[IEEE802154_IPV6_DESTINATION], &buffer[position],
+                                          (buffer[1] >> IEEE802154_IPHC_DAM_SHIFT) & IEEE802154_IPHC_AM_MASK, buffer[1] & IEEE802154_IPHC_M,
+                                          &frame->destinationAddress, frame->fcf.destinationAddressMode);
+  if (inlineLength == IEEE802154_LOWPAN_ADDRESS_UNKNOWN)
+  {
+    return 0;
+  }
+  position += inlineLength;
+
+  *headerLength = IEEE802154_LOWPAN_IPV6_HEADER_SIZE;
+  if (nhc)
+  {
+    /* NHC UDP with checksum inline */
+    if ((position >= length) || ((buffer[position] & IEEE802154_NHC_UDP_MASK) != IEEE802154_NHC_UDP) ||
+        (buffer[position] & IEEE802154_NHC_UDP_CHECKSUM_ELIDED))
+    {
+      return 0;
+    }
+    mode = buffer[position++] & IEEE802154_NHC_UDP_PORTS_MASK;
+    if (position + ((mode == 3) ? 1 : ((mode == 0) ? 4 : 3)) + 2 > length)
+    {
+      return 0;
+    }
+    switch (mode)
+    {
+      case 3:
+        packet[IEEE802154_UDP_SOURCE_PORT] = HI_UINT16(IEEE802154_NHC_UDP_PORT_PREFIX_SHORT);
+        packet[IEEE802154_UDP_SOURCE_PORT + 1] = LO_UINT16(IEEE802154_NHC_UDP_PORT_PREFIX_SHORT) | (buffer[position] >> 4);
+        packet[IEEE802154_UDP_DESTINATION_PORT] = HI_UINT16(IEEE802154_NHC_UDP_PORT_PREFIX_SHORT);
+        packet[IEEE802154_UDP_DESTINATION_PORT + 1] = LO_UINT16(IEEE802154_NHC_UDP_PORT_PREFIX_SHORT) | (buffer[position] & 0x0F);
+        position += 1;
+        break;
+      case 2:
+        packet[IEEE802154_UDP_SOURCE_PORT] = HI_UINT16(IEEE802154_NHC_UDP_PORT_PREFIX);
+        packet[IEEE802154_UDP_SOURCE_PORT + 1] = buffer[position];
+        packet[IEEE802154_UDP_DESTINATION_PORT] = buffer[position + 1];
+        packet[IEEE802154_UDP_DESTINATION_PORT + 1] = buffer[position + 2];
+        position += 3;
+        break;
+      case 1:
+        packet[IEEE802154_UDP_SOURCE_PORT] = buffer[position];
+        packet[IEEE802154_UDP_SOURCE_PORT + 1] = buffer[position + 1];
+        packet[IEEE802154_UDP_DESTINATION_PORT] = HI_UINT16(IEEE802154_NHC_UDP_PORT_PREFIX);
+        packet[IEEE802154_UDP_DESTINATION_PORT + 1] = buffer[position + 2];
+        position += 3;
+        break;
+      default:
+        packet[IEEE802154_UDP_SOURCE_PORT] = buffer[position];
+        packet[IEEE802154_UDP_SOURCE_PORT + 1] = buffer[position + 1];
+        packet[IEEE802154_UDP_DESTINATION_PORT] = buffer[position + 2];
+        packet[IEEE802154_UDP_DESTINATION_PORT + 1] = buffer[position + 3];
+        position += 4;
+        break;
+    }
+    packet[IEEE802154_UDP_CHECKSUM] = buffer[position];
+    packet[IEEE802154_UDP_CHECKSUM + 1] = buffer[position + 1];
+    position += 2;
+    *headerLength += IEEE802154_LOWPAN_UDP_HEADER_SIZE;
+  }
+
+  if (datagramSize == 0)
+  {
+    datagramSize = *headerLength + (length - position);
+  }
+  if (datagramSize < *headerLength)
+  {
+    return 0;
+  }
+  payloadLength = datagramSize - IEEE802154_LOWPAN_IPV6_HEADER_SIZE;
+  packet[IEEE802154_IPV6_PAYLOAD_LENGTH] = HI_UINT16(payloadLength);
+  packet[IEEE802154_IPV6_PAYLOAD_LENGTH + 1] = LO_UINT16(payloadLength);
+  if (nhc)
+  {
+    packet[IEEE802154_UDP_LENGTH] = HI_UINT16(payloadLength);
+    packet[IEEE802154_UDP_LENGTH + 1] = LO_UINT16(payloadLength);
+  }
+  return position;
+}
+
+/**
+ * Sends one frame of a packet and increments the sequence number of header.
+ * @return IEEE802154_TX_SUCCESS or reason why frame was not sent
+*/
+static uint8_t IEEE802154_lowpanSendFrame(IEEE802154_DataFrameHeader_t *header, const IEEE802154_Segment_t *segments, uint8_t segmentCount)
+{
+  uint8_t status = IEEE802154_radioSentDataFrameSegments(header, segments, segmentCount);
+#ifdef IEEE802154_ENABLE_CSMA
+  if (status == IEEE802154_TX_SUCCESS)
+  {
+    status = IEEE802154_TxStatus;
+  }
+#endif
+  header->sequenceNumber++;
+  return status;
+}
+
+/**
+ * Blocking send of an IPv6 packet. Headers are compressed by IEEE802154_lowpanCompress(),
+ * a packet not fitting into one frame is sent as fragments. Each frame takes the next
+ * sequence number, header->sequenceNumber is incremented accordingly.
+ * @param header header of frames, addresses are used for header compression,
+ * header->payload is not used
+ * @param packet IPv6 packet
+ * @param packetLength length of packet, at most IEEE802154_LOWPAN_MTU
+ * @return IEEE802154_TX_SUCCESS, IEEE802154_TX_INVALID_PARAMETER if packet is no IPv6
+ * packet or header uses a reserved address mode, IEEE802154_TX_FRAME_TOO_LONG if packet
+ * exceeds IEEE802154_LOWPAN_MTU or the result of the first frame that failed; remaining
+ * fragments are not sent then. Without IEEE802154_ENABLE_CSMA transmission results are
+ * not known.
+*/
+uint8_t IEEE802154_lowpanSend(IEEE802154_DataFrameHeader_t *header, IEEE802154_PayloadPointer packet, uint16_t packetLength)
+{
+  uint8_t compressed[IEEE802154_LOWPAN_HEADER_MAX_SIZE];
+  uint8_t fragment[IEEE802154_LOWPAN_FRAGN_HEADER_SIZE];
+  IEEE802154_Segment_t segments[3];
+  const uint8_t *fcf = (const uint8_t*)&header->fcf;
+  uint8_t macHeaderLength = IEEE802154_frameLayout[IEEE802154_FRAME_LAYOUT_INDEX(fcf[0], fcf[1])].headerLength;
+  uint8_t compressedLength;
+  uint8_t headerLength;
+  uint8_t maxPayload;
+  uint8_t status;
+  uint16_t offset;
+  uint16_t length;
+
+  if (macHeaderLength == 0)
+  {
+    return IEEE802154_TX_INVALID_PARAMETER;
+  }
+  if (packetLength > IEEE802154_LOWPAN_MTU)
+  {
+    return IEEE802154_TX_FRAME_TOO_LONG;
+  }
+  compressedLength = IEEE802154_lowpanCompress(header, packet, packetLength, compressed, &headerLength);
+  if (compressedLength == 0)
+  {
+    return IEEE802154_TX_INVALID_PARAMETER;
+  }
+  maxPayload = IEEE802154_MAX_PHY_PACKET_SIZE - IEEE802154_CRCLENGTH - macHeaderLength;
+#ifdef IEEE802154_ENABLE_SECURITY
+  if (header->fcf.securityEnabled)
+  {
+    maxPayload -= IEEE802154_AUX_HEADER_LENGTH(header->auxSecurityHeader.securityControl) +
+                  IEEE802154_MIC_LENGTH(header->auxSecurityHeader.securityControl & IEEE802154_SECURITY_LEVEL_MASK);
+  }
+#endif
+  segments[0].data = compressed;
+  segments[0].length = compressedLength;
+  segments[1].data = &packet[headerLength];
+  if (compressedLength + packetLength - headerLength <= maxPayload)
+  {
+    segments[1].length = (uint8_t)(packetLength - headerLength);
+    return IEEE802154_lowpanSendFrame(header, segments, 2);
+  }
+
+  /* FRAG1 carries the compressed header and data up to an 8 byte boundary of the
+   * uncompressed packet, FRAGN data of a multiple of 8 bytes except for the last one */
+  length = (uint16_t)(maxPayload - IEEE802154_LOWPAN_FRAG1_HEADER_SIZE - compressedLength + headerLength) & (uint16_t)~7;
+  if (length <= headerLength)
+  {
+    return IEEE802154_TX_FRAME_TOO_LONG;
+  }
+  fragment[0] = IEEE802154_LOWPAN_DISPATCH_FRAG1 | HI_UINT16(packetLength);
+  fragment[1] = LO_UINT16(packetLength);
+  fragment[2] = HI_UINT16(IEEE802154_lowpanTag);
+  fragment[3] = LO_UINT16(IEEE802154_lowpanTag);
+  IEEE802154_lowpanTag++;
+  segments[2] = segments[1];
+  segments[2].length = (uint8_t)(length - headerLength);
+  segments[1] = segments[0];
+  segments[0].data = fragment;
+  segments[0].length = IEEE802154_LOWPAN_FRAG1_HEADER_SIZE;
+  status = IEEE802154_lowpanSendFrame(header, segments, 3);
+
+  fragment[0] = IEEE802154_LOWPAN_DISPATCH_FRAGN | HI_UINT16(packetLength);
+  segments[0].length = IEEE802154_LOWPAN_FRAGN_HEADER_SIZE;
+  for (offset = length; (status == IEEE802154_TX_SUCCESS) && (offset < packetLength); offset += length)
+  {
+    length = (uint8_t)(maxPayload - IEEE802154_LOWPAN_FRAGN_HEADER_SIZE) & (uint8_t)~7;
+    if (length > packetLength - offset)
+    {
+      length = packetLength - offset;
+    }
+    fragment[4] = (uint8_t)(offset >> 3);
+    segments[1].data = &packet[offset];
+    segments[1].length = (uint8_t)length;
+    status = IEEE802154_lowpanSendFrame(header, segments, 2);
+  }
+  return status;
+}
+
+/**
+ * @return 1 if both addresses are equal
+*/
+static uint8_t IEEE802154_lowpanAddressEqual(const IEEE802154_Adress_t *address, const IEEE802154_Adress_t *other, uint8_t addressMode)
+{
+  uint8_t i;
+  if (addressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
+  {
+    return address->shortAddress == other->shortAddress;
+  }
+  if (addressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT)
+  {
+    for (i=0; i<sizeof(IEEE802154_ExtendedAddress_t); i++)
+    {
+      if (address->extendedAdress[i] != other->extendedAdress[i])
+      {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+/**
+ * Returns the reassembly buffer of a fragment, a new packet takes a free buffer.
+ * @return NULL if no buffer is free
+*/
+static IEEE802154_LowpanReassembly_t* IEEE802154_lowpanReassemblyGet(const IEEE802154_DataFrameHeader_t *frame, uint16_t size, uint16_t tag, IEEE802154_Timestamp_t now)
+{
+  IEEE802154_LowpanReassembly_t *entry;
+  IEEE802154_LowpanReassembly_t *unused = NULL;
+  uint8_t i;
+
+  for (i=0; i<IEEE802154_LOWPAN_REASSEMBLY_BUFFERS; i++)
+  {
+    entry = &IEEE802154_lowpanReassembly[i];
+    if (entry->size == 0)
+    {
+      if (unused == NULL)
+      {
+        unused = entry;
+      }
+    }
+    else if ((entry->size == size) && (entry->tag == tag) &&
+             (entry->sourceAddressMode == frame->fcf.sourceAddressMode) &&
+             (entry->destinationAddressMode == frame->fcf.destinationAddressMode) &&
+             IEEE802154_lowpanAddressEqual(&entry->sourceAddress, &frame->sourceAddress, entry->sourceAddressMode) &&
+             IEEE802154_lowpanAddressEqual(&entry->destinationAddress, &frame->destinationAddress, entry->destinationAddressMode))
+    {
+      return entry;
+    }
+  }
+  if (unused != NULL)
+  {
+    unused->sourceAddress = frame->sourceAddress;
+    unused->destinationAddress = frame->destinationAddress;
+    unused->sourceAddressMode = frame->fcf.sourceAddressMode;
+    unused->destinationAddressMode = frame->fcf.destinationAddressMode;
+    unused->size = size;
+    unused->tag = tag;
+    unused->received = 0;
+    unused->headerStored = 0;
+    unused->start = now;
+    for (i=0; i<sizeof(unused->blocks); i++)
+    {
+      unused->blocks[i] = 0;
+    }
+  }
+  return unused;
+}
+
+/**
+ * Stores a FRAG1 or FRAGN fragment and delivers the packet once it is complete and the
+ * headers decompressed from FRAG1 are stored. Fragments overlapping data already
+ * received are ignored, a FRAGN with offset 0 is dropped.
+*/
+static void IEEE802154_lowpanFragment(const IEEE802154_DataFrameHeader_t *frame, const uint8_t *payload, uint8_t payloadLength, IEEE802154_Timestamp_t now)
+{
+  uint8_t header[IEEE802154_LOWPAN_IPV6_HEADER_SIZE + IEEE802154_LOWPAN_UDP_HEADER_SIZE];
+  IEEE802154_LowpanReassembly_t *entry;
+  uint8_t first = (payload[0] & IEEE802154_LOWPAN_DISPATCH_FRAG_MASK) == IEEE802154_LOWPAN_DISPATCH_FRAG1;
+  uint8_t fragmentHeaderLength = first ? IEEE802154_LOWPAN_FRAG1_HEADER_SIZE : IEEE802154_LOWPAN_FRAGN_HEADER_SIZE;
+  uint8_t headerLength = 0;
+  uint8_t compressedLength = 0;
+  uint16_t size;
+  uint16_t tag;
+  uint16_t offset;
+  uint16_t end;
+  uint16_t block;
+  uint16_t i;
+
+  if (payloadLength <= fragmentHeaderLength)
+  {
+    IEEE802154_LowpanDropped++;
+    return;
+  }
+  size = ((uint16_t)(payload[0] & 0x07) << 8) | payload[1];
+  tag = ((uint16_t)payload[2] << 8) | payload[3];
+  offset = first ? 0 : (uint16_t)payload[4] << 3;
+  if (!first && (offset == 0))
+  {
+    /* start of the packet is only carried by FRAG1 */
+    IEEE802154_LowpanDropped++;
+    return;
+  }
+  payload += fragmentHeaderLength;
+  payloadLength -= fragmentHeaderLength;
+  if (first)
+  {
+    compressedLength = IEEE802154_lowpanDecompress(frame, payload, payloadLength, size, header, &headerLength);
+    if (compressedLength == 0)
+    {
+      IEEE802154_LowpanDropped++;
+      return;
+    }
+  }
+  end = offset + headerLength + (payloadLength - compressedLength);
+  /* all fragments but the last one end at an 8 byte boundary */
+  if ((size > IEEE802154_LOWPAN_MTU) || (end > size) || ((end < size) && (end & 7)))
+  {
+    IEEE802154_LowpanDropped++;
+    return;
+  }
+  entry = IEEE802154_lowpanReassemblyGet(frame, size, tag, now);
+  if (entry == NULL)
+  {
+    IEEE802154_LowpanDropped++;
+    return;
+  }
+  for (block = offset >> 3; block < (end + 7) >> 3; block++)
+  {
+    if (entry->blocks[block >> 3] & (1 << (block & 7)))
+    {
+      /* retransmitted or overlapping fragment */
+      return;
+    }
+  }
+  for (i=0; i<headerLength; i++)
+  {
+    entry->packet[i] = header[i];
+  }
+  for (i=0; i<payloadLength - compressedLength; i++)
+  {
+    entry->packet[offset + headerLength + i] = payload[compressedLength + i];
+  }
+  for (block = offset >> 3; block < (end + 7) >> 3; block++)
+  {
+    entry->blocks[block >> 3] |= (uint8_t)(1 << (block & 7));
+  }
+  entry->received += end - offset;
+  entry->headerStored |= first;
+  if ((entry->received == size) && entry->headerStored)
+  {
+    IEEE802154_LowpanReassembled++;
+    IEEE802154_UserCbk_LowpanPacketReceived(frame, entry->packet, size);
+    entry->size = 0;
+  }
+}
+
+/**
+ * Passes the payload of a received data frame to the adaptation layer. A complete IPv6
+ * packet is delivered by IEEE802154_UserCbk_LowpanPacketReceived() before the function
+ * returns, fragments are kept until the packet is complete. Reassembly buffers older
+ * than IEEE802154_LOWPAN_REASSEMBLY_TIMEOUT are freed first.
+ * @param frame header of received frame
+ * @param payload payload of frame
+ * @param payloadLength length of payload
+ * @param now receive time of frame, e.g. timestamp of receive queue slot
+*/
+void IEEE802154_lowpanInput(const IEEE802154_DataFrameHeader_t *frame, const uint8_t *payload, uint8_t payloadLength, IEEE802154_Timestamp_t now)
+{
+  uint8_t headerLength;
+  uint8_t compressedLength;
+  uint8_t i;
+
+  for (i=0; i<IEEE802154_LOWPAN_REASSEMBLY_BUFFERS; i++)
+  {
+    if ((IEEE802154_lowpanReassembly[i].size != 0) &&
+        ((IEEE802154_Timestamp_t)(now - IEEE802154_lowpanReassembly[i].start) >= IEEE802154_LOWPAN_REASSEMBLY_TIMEOUT))
+    {
+      IEEE802154_lowpanReassembly[i].size = 0;
+      IEEE802154_LowpanTimeouts++;
+    }
+  }
+  if (payloadLength == 0)
+  {
+    IEEE802154_LowpanDropped++;
+  }
+  else if (payload[0] == IEEE802154_LOWPAN_DISPATCH_IPV6)
+  {
+    IEEE802154_UserCbk_LowpanPacketReceived(frame, &payload[1], payloadLength - 1);
+  }
+  else if ((payload[0] & IEEE802154_LOWPAN_DISPATCH_IPHC_MASK) == IEEE802154_LOWPAN_DISPATCH_IPHC)
+  {
+    compressedLength = IEEE802154_lowpanDecompress(frame, payload, payloadLength, 0, IEEE802154_lowpanPacket, &headerLength);
+    if (compressedLength == 0)
+    {
+      IEEE802154_LowpanDropped++;
+      return;
+    }
+    for (i=0; i<payloadLength - compressedLength; i++)
+    {
+      IEEE802154_lowpanPacket[headerLength + i] = payload[compressedLength + i];
+    }
+    IEEE802154_UserCbk_LowpanPacketReceived(frame, IEEE802154_lowpanPacket, headerLength + payloadLength - compressedLength);
+  }
+  else if (((payload[0] & IEEE802154_LOWPAN_DISPATCH_FRAG_MASK) == IEEE802154_LOWPAN_DISPATCH_FRAG1) ||
+           ((payload[0] & IEEE802154_LOWPAN_DISPATCH_FRAG_MASK) == IEEE802154_LOWPAN_DISPATCH_FRAGN))
+  {
+    IEEE802154_lowpanFragment(frame, payload, payloadLength, now);
+  }
+  else
+  {
+    /* mesh, broadcast or unknown dispatch */
+    IEEE802154_LowpanDropped++;
+  }
+}
+
+#endif
+
+/** @}*/
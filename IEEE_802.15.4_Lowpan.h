@@ -0,0 +1,66 @@
+/** @ingroup IEEE_802.15.4
+ * @{
+ */
+#ifndef IEEE_802_15_4_LOWPAN_H_
+#define IEEE_802_15_4_LOWPAN_H_
+
+/**
+ * 6LoWPAN adaptation layer carrying IPv6 packets in data frames. Requires
+ * IEEE802154_ENABLE_LOWPAN, see IEEE_802.15.4.h.
+ * - header compression according to RFC 6282: IPHC without contexts, addresses are
+ *   elided as far as they can be derived from the MAC addresses of the frame. UDP
+ *   headers are compressed by NHC, the UDP checksum is always carried inline.
+ * - fragmentation according to RFC 4944 Chapter 5.3: packets not fitting into one frame
+ *   are sent as FRAG1 and FRAGN fragments by IEEE802154_lowpanSend(). Offsets and the
+ *   datagram size refer to the uncompressed packet.
+ * - reassembly in IEEE802154_LOWPAN_REASSEMBLY_BUFFERS buffers of IEEE802154_LOWPAN_MTU
+ *   bytes. A buffer is freed after IEEE802154_LOWPAN_REASSEMBLY_TIMEOUT if the packet is
+ *   still incomplete. Complete packets are passed to
+ *   IEEE802154_UserCbk_LowpanPacketReceived().
+ * Mesh and broadcast headers are not supported, such frames are dropped. The layer is
+ * used from the application, not from the RF ISR: received data frames are passed to
+ * IEEE802154_lowpanInput(). IEEE802154_lowpanInit() frees all reassembly buffers.
+*/
+
+/*******************| Inclusions |*************************************/
+#include "IEEE_802.15.4.h"
+
+/*******************| Macros |*****************************************/
+/* dispatch values of RFC 4944 and RFC 6282 */
+#define IEEE802154_LOWPAN_DISPATCH_IPV6         (uint8_t)0x41   /**< uncompressed IPv6 header */
+#define IEEE802154_LOWPAN_DISPATCH_IPHC         (uint8_t)0x60   /**< 011xxxxx */
+#define IEEE802154_LOWPAN_DISPATCH_IPHC_MASK    (uint8_t)0xE0
+#define IEEE802154_LOWPAN_DISPATCH_FRAG1        (uint8_t)0xC0   /**< 11000xxx */
+#define IEEE802154_LOWPAN_DISPATCH_FRAGN        (uint8_t)0xE0   /**< 11100xxx */
+#define IEEE802154_LOWPAN_DISPATCH_FRAG_MASK    (uint8_t)0xF8
+#define IEEE802154_LOWPAN_FRAG1_HEADER_SIZE     (uint8_t)4
+#define IEEE802154_LOWPAN_FRAGN_HEADER_SIZE     (uint8_t)5
+
+#define IEEE802154_LOWPAN_NEXT_HEADER_UDP       (uint8_t)17
+/** compressed headers at most: IPHC, traffic class and flow label, hop limit, both addresses inline and NHC UDP */
+#define IEEE802154_LOWPAN_HEADER_MAX_SIZE       (uint8_t)46
+
+/*******************| Type definitions |*******************************/
+
+/*******************| Global variables |*******************************/
+/**
+ * Packets delivered after reassembly, incomplete packets freed after timeout and
+ * frames dropped as they were malformed or no reassembly buffer was free.
+ */
+#define IEEE802154_LowpanReassembled            (IEEE802154_Instance->lowpanReassembled)
+#define IEEE802154_LowpanTimeouts               (IEEE802154_Instance->lowpanTimeouts)
+#define IEEE802154_LowpanDropped                (IEEE802154_Instance->lowpanDropped)
+
+/*******************| Function prototypes |****************************/
+void IEEE802154_lowpanInit(void);
+uint8_t IEEE802154_lowpanCompress(const IEEE802154_DataFrameHeader_t *header, const uint8_t *packet, uint16_t packetLength, uint8_t *buffer, uint8_t *headerLength);
+uint8_t IEEE802154_lowpanDecompress(const IEEE802154_DataFrameHeader_t *frame, const uint8_t *buffer, uint8_t length, uint16_t datagramSize, uint8_t *packet, uint8_t *headerLength);
+uint8_t IEEE802154_lowpanSend(IEEE802154_DataFrameHeader_t *header, IEEE802154_PayloadPointer packet, uint16_t packetLength);
+void IEEE802154_lowpanInput(const IEEE802154_DataFrameHeader_t *frame, const uint8_t *payload, uint8_t payloadLength, IEEE802154_Timestamp_t now);
+
+/* callback from IEEE802154_lowpanInput() with a complete IPv6 packet */
+extern void IEEE802154_UserCbk_LowpanPacketReceived(const IEEE802154_DataFrameHeader_t *frame, const uint8_t *packet, uint16_t packetLength);
+
+#endif
+
+/** @}*/
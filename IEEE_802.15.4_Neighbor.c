@@ -0,0 +1,228 @@
+/** @ingroup IEEE_802.15.4
+ * @{
+ */
+/*******************| Inclusions |*************************************/
+#include "IEEE_802.15.4.h"
+#include "IEEE_802.15.4_Radio.h"
+#include <stddef.h>
+
+/**
+ * Link quality table of neighbors, updated by the RF ISR (DMA ISR with
+ * IEEE802154_ENABLE_DMA) for every frame with valid CRC and source address. Routing and
+ * parent selection read it with IEEE802154_neighborFind() or iterate it with
+ * IEEE802154_neighborGet(). Entries are returned by pointer, readers outside of the ISR
+ * should evaluate an entry inside IEEE802154_CRITICAL_ENTER() and IEEE802154_CRITICAL_EXIT()
+ * as a frame may update or replace it.
+ * With IEEE802154_ENABLE_ADDRESS_INTERNING entries hold the handle of extended addresses,
+ * each entry holds one reference which is released when the entry is replaced.
+ * Only compiled in if IEEE802154_ENABLE_NEIGHBOR_TABLE is defined.
+*/
+#ifdef IEEE802154_ENABLE_NEIGHBOR_TABLE
+
+/*******************| Macros |*****************************************/
+/* first entry of the pair a hash value is mapped to */
+#define IEEE802154_NEIGHBOR_PAIR(hash)          (uint8_t)(((hash) << 1) & (IEEE802154_NEIGHBOR_TABLE_SIZE - 1))
+
+/*******************| Type definitions |*******************************/
+/* address as stored in an entry */
+#ifdef IEEE802154_ENABLE_ADDRESS_INTERNING
+typedef IEEE802154_CompactAddress_t IEEE802154_NeighborKey_t;
+#else
+typedef IEEE802154_Adress_t IEEE802154_NeighborKey_t;
+#endif
+
+/*******************| Global variables |*******************************/
+#define IEEE802154_neighborTable                (IEEE802154_Instance->neighborTable)
+
+/*******************| Function definition |****************************/
+
+/**
+ * Marks all entries unused.
+*/
+void IEEE802154_neighborInit(void)
+{
+  uint8_t i;
+  for (i=0; i<IEEE802154_NEIGHBOR_TABLE_SIZE; i++)
+  {
+    IEEE802154_neighborTable[i].addressMode = IEEE802154_FCF_ADDRESS_MODE_NONE;
+  }
+}
+
+/**
+ * @return index of first entry of the pair the address is stored in
+*/
+static uint8_t IEEE802154_neighborHash(const IEEE802154_Adress_t *address, uint8_t addressMode)
+{
+  uint8_t i;
+  uint8_t hash;
+  if (addressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
+  {
+    hash = LO_UINT16(address->shortAddress) ^ HI_UINT16(address->shortAddress);
+  }
+  else
+  {
+    hash = 0;
+    for (i=0; i<sizeof(IEEE802154_ExtendedAddress_t); i++)
+    {
+      hash ^= address->extendedAdress[i];
+    }
+  }
+  return IEEE802154_NEIGHBOR_PAIR(hash);
+}
+
+/**
+ * Converts an address to the form stored in an entry without taking a reference.
+ * @return 1 on success, 0 if an extended address is not interned and thus not in the table
+*/
+static uint8_t IEEE802154_neighborKey(IEEE802154_NeighborKey_t *key, const IEEE802154_Adress_t *address, uint8_t addressMode)
+{
+#ifdef IEEE802154_ENABLE_ADDRESS_INTERNING
+  if (addressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
+  {
+    key->shortAddress = address->shortAddress;
+    return 1;
+  }
+  key->handle = IEEE802154_addressFind(address->extendedAdress);
+  return key->handle != IEEE802154_ADDRESS_HANDLE_INVALID;
+#else
+  (void)addressMode;
+  *key = *address;
+  return 1;
+#endif
+}
+
+/**
+ * @return 1 if entry holds the address
+*/
+static uint8_t IEEE802154_neighborMatch(const IEEE802154_NeighborEntry_t *entry, const IEEE802154_NeighborKey_t *key, uint8_t addressMode)
+{
+#ifndef IEEE802154_ENABLE_ADDRESS_INTERNING
+  uint8_t i;
+#endif
+  if (entry->addressMode != addressMode)
+  {
+    return 0;
+  }
+  if (addressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
+  {
+    return entry->address.shortAddress == key->shortAddress;
+  }
+#ifdef IEEE802154_ENABLE_ADDRESS_INTERNING
+  return entry->address.handle == key->handle;
+#else
+  for (i=0; i<sizeof(IEEE802154_ExtendedAddress_t); i++)
+  {
+    if (entry->address.extendedAdress[i] != key->extendedAdress[i])
+    {
+      return 0;
+    }
+  }
+  return 1;
+#endif
+}
+
+/**
+ * Adds a received frame to the entry of its source, called by the RF ISR. An unknown
+ * source takes over the unused or least recently seen entry of its pair.
+ * @param frame received frame with source address
+ * @param rssi RSSI of frame
+ * @param lqi correlation value of frame
+ * @param now time of reception
+*/
+void IEEE802154_neighborUpdate(const IEEE802154_DataFrameHeader_t *frame, sint8_t rssi, uint8_t lqi, IEEE802154_Timestamp_t now)
+{
+  IEEE802154_NeighborEntry_t *entry = &IEEE802154_neighborTable[IEEE802154_neighborHash(&frame->sourceAddress, frame->fcf.sourceAddressMode)];
+  IEEE802154_NeighborEntry_t *other = entry + 1;
+  IEEE802154_NeighborKey_t key;
+  uint8_t known = IEEE802154_neighborKey(&key, &frame->sourceAddress, frame->fcf.sourceAddressMode);
+
+  if (!known || !IEEE802154_neighborMatch(entry, &key, frame->fcf.sourceAddressMode))
+  {
+    if (known && IEEE802154_neighborMatch(other, &key, frame->fcf.sourceAddressMode))
+    {
+      entry = other;
+    }
+    else
+    {
+      /* replace unused or older entry, first sample initializes the averages */
+      if ((entry->addressMode != IEEE802154_FCF_ADDRESS_MODE_NONE) &&
+          ((other->addressMode == IEEE802154_FCF_ADDRESS_MODE_NONE) ||
+           ((IEEE802154_Timestamp_t)(now - other->lastSeen) > (IEEE802154_Timestamp_t)(now - entry->lastSeen))))
+      {
+        entry = other;
+      }
+#ifdef IEEE802154_ENABLE_ADDRESS_INTERNING
+      /* release handle of replaced source first, so the new one finds a free entry */
+      if (entry->addressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT)
+      {
+        IEEE802154_addressRelease(entry->address.handle);
+      }
+      entry->addressMode = IEEE802154_FCF_ADDRESS_MODE_NONE;
+      if (!IEEE802154_addressCompact(&entry->address, &frame->sourceAddress, frame->fcf.sourceAddressMode))
+      {
+        /* address table is used up by the application */
+        return;
+      }
+#else
+      entry->address = frame->sourceAddress;
+#endif
+      entry->addressMode = frame->fcf.sourceAddressMode;
+      entry->rssiAverage = (sint16_t)rssi * (1 << IEEE802154_NEIGHBOR_EWMA_SHIFT);
+      entry->lqiAverage = (uint16_t)lqi << IEEE802154_NEIGHBOR_EWMA_SHIFT;
+      entry->frames = 0;
+    }
+  }
+  /* average += sample - average / 2^shift, average is kept scaled by 2^shift */
+  entry->rssiAverage += rssi - IEEE802154_NEIGHBOR_RSSI(entry);
+  entry->lqiAverage += lqi - IEEE802154_NEIGHBOR_LQI(entry);
+  if (entry->frames != 0xFFFF)
+  {
+    entry->frames++;
+  }
+  entry->lastSeen = now;
+}
+
+/**
+ * Looks up the link quality of a neighbor.
+ * @param address short or extended address
+ * @param addressMode IEEE802154_FCF_ADDRESS_MODE_16BIT or IEEE802154_FCF_ADDRESS_MODE_64BIT
+ * @return entry of neighbor, NULL if no frame has been received from it
+*/
+const IEEE802154_NeighborEntry_t* IEEE802154_neighborFind(const IEEE802154_Adress_t *address, uint8_t addressMode)
+{
+  IEEE802154_NeighborEntry_t *entry = &IEEE802154_neighborTable[IEEE802154_neighborHash(address, addressMode)];
+  IEEE802154_NeighborKey_t key;
+  if (!IEEE802154_neighborKey(&key, address, addressMode))
+  {
+    return NULL;
+  }
+  if (IEEE802154_neighborMatch(entry, &key, addressMode))
+  {
+    return entry;
+  }
+  entry++;
+  if (IEEE802154_neighborMatch(entry, &key, addressMode))
+  {
+    return entry;
+  }
+  return NULL;
+}
+
+/**
+ * Access to the table for iteration.
+ * @param index 0 to IEEE802154_NEIGHBOR_TABLE_SIZE-1
+ * @return entry, NULL if index is out of range or entry is unused
+*/
+const IEEE802154_NeighborEntry_t* IEEE802154_neighborGet(uint8_t index)
+{
+  if ((index >= IEEE802154_NEIGHBOR_TABLE_SIZE) ||
+      (IEEE802154_neighborTable[index].addressMode == IEEE802154_FCF_ADDRESS_MODE_NONE))
+  {
+    return NULL;
+  }
+  return &IEEE802154_neighborTable[index];
+}
+
+#endif
+
+/** @}*/
@@ -0,0 +1,855 @@
+/** @ingroup IEEE_802.15.4
+ * @{
+ */
+/*******************| Inclusions |*************************************/
+#define _POSIX_C_SOURCE 200112L     /* pthread barriers, sysconf */
+#include "IEEE_802.15.4.h"
+#include "IEEE_802.15.4_Radio.h"
+#ifdef IEEE802154_ENABLE_NETSIM
+#include "IEEE_802.15.4_NetSim.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Network simulator, see IEEE_802.15.4_NetSim.h. The simulator is the application of
+ * every node: it provides the payload of IEEE802154_RxDataFrame and the callbacks of the
+ * MAC. Only compiled in if IEEE802154_ENABLE_NETSIM is defined.
+ * Every node embeds its MAC context, a worker points IEEE802154_Instance to the node it
+ * runs, the callbacks find the node from there. State shared between nodes of different
+ * workers is only written in one phase of a period and read in the other one:
+ * - data: written by the sender while transmitting, read by neighbors while receiving
+ * - ack: written while receiving, read by neighbors while receiving in the next period,
+ *   one slot per period parity
+ * - airEnd: written while receiving, read while transmitting (CCA)
+ * - nextActive of a worker: written while receiving, read between periods
+*/
+#ifdef IEEE802154_ENABLE_NETSIM
+
+/*******************| Macros |*****************************************/
+#define IEEE802154_NETSIM_TIME_NEVER            (uint32_t)0xFFFFFFFFUL
+#define IEEE802154_NETSIM_RSSI_NEAR             (sint8_t)-45    /**< dBm received from a node at distance 0 */
+#define IEEE802154_NETSIM_RSSI_SPAN             (sint8_t)45     /**< dBm less at the border of the range */
+#define IEEE802154_NETSIM_CORRELATION           (uint8_t)108    /**< correlation value of received frames */
+
+/** node run by the calling worker, its context is the current instance of the MAC */
+#define IEEE802154_NetSim_self                  ((IEEE802154_NetSim_Node_t*)IEEE802154_Instance)
+
+/*******************| Type definitions |*******************************/
+/**
+ * Frame on air
+ */
+typedef struct {
+  uint32_t start;                       /**< first period the frame occupies the medium */
+  uint32_t end;                         /**< first period after the frame */
+  uint8_t length;                       /**< length without FCS, 0 if slot is unused */
+  uint8_t frame[IEEE802154_MAX_PHY_PACKET_SIZE];
+} IEEE802154_NetSim_Transmission_t;
+
+/**
+ * Node within interference range
+ */
+typedef struct {
+  uint16_t node;
+  uint8_t audible;                      /**< within range, frames can be received */
+  sint8_t rssi;                         /**< RSSI appended to frames received from the node */
+} IEEE802154_NetSim_Neighbor_t;
+
+/**
+ * Frame of the transmit queue of a node
+ */
+typedef struct {
+  IEEE802154_DataFrameHeader_t header;
+  IEEE802154_Payload payload[IEEE802154_NETSIM_PAYLOAD_MAX];
+} IEEE802154_NetSim_TxFrame_t;
+
+typedef struct {
+  IEEE802154_Context_t context;         /**< instance of the MAC, first member, see IEEE802154_NetSim_self */
+  /* shared, see above */
+  IEEE802154_NetSim_Transmission_t data;
+  IEEE802154_NetSim_Transmission_t ack[2];
+  uint32_t airEnd;                      /**< end of the last transmission of the node */
+  /* topology, constant during the run */
+  uint16_t index;
+  uint16_t x;
+  uint16_t y;
+  uint16_t neighborCount;
+  IEEE802154_NetSim_Neighbor_t *neighbors;
+  /* private to the worker of the node */
+  uint32_t now;                         /**< period the node is in */
+  IEEE802154_NetSim_Transmission_t receiving;   /**< frame in reception, not (yet) collided */
+  sint8_t receivingRssi;
+  uint32_t interferenceEnd;             /**< end of all transmissions heard so far */
+  uint32_t ownEnd;                      /**< end of the last own transmission */
+  uint8_t ackPending;                   /**< acknowledge scheduled for the next period */
+  uint32_t random;                      /**< xorshift state */
+  uint32_t nextTraffic;                 /**< period the next frame is generated */
+  uint8_t sequenceNumber;
+  uint8_t txNext;                       /**< free running index into txFrames */
+  IEEE802154_NetSim_TxFrame_t txFrames[IEEE802154_TX_QUEUE_SIZE];
+#ifndef IEEE802154_ENABLE_RX_QUEUE
+  IEEE802154_Payload rxPayload[IEEE802154_MAX_PHY_PACKET_SIZE];
+#endif
+  IEEE802154_NetSim_Report_t report;
+} IEEE802154_NetSim_Node_t;
+
+/**
+ * Worker thread running a contiguous block of nodes
+ */
+typedef struct {
+  pthread_t thread;
+  uint16_t first;                       /**< first node of the block */
+  uint16_t last;                        /**< first node after the block */
+  uint32_t nextActive;                  /**< next period a node of the block has something to do, shared, see above */
+} IEEE802154_NetSim_Worker_t;
+
+/*******************| Global variables |*******************************/
+static const IEEE802154_NetSim_Config_t *IEEE802154_NetSim_config;
+static IEEE802154_NetSim_Node_t *IEEE802154_NetSim_nodes;
+static IEEE802154_NetSim_Worker_t *IEEE802154_NetSim_workers;
+static uint16_t IEEE802154_NetSim_workerCount;
+static pthread_barrier_t IEEE802154_NetSim_barrier;
+static pthread_mutex_t IEEE802154_NetSim_startLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t IEEE802154_NetSim_startCondition = PTHREAD_COND_INITIALIZER;
+static uint8_t IEEE802154_NetSim_startState;   /**< 0: threads are created, 1: run, 2: abort */
+
+/*******************| Function prototypes |****************************/
+static uint32_t IEEE802154_NetSim_random(IEEE802154_NetSim_Node_t *node);
+static void IEEE802154_NetSim_txHook(const uint8_t *frame, uint8_t length);
+static uint8_t IEEE802154_NetSim_ccaHook(void);
+static void IEEE802154_NetSim_delivered(const IEEE802154_Payload *payload, uint8_t payloadLength);
+
+/*******************| Function definition |****************************/
+
+/**
+ * xorshift32 of a node, deterministic per seed and node
+ */
+static uint32_t IEEE802154_NetSim_random(IEEE802154_NetSim_Node_t *node)
+{
+  uint32_t x = node->random;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  node->random = x;
+  return x;
+}
+
+/**
+ * Defaults: 100 nodes at 250 kbit/s sending 20 byte frames with acknowledge to the sink
+ * every 0.5 s on average for 10 s.
+ */
+void IEEE802154_NetSim_defaultConfig(IEEE802154_NetSim_Config_t *config)
+{
+  config->nodes = 100;
+  config->seed = 1;
+  config->duration = 31250;
+  config->area = 100;
+  config->range = 40;
+  config->interferenceRange = 60;
+  config->lossPercent = 5;
+  config->bytesPerPeriod = IEEE802154_SIM_BYTES_PER_PERIOD;
+  config->trafficInterval = 1560;
+  config->payloadLength = 20;
+  config->toSink = 1;
+  config->ackRequired = 1;
+  config->workers = 0;
+}
+
+/**
+ * Places the nodes and builds their neighbor lists.
+ * @return 1 on success, 0 if memory is exhausted
+ */
+static uint8_t IEEE802154_NetSim_topology(const IEEE802154_NetSim_Config_t *config)
+{
+  uint16_t i;
+  uint16_t j;
+  sint32_t dx;
+  sint32_t dy;
+  uint32_t distance2;
+  uint32_t range2 = (uint32_t)config->range * config->range;
+  uint32_t interference2 = (uint32_t)config->interferenceRange * config->interferenceRange;
+  IEEE802154_NetSim_Node_t *node;
+  IEEE802154_NetSim_Neighbor_t *neighbor;
+  uint32_t random = config->seed | 1;
+
+  for (i=0; i<config->nodes; i++)
+  {
+    node = &IEEE802154_NetSim_nodes[i];
+    node->index = i;
+    node->random = random;
+    node->x = (uint16_t)(IEEE802154_NetSim_random(node) % config->area);
+    node->y = (uint16_t)(IEEE802154_NetSim_random(node) % config->area);
+    random = node->random;
+  }
+  for (i=0; i<config->nodes; i++)
+  {
+    node = &IEEE802154_NetSim_nodes[i];
+    /* first pass counts, second pass fills */
+    for (node->neighbors = NULL; ; )
+    {
+      node->neighborCount = 0;
+      for (j=0; j<config->nodes; j++)
+      {
+        dx = (sint32_t)node->x - IEEE802154_NetSim_nodes[j].x;
+        dy = (sint32_t)node->y - IEEE802154_NetSim_nodes[j].y;
+        distance2 = (uint32_t)(dx * dx + dy * dy);
+        if ((j == i) || (distance2 > interference2))
+        {
+          continue;
+        }
+        if (node->neighbors != NULL)
+        {
+          neighbor = &node->neighbors[node->neighborCount];
+          neighbor->node = j;
+          neighbor->audible = distance2 <= range2;
+          neighbor->rssi = (sint8_t)(IEEE802154_NETSIM_RSSI_NEAR + IEEE802154_RSSI_OFFSET -
+                                     (sint32_t)IEEE802154_NETSIM_RSSI_SPAN * (sint32_t)distance2 / (sint32_t)(range2 ? range2 : 1));
+        }
+        node->neighborCount++;
+      }
+      if (node->neighbors != NULL)
+      {
+        break;
+      }
+      node->neighbors = malloc((node->neighborCount + 1) * sizeof(IEEE802154_NetSim_Neighbor_t));
+      if (node->neighbors == NULL)
+      {
+        return 0;
+      }
+    }
+    /* node specific stream for traffic and losses */
+    node->random = (config->seed ^ ((uint32_t)i * 0x9E3779B9UL)) | 1;
+  }
+  return 1;
+}
+
+/**
+ * Queues a new frame of the node to the sink or a random neighbor.
+ */
+static void IEEE802154_NetSim_generate(IEEE802154_NetSim_Node_t *node)
+{
+  const IEEE802154_NetSim_Config_t *config = IEEE802154_NetSim_config;
+  IEEE802154_NetSim_TxFrame_t *tx;
+  IEEE802154_ShortAddress_t destination = IEEE802154_BROADCAST_ADDRESS_16BIT;
+  uint16_t candidates = 0;
+  uint16_t i;
+  uint8_t k;
+
+  if (IEEE802154_txQueuePending() >= IEEE802154_TX_QUEUE_SIZE)
+  {
+    node->report.queueFull++;
+    return;
+  }
+  if (config->toSink)
+  {
+    destination = 1;    /* short address of node 0 */
+  }
+  else
+  {
+    for (i=0; i<node->neighborCount; i++)
+    {
+      candidates += node->neighbors[i].audible;
+    }
+    if (candidates > 0)
+    {
+      candidates = (uint16_t)(IEEE802154_NetSim_random(node) % candidates);
+      for (i=0; ; i++)
+      {
+        if (node->neighbors[i].audible && (candidates-- == 0))
+        {
+          break;
+        }
+      }
+      destination = node->neighbors[i].node + 1;
+    }
+  }
+
+  tx = &node->txFrames[node->txNext & (IEEE802154_TX_QUEUE_SIZE - 1)];
+  memset(&tx->header, 0, sizeof(tx->header));
+  tx->header.fcf.frameType = IEEE802154_FCF_FRAME_TYPE_DATA;
+  tx->header.fcf.ackRequired = config->ackRequired && (destination != IEEE802154_BROADCAST_ADDRESS_16BIT);
+  tx->header.fcf.panIdCompression = IEEE802154_FCF_PANIDCOMPRESSION_ENABLED;
+  tx->header.fcf.destinationAddressMode = IEEE802154_FCF_ADDRESS_MODE_16BIT;
+  tx->header.fcf.sourceAddressMode = IEEE802154_FCF_ADDRESS_MODE_16BIT;
+  tx->header.sequenceNumber = node->sequenceNumber++;
+  tx->header.destinationPANID = IEEE802154_NETSIM_PAN_ID;
+  tx->header.destinationAddress.shortAddress = destination;
+#ifndef IEEE802154_ENABLE_PANID_COMPRESSION
+  tx->header.sourcePANID = IEEE802154_NETSIM_PAN_ID;
+#endif
+  tx->header.sourceAddress.shortAddress = node->index + 1;
+  tx->header.payload = tx->payload;
+  /* generation time and source, little endian */
+  tx->payload[0] = (uint8_t)node->now;
+  tx->payload[1] = (uint8_t)(node->now >> 8);
+  tx->payload[2] = (uint8_t)(node->now >> 16);
+  tx->payload[3] = (uint8_t)(node->now >> 24);
+  tx->payload[4] = LO_UINT16(node->index);
+  tx->payload[5] = HI_UINT16(node->index);
+  for (k=IEEE802154_NETSIM_PAYLOAD_MIN; k<config->payloadLength; k++)
+  {
+    tx->payload[k] = k;
+  }
+  if (IEEE802154_radioSentDataFrameAsync(&tx->header, config->payloadLength))
+  {
+    node->txNext++;
+    node->report.generated++;
+  }
+  else
+  {
+    node->report.queueFull++;
+  }
+}
+
+/**
+ * Captures frames sent by the MAC of the node as its current transmission.
+ */
+static void IEEE802154_NetSim_txHook(const uint8_t *frame, uint8_t length)
+{
+  IEEE802154_NetSim_Node_t *node = IEEE802154_NetSim_self;
+  uint32_t now = node->now;
+
+  node->data.start = now;
+  node->data.end = now + IEEE802154_Sim_airtime(length);
+  node->data.length = length;
+  memcpy(node->data.frame, frame, length);
+  node->ownEnd = node->data.end;
+  node->report.transmissions++;
+  /* half duplex, reception in progress is lost */
+  if (node->receiving.length != 0)
+  {
+    node->receiving.length = 0;
+    node->report.collisions++;
+  }
+}
+
+/**
+ * CCA of the node: busy while the node itself or a node within interference range transmits.
+ */
+static uint8_t IEEE802154_NetSim_ccaHook(void)
+{
+  IEEE802154_NetSim_Node_t *node = IEEE802154_NetSim_self;
+  uint32_t now = node->now;
+  uint16_t i;
+
+  if (node->ownEnd > now)
+  {
+    return 0;
+  }
+  for (i=0; i<node->neighborCount; i++)
+  {
+    if (IEEE802154_NetSim_nodes[node->neighbors[i].node].airEnd > now)
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/**
+ * First phase of a period: MAC timer, frame generation and transmissions.
+ */
+static void IEEE802154_NetSim_transmit(IEEE802154_NetSim_Node_t *node)
+{
+  const IEEE802154_NetSim_Config_t *config = IEEE802154_NetSim_config;
+  uint32_t now = node->now;
+
+  if (IEEE802154_Sim_Time < now)
+  {
+    IEEE802154_Sim_advanceTime(now - IEEE802154_Sim_Time);
+  }
+  IEEE802154_Sim_fireDmaInterrupt();
+  IEEE802154_Sim_fireRadioInterrupt();
+  while (node->nextTraffic <= now)
+  {
+    IEEE802154_NetSim_generate(node);
+    node->nextTraffic += 1 + IEEE802154_NetSim_random(node) % (2 * config->trafficInterval - 1);
+  }
+}
+
+/**
+ * A transmission of a neighbor starts: it collides with all overlapping transmissions
+ * heard by the node.
+ */
+static void IEEE802154_NetSim_hear(IEEE802154_NetSim_Node_t *node, const IEEE802154_NetSim_Transmission_t *tx, const IEEE802154_NetSim_Neighbor_t *neighbor)
+{
+  uint8_t collided = (node->interferenceEnd > tx->start) || (node->ownEnd > tx->start);
+
+  if (node->receiving.length != 0)
+  {
+    node->receiving.length = 0;
+    node->report.collisions++;
+  }
+  if (tx->end > node->interferenceEnd)
+  {
+    node->interferenceEnd = tx->end;
+  }
+  if (!neighbor->audible)
+  {
+    return;
+  }
+  if (collided)
+  {
+    node->report.collisions++;
+    return;
+  }
+  node->receiving = *tx;
+  node->receivingRssi = neighbor->rssi;
+}
+
+/**
+ * Hands a completely received frame to the radio of the node if it passes the frame
+ * filter and sends the acknowledge.
+ */
+static void IEEE802154_NetSim_receive(IEEE802154_NetSim_Node_t *node, uint8_t *frame, uint8_t length, sint8_t rssi)
+{
+  IEEE802154_FrameView_t view;
+  IEEE802154_NetSim_Transmission_t *ack;
+  uint8_t *address;
+  uint8_t frameType;
+  uint8_t addressMode;
+  uint8_t broadcast = 0;
+#ifdef IEEE802154_ENABLE_RX_QUEUE
+  IEEE802154_RxQueueSlot_t *slot;
+#endif
+
+  if (!IEEE802154_frameViewInit(&view, frame, length))
+  {
+    return;
+  }
+  frameType = IEEE802154_FRAMEVIEW_FRAME_TYPE(&view);
+  if (frameType != IEEE802154_FCF_FRAME_TYPE_ACKNOWLEDGE)
+  {
+    /* frame filter of the radio */
+    if ((IEEE802154_frameViewDestinationPANID(&view) != IEEE802154_NETSIM_PAN_ID) &&
+        (IEEE802154_frameViewDestinationPANID(&view) != IEEE802154_BROADCAST_PAN_ID))
+    {
+      return;
+    }
+    address = IEEE802154_frameViewDestinationAddress(&view);
+    addressMode = IEEE802154_FRAMEVIEW_DESTINATION_ADDRESS_MODE(&view);
+    if (addressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
+    {
+      broadcast = (IEEE802154_GET_UINT16(address) == IEEE802154_BROADCAST_ADDRESS_16BIT);
+      if (!broadcast && ((address[0] != SHORT_ADDR0) || (address[1] != SHORT_ADDR1)))
+      {
+        return;
+      }
+    }
+    else if ((addressMode != IEEE802154_FCF_ADDRESS_MODE_64BIT) ||
+             (address[0] != EXT_ADDR0) || (address[1] != EXT_ADDR1) || (address[2] != EXT_ADDR2) || (address[3] != EXT_ADDR3) ||
+             (address[4] != EXT_ADDR4) || (address[5] != EXT_ADDR5) || (address[6] != EXT_ADDR6) || (address[7] != EXT_ADDR7))
+    {
+      return;
+    }
+  }
+  IEEE802154_Sim_pushRxFrame(frame, length, rssi, IEEE802154_CRCOK_MASK | IEEE802154_NETSIM_CORRELATION);
+  IEEE802154_Sim_fireRadioInterrupt();
+  IEEE802154_Sim_fireDmaInterrupt();
+#ifdef IEEE802154_ENABLE_RX_QUEUE
+  while ((slot = IEEE802154_rxQueuePeek()) != NULL)
+  {
+    if (slot->header.fcf.frameType == IEEE802154_FCF_FRAME_TYPE_DATA)
+    {
+      IEEE802154_NetSim_delivered(slot->payload, slot->payloadLength);
+    }
+    IEEE802154_rxQueueRelease();
+  }
+#endif
+
+  if ((frameType == IEEE802154_FCF_FRAME_TYPE_DATA) && !broadcast &&
+      (frame[0] & IEEE802154_FCF0_ACKNOWLEDGE_REQUIRED_MASK) && (FRMCTRL0 & FRMCTRL0_AUTOACK_ENABLED))
+  {
+    /* AUTOACK, sent after the turnaround time in the next period */
+    ack = &node->ack[node->now & 1];
+    ack->frame[0] = IEEE802154_FCF_FRAME_TYPE_ACKNOWLEDGE;
+    ack->frame[1] = 0;
+    ack->frame[2] = IEEE802154_FRAMEVIEW_SEQUENCE_NUMBER(&view);
+    ack->length = IEEE802154_FRAME_HEADER_MIN;
+    ack->start = node->now + 1;
+    ack->end = ack->start + IEEE802154_Sim_airtime(ack->length);
+    node->ownEnd = ack->end;
+    node->ackPending = 1;
+    node->report.acksSent++;
+  }
+}
+
+/**
+ * Second phase of a period: registers the transmissions of neighbors starting in this
+ * period and receives the frame ending in it.
+ * @return next period the node has something to do
+ */
+static uint32_t IEEE802154_NetSim_listen(IEEE802154_NetSim_Node_t *node)
+{
+  const IEEE802154_NetSim_Config_t *config = IEEE802154_NetSim_config;
+  uint32_t now = node->now;
+  const IEEE802154_NetSim_Node_t *other;
+  const IEEE802154_NetSim_Transmission_t *ack;
+  uint8_t frame[IEEE802154_MAX_PHY_PACKET_SIZE];
+  uint8_t length;
+  uint32_t next;
+  uint16_t i;
+
+  node->ackPending = 0;
+  for (i=0; i<node->neighborCount; i++)
+  {
+    other = &IEEE802154_NetSim_nodes[node->neighbors[i].node];
+    if ((other->data.length != 0) && (other->data.start == now))
+    {
+      IEEE802154_NetSim_hear(node, &other->data, &node->neighbors[i]);
+    }
+    ack = &other->ack[(now - 1) & 1];
+    if ((ack->length != 0) && (ack->start == now))
+    {
+      IEEE802154_NetSim_hear(node, ack, &node->neighbors[i]);
+    }
+  }
+  if ((node->receiving.length != 0) && (node->receiving.end == now + 1))
+  {
+    length = node->receiving.length;
+    memcpy(frame, node->receiving.frame, length);
+    node->receiving.length = 0;
+    if (IEEE802154_NetSim_random(node) % 100 < config->lossPercent)
+    {
+      node->report.lost++;
+    }
+    else
+    {
+      IEEE802154_NetSim_receive(node, frame, length, node->receivingRssi);
+    }
+  }
+
+  /* publish state for CCA of neighbors */
+  node->airEnd = node->ownEnd;
+  next = node->nextTraffic;
+  if (node->ackPending || (IEEE802154_txQueuePending() > 0))
+  {
+    next = now + 1;
+  }
+  if ((node->receiving.length != 0) && (node->receiving.end - 1 < next))
+  {
+    next = node->receiving.end - 1;
+  }
+  return next;
+}
+
+/**
+ * Sets up the instance of the MAC of a node, IEEE802154_Instance must point to it.
+ */
+static void IEEE802154_NetSim_init(IEEE802154_NetSim_Node_t *node)
+{
+  const IEEE802154_NetSim_Config_t *config = IEEE802154_NetSim_config;
+  IEEE802154_Config_t radioConfig;
+
+#ifdef IEEE802154_ENABLE_CSMA
+  IEEE802154_CsmaConfig = IEEE802154_Context.csmaConfig;
+#endif
+  IEEE802154_Sim_reset();
+  IEEE802154_Sim_BytesPerPeriod = config->bytesPerPeriod;
+  IEEE802154_Sim_TxHook = IEEE802154_NetSim_txHook;
+  IEEE802154_Sim_CcaHook = IEEE802154_NetSim_ccaHook;
+  /* factory address of the node */
+  IEEE_EXTENDED_ADDRESS0 = LO_UINT16(node->index);
+  IEEE_EXTENDED_ADDRESS1 = HI_UINT16(node->index);
+  IEEE_EXTENDED_ADDRESS5 = 0x4B;
+  IEEE_EXTENDED_ADDRESS6 = 0x12;
+#ifndef IEEE802154_ENABLE_RX_QUEUE
+  IEEE802154_RxDataFrame.payload = node->rxPayload;
+#endif
+  radioConfig.Channel = IEEE802154_NETSIM_CHANNEL;
+  radioConfig.shortAddress = node->index + 1;
+  radioConfig.PanID = IEEE802154_NETSIM_PAN_ID;
+  IEEE802154_radioInit(&radioConfig);
+  node->nextTraffic = IEEE802154_NETSIM_TIME_NEVER;
+  if ((config->trafficInterval != 0) && !(config->toSink && (node->index == 0)))
+  {
+    node->nextTraffic = IEEE802154_NetSim_random(node) % config->trafficInterval;
+  }
+}
+
+/**
+ * Thread of a worker: sets up the nodes of its block and runs their periods.
+ */
+static void* IEEE802154_NetSim_worker(void *argument)
+{
+  IEEE802154_NetSim_Worker_t *worker = argument;
+  const IEEE802154_NetSim_Config_t *config = IEEE802154_NetSim_config;
+  IEEE802154_NetSim_Node_t *node;
+  uint32_t now = 0;
+  uint32_t next;
+  uint32_t active;
+  uint16_t i;
+
+  pthread_mutex_lock(&IEEE802154_NetSim_startLock);
+  while (IEEE802154_NetSim_startState == 0)
+  {
+    pthread_cond_wait(&IEEE802154_NetSim_startCondition, &IEEE802154_NetSim_startLock);
+  }
+  pthread_mutex_unlock(&IEEE802154_NetSim_startLock);
+  if (IEEE802154_NetSim_startState != 1)
+  {
+    return NULL;
+  }
+
+  for (i=worker->first; i<worker->last; i++)
+  {
+    node = &IEEE802154_NetSim_nodes[i];
+    IEEE802154_Instance = &node->context;
+    IEEE802154_NetSim_init(node);
+  }
+  while (now < config->duration)
+  {
+    for (i=worker->first; i<worker->last; i++)
+    {
+      node = &IEEE802154_NetSim_nodes[i];
+      IEEE802154_Instance = &node->context;
+      node->now = now;
+      IEEE802154_NetSim_transmit(node);
+    }
+    pthread_barrier_wait(&IEEE802154_NetSim_barrier);
+    next = IEEE802154_NETSIM_TIME_NEVER;
+    for (i=worker->first; i<worker->last; i++)
+    {
+      node = &IEEE802154_NetSim_nodes[i];
+      IEEE802154_Instance = &node->context;
+      active = IEEE802154_NetSim_listen(node);
+      if (active < next)
+      {
+        next = active;
+      }
+    }
+    worker->nextActive = next;
+    pthread_barrier_wait(&IEEE802154_NetSim_barrier);
+    /* every worker computes the same next period, idle periods are skipped */
+    for (i=0; i<IEEE802154_NetSim_workerCount; i++)
+    {
+      if (IEEE802154_NetSim_workers[i].nextActive < next)
+      {
+        next = IEEE802154_NetSim_workers[i].nextActive;
+      }
+    }
+    now = next;
+  }
+  return NULL;
+}
+
+/**
+ * Runs a simulation.
+ * @param config parameters of the run
+ * @param reports result, one entry per node
+ * @return 1 on success, 0 if the configuration is invalid or threads could not be created
+ */
+uint8_t IEEE802154_NetSim_run(const IEEE802154_NetSim_Config_t *config, IEEE802154_NetSim_Report_t *reports)
+{
+  IEEE802154_NetSim_Worker_t *worker;
+  uint16_t workers = config->workers;
+  long processors;
+  uint16_t created;
+  uint16_t i;
+  uint8_t result = 0;
+
+  if ((config->nodes == 0) || (config->nodes > IEEE802154_NETSIM_MAX_NODES) || (config->area == 0) ||
+      (config->interferenceRange < config->range) || (config->lossPercent > 100) || (config->bytesPerPeriod == 0) ||
+      (config->payloadLength < IEEE802154_NETSIM_PAYLOAD_MIN) || (config->payloadLength > IEEE802154_NETSIM_PAYLOAD_MAX))
+  {
+    return 0;
+  }
+  if (workers == 0)
+  {
+    processors = sysconf(_SC_NPROCESSORS_ONLN);
+    workers = (processors > 0) ? (uint16_t)((processors < config->nodes) ? processors : config->nodes) : 1;
+  }
+  if (workers > config->nodes)
+  {
+    workers = config->nodes;
+  }
+  IEEE802154_NetSim_config = config;
+  IEEE802154_NetSim_nodes = calloc(config->nodes, sizeof(IEEE802154_NetSim_Node_t));
+  IEEE802154_NetSim_workers = calloc(workers, sizeof(IEEE802154_NetSim_Worker_t));
+  IEEE802154_NetSim_workerCount = workers;
+  if ((IEEE802154_NetSim_nodes != NULL) && (IEEE802154_NetSim_workers != NULL) &&
+      IEEE802154_NetSim_topology(config) &&
+      (pthread_barrier_init(&IEEE802154_NetSim_barrier, NULL, workers) == 0))
+  {
+    IEEE802154_NetSim_startState = 0;
+    for (created=0; created<workers; created++)
+    {
+      worker = &IEEE802154_NetSim_workers[created];
+      worker->first = (uint16_t)((uint32_t)created * config->nodes / workers);
+      worker->last = (uint16_t)((uint32_t)(created + 1) * config->nodes / workers);
+      if (pthread_create(&worker->thread, NULL, IEEE802154_NetSim_worker, worker) != 0)
+      {
+        break;
+      }
+    }
+    /* workers only start once all exist, the barrier needs all of them */
+    pthread_mutex_lock(&IEEE802154_NetSim_startLock);
+    IEEE802154_NetSim_startState = (created == workers) ? 1 : 2;
+    pthread_cond_broadcast(&IEEE802154_NetSim_startCondition);
+    pthread_mutex_unlock(&IEEE802154_NetSim_startLock);
+    for (i=0; i<created; i++)
+    {
+      pthread_join(IEEE802154_NetSim_workers[i].thread, NULL);
+    }
+    pthread_barrier_destroy(&IEEE802154_NetSim_barrier);
+    if (created == workers)
+    {
+      for (i=0; i<config->nodes; i++)
+      {
+        reports[i] = IEEE802154_NetSim_nodes[i].report;
+      }
+      result = 1;
+    }
+  }
+  if (IEEE802154_NetSim_nodes != NULL)
+  {
+    for (i=0; i<config->nodes; i++)
+    {
+      free(IEEE802154_NetSim_nodes[i].neighbors);
+    }
+  }
+  free(IEEE802154_NetSim_nodes);
+  free(IEEE802154_NetSim_workers);
+  IEEE802154_NetSim_nodes = NULL;
+  IEEE802154_NetSim_workers = NULL;
+  return result;
+}
+
+/**
+ * Prints throughput, latency and loss per node and for the network.
+ */
+void IEEE802154_NetSim_printReport(FILE *file, const IEEE802154_NetSim_Config_t *config, const IEEE802154_NetSim_Report_t *reports)
+{
+  IEEE802154_NetSim_Report_t total;
+  const IEEE802154_NetSim_Report_t *report;
+  uint16_t i;
+
+  memset(&total, 0, sizeof(total));
+  fprintf(file, "node generated queueFull     sent    noAck  chAccFail  txFrames acksSent received  kbit/s latency[ms] max[ms] collisions    lost\n");
+  for (i=0; i<=config->nodes; i++)
+  {
+    report = &reports[i];
+    if (i == config->nodes)
+    {
+      report = &total;
+      fprintf(file, "all ");
+    }
+    else
+    {
+      total.generated += report->generated;
+      total.queueFull += report->queueFull;
+      total.sent += report->sent;
+      total.noAck += report->noAck;
+      total.channelAccessFailures += report->channelAccessFailures;
+      total.transmissions += report->transmissions;
+      total.acksSent += report->acksSent;
+      total.received += report->received;
+      total.receivedBytes += report->receivedBytes;
+      total.latencyTotal += report->latencyTotal;
+      if (report->latencyMax > total.latencyMax)
+      {
+        total.latencyMax = report->latencyMax;
+      }
+      total.collisions += report->collisions;
+      total.lost += report->lost;
+      fprintf(file, "%4u ", (unsigned)i);
+    }
+    /* one backoff period is 320us */
+    fprintf(file, "%9lu %9lu %8lu %8lu %10lu %9lu %8lu %8lu %7.2f %11.2f %7.2f %10lu %7lu\n",
+            (unsigned long)report->generated, (unsigned long)report->queueFull, (unsigned long)report->sent,
+            (unsigned long)report->noAck, (unsigned long)report->channelAccessFailures, (unsigned long)report->transmissions,
+            (unsigned long)report->acksSent, (unsigned long)report->received,
+            config->duration ? report->receivedBytes * 8.0 / (config->duration * 0.32) : 0.0,
+            report->received ? report->latencyTotal * 0.32 / report->received : 0.0,
+            report->latencyMax * 0.32, (unsigned long)report->collisions, (unsigned long)report->lost);
+  }
+}
+
+/**
+ * Accounts a data frame delivered to the application of the node.
+ */
+static void IEEE802154_NetSim_delivered(const IEEE802154_Payload *payload, uint8_t payloadLength)
+{
+  IEEE802154_NetSim_Node_t *node = IEEE802154_NetSim_self;
+  uint32_t latency;
+
+  if (payloadLength < IEEE802154_NETSIM_PAYLOAD_MIN)
+  {
+    return;
+  }
+  latency = node->now - ((uint32_t)payload[0] | ((uint32_t)payload[1] << 8) |
+                                     ((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24));
+  node->report.received++;
+  node->report.receivedBytes += payloadLength;
+  node->report.latencyTotal += latency;
+  if (latency > node->report.latencyMax)
+  {
+    node->report.latencyMax = latency;
+  }
+}
+
+void IEEE802154_UserCbk_DataFrameReceived(uint8_t payloadLength, sint8_t rssi)
+{
+#ifndef IEEE802154_ENABLE_RX_QUEUE
+  IEEE802154_NetSim_delivered(IEEE802154_RxDataFrame.payload, payloadLength);
+#else
+  (void)payloadLength;
+#endif
+  (void)rssi;
+}
+
+void IEEE802154_UserCbk_BeaconFrameReceived(uint8_t payloadLength, sint8_t rssi)
+{
+  (void)payloadLength;
+  (void)rssi;
+}
+
+void IEEE802154_UserCbk_AckFrameReceived(uint8_t payloadLength, sint8_t rssi)
+{
+  (void)payloadLength;
+  (void)rssi;
+}
+
+void IEEE802154_UserCbk_MACCommandFrameReceived(uint8_t payloadLength, sint8_t rssi)
+{
+  (void)payloadLength;
+  (void)rssi;
+}
+
+void IEEE802154_UserCbk_CRCError(uint8_t payloadLength, sint8_t rssi)
+{
+  (void)payloadLength;
+  (void)rssi;
+}
+
+void IEEE802154_UserCbk_DataFrameSent(IEEE802154_DataFrameHeader_t* header, uint8_t status)
+{
+  IEEE802154_NetSim_Node_t *node = IEEE802154_NetSim_self;
+  (void)header;
+  switch (status)
+  {
+    case IEEE802154_TX_SUCCESS:
+      node->report.sent++;
+      break;
+    case IEEE802154_TX_NO_ACK:
+      node->report.noAck++;
+      break;
+    default:
+      /* frames are not secured, no other status occurs */
+      node->report.channelAccessFailures++;
+      break;
+  }
+}
+
+void IEEE802154_UserCbk_FlowFrameSent(IEEE802154_Flow_t *flow, uint8_t sequenceNumber, uint8_t status)
+{
+  (void)flow;
+  (void)sequenceNumber;
+  (void)status;
+}
+
+#endif
+
+/** @}*/
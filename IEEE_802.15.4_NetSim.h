@@ -0,0 +1,88 @@
+/** @ingroup IEEE_802.15.4
+ * @{
+ */
+#ifndef IEEE_802_15_4_NETSIM_H_
+#define IEEE_802_15_4_NETSIM_H_
+
+/**
+ * Discrete-event simulation of a network of nodes running the MAC on the host. Requires
+ * IEEE802154_ENABLE_NETSIM, see IEEE_802.15.4.h. Every node is an instance of the MAC
+ * with the emulated radio of IEEE_802.15.4_Sim.c in a context of its own, nodes share a
+ * virtual medium:
+ * - nodes are placed at random in a square, frames are received up to range and collide
+ *   with and make CCA busy for all transmissions up to interferenceRange
+ * - a frame occupies the medium for its airtime, see IEEE802154_Sim_airtime(), a
+ *   receiver loses it if any other transmission it hears overlaps it or if it transmits
+ *   itself meanwhile (half duplex), otherwise it is lost with probability lossPercent
+ * - frames passing the frame filter are acknowledged as AUTOACK of the radio would do
+ * - each node generates frames with a random interval to the sink (node 0) or to a
+ *   random node in range, the payload carries source and generation time
+ * Time advances in backoff periods. The nodes are split into contiguous blocks, one per
+ * worker thread, the workers do a period in lockstep separated by barriers: first every
+ * node runs its MAC timer, CCA and transmissions, then every node receives the
+ * transmissions of its neighbors. Periods in which no node has anything to do are
+ * skipped. The result only depends on the configuration and the seed, not on the number
+ * of workers or the scheduling of the threads.
+*/
+
+/*******************| Inclusions |*************************************/
+#include <PlatformTypes.h>
+#include <stdio.h>
+
+/*******************| Macros |*****************************************/
+#define IEEE802154_NETSIM_PAN_ID                (IEEE802154_PANIdentifier_t)0x1A2B
+#define IEEE802154_NETSIM_CHANNEL               IEEE802154_CHANNEL_FIRST
+#define IEEE802154_NETSIM_HEADER_SIZE           (uint8_t)9      /**< data frame header with short addresses and PAN ID compression */
+#define IEEE802154_NETSIM_PAYLOAD_MIN           (uint8_t)6      /**< generation time and source node carried in the payload */
+#define IEEE802154_NETSIM_PAYLOAD_MAX           (uint8_t)(IEEE802154_MAX_PHY_PACKET_SIZE - IEEE802154_CRCLENGTH - IEEE802154_NETSIM_HEADER_SIZE)
+#define IEEE802154_NETSIM_MAX_NODES             (uint16_t)0xFFF0
+
+/*******************| Type definitions |*******************************/
+/**
+ * Parameters of a simulation run, see IEEE802154_NetSim_defaultConfig()
+ */
+typedef struct {
+  uint16_t nodes;                       /**< number of nodes, node 0 is the sink */
+  uint32_t seed;                        /**< placement, traffic and losses are reproducible for a seed */
+  uint32_t duration;                    /**< simulated time in backoff periods */
+  uint16_t area;                        /**< nodes are placed in a square of this side length */
+  uint16_t range;                       /**< distance up to which frames are received */
+  uint16_t interferenceRange;           /**< distance up to which transmissions collide and make CCA busy, at least range */
+  uint8_t lossPercent;                  /**< probability in percent that a frame in range is not received */
+  uint8_t bytesPerPeriod;               /**< airtime model, IEEE802154_SIM_BYTES_PER_PERIOD for 250 kbit/s */
+  uint32_t trafficInterval;             /**< mean backoff periods between frames generated by a node, 0: no traffic */
+  uint8_t payloadLength;                /**< IEEE802154_NETSIM_PAYLOAD_MIN to IEEE802154_NETSIM_PAYLOAD_MAX */
+  uint8_t toSink;                       /**< 1: frames are sent to node 0, 0: to a random node in range */
+  uint8_t ackRequired;                  /**< frames request an acknowledge */
+  uint16_t workers;                     /**< worker threads running the nodes, 0: one per online CPU */
+} IEEE802154_NetSim_Config_t;
+
+/**
+ * Result of a simulation run for one node
+ */
+typedef struct {
+  uint32_t generated;                   /**< frames handed to the MAC */
+  uint32_t queueFull;                   /**< frames not generated as the transmit queue was full */
+  uint32_t sent;                        /**< frames completed with IEEE802154_TX_SUCCESS */
+  uint32_t noAck;                       /**< frames completed with IEEE802154_TX_NO_ACK */
+  uint32_t channelAccessFailures;       /**< frames completed with IEEE802154_TX_CHANNEL_ACCESS_FAILURE */
+  uint32_t transmissions;               /**< data frames put on air including retransmissions */
+  uint32_t acksSent;                    /**< acknowledges sent */
+  uint32_t received;                    /**< data frames delivered to the application, duplicates included */
+  uint32_t receivedBytes;               /**< payload bytes of received frames */
+  uint64_t latencyTotal;                /**< backoff periods from generation to delivery summed over received frames */
+  uint32_t latencyMax;                  /**< largest latency of a received frame in backoff periods */
+  uint32_t collisions;                  /**< frames in range lost as other transmissions overlapped them */
+  uint32_t lost;                        /**< frames in range lost due to lossPercent */
+} IEEE802154_NetSim_Report_t;
+
+/*******************| Global variables |*******************************/
+
+/*******************| Function prototypes |****************************/
+void IEEE802154_NetSim_defaultConfig(IEEE802154_NetSim_Config_t *config);
+uint8_t IEEE802154_NetSim_run(const IEEE802154_NetSim_Config_t *config, IEEE802154_NetSim_Report_t *reports);
+void IEEE802154_NetSim_printReport(FILE *file, const IEEE802154_NetSim_Config_t *config, const IEEE802154_NetSim_Report_t *reports);
+
+#endif
+
+/** @}*/
@@ -0,0 +1,98 @@
+/** @ingroup IEEE_802.15.4
+ * @{
+ */
+#ifndef IEEE_802_15_4_RADIO_H_
+#define IEEE_802_15_4_RADIO_H_
+
+/**
+ * Radio backend used by the IEEE 802.15.4 MAC. All accesses of the MAC to the
+ * radio FIFOs and to the command strobe processor are done via the macros below.
+ * Two backends are available:
+ * - CC2530 register model (default): macros map directly onto the SFRs RFD and RFST
+ * - In-memory FIFO emulator (IEEE802154_SIMULATION defined in Config.h or on the
+ *   compiler command line): macros map onto IEEE_802.15.4_Sim.c so that the MAC can
+ *   be run and measured on the host
+ * All other radio registers (RFIRQF0, FRMCTRL0, ...) are accessed by name in both
+ * backends, the emulator provides them as plain variables.
+*/
+
+/*******************| Inclusions |*************************************/
+#include <Config.h>
+#ifdef IEEE802154_SIMULATION
+#include "IEEE_802.15.4_Sim.h"
+#else
+#include <ioCC2530.h>
+#include <cc253x.h>
+#include <stddef.h>
+#endif
+
+/*******************| Macros |*****************************************/
+#ifdef IEEE802154_SIMULATION
+#define IEEE802154_RADIO_STROBE(instruction)    IEEE802154_Sim_strobe(instruction)
+#define IEEE802154_RADIO_READ_RFD()             IEEE802154_Sim_readRxFifo()
+#define IEEE802154_RADIO_WRITE_RFD(value)       IEEE802154_Sim_writeTxFifo(value)
+#define IEEE802154_RADIO_ISR_ATTRIBUTES                                 /* plain function on host, called by IEEE802154_Sim_fireRadioInterrupt() */
+#define IEEE802154_RADIO_TIMESTAMP()            IEEE802154_Sim_Time
+#define IEEE802154_RADIO_CYCLES()               IEEE802154_Sim_readCycles()
+#define IEEE802154_RADIO_TIMESTAMP_FINE(count)  ((count) = 0, IEEE802154_Sim_Time)     /* resolution of one backoff period */
+#define IEEE802154_RADIO_BUSY_WAIT()            IEEE802154_Sim_busyWait()       /* deliver pending interrupts and let time pass while MAC waits */
+#define IEEE802154_RADIO_DMA_FROM_RXFIFO(destination, length)   IEEE802154_Sim_dmaFromRxFifo((destination), (length))
+#define IEEE802154_RADIO_DMA_TO_TXFIFO(source, length)          IEEE802154_Sim_dmaToTxFifo((source), (length))
+#else
+#define IEEE802154_RADIO_STROBE(instruction)    RFST = (instruction)
+#define IEEE802154_RADIO_READ_RFD()             RFD
+#define IEEE802154_RADIO_WRITE_RFD(value)       RFD = (value)
+#define IEEE802154_RADIO_ISR_ATTRIBUTES         __near_func __interrupt
+#define IEEE802154_RADIO_TIMESTAMP()            IEEE802154_radioReadMacTimer()
+#define IEEE802154_RADIO_CYCLES()               IEEE802154_radioReadCycles()
+#define IEEE802154_RADIO_TIMESTAMP_FINE(count)  IEEE802154_radioReadMacTimerFine(&(count))
+#define IEEE802154_RADIO_BUSY_WAIT()
+#define IEEE802154_XDATA_ADDRESS(ptr)           (uint16_t)(size_t)(ptr)
+#define IEEE802154_RADIO_DMA_FROM_RXFIFO(destination, length)   IEEE802154_radioDmaStart(IEEE802154_DMA_RX_CHANNEL, DMA_RFD_XADDR, IEEE802154_XDATA_ADDRESS(destination), (length), \
+                                                                                         DMA_SRCINC_0 | DMA_DESTINC_1 | DMA_IRQMASK_ENABLE | DMA_M8_USE_8_BITS | DMA_PRI_HIGH)
+#define IEEE802154_RADIO_DMA_TO_TXFIFO(source, length)          IEEE802154_radioDmaStart(IEEE802154_DMA_TX_CHANNEL, IEEE802154_XDATA_ADDRESS(source), DMA_RFD_XADDR, (length), \
+                                                                                         DMA_SRCINC_1 | DMA_DESTINC_0 | DMA_IRQMASK_ENABLE | DMA_M8_USE_8_BITS | DMA_PRI_HIGH)
+#endif
+
+/**
+ * FIFO access of the MAC. With IEEE802154_ENABLE_SOFTWARE_CRC the FCS is computed while
+ * the frame passes RFD instead of by the AUTOCRC hardware.
+ */
+#ifdef IEEE802154_ENABLE_SOFTWARE_CRC
+#define IEEE802154_RADIO_READ_RXFIFO()          IEEE802154_radioReadRxFifoFcs()
+#define IEEE802154_RADIO_WRITE_TXFIFO(value)    IEEE802154_radioWriteTxFifoFcs(value)
+#else
+#define IEEE802154_RADIO_READ_RXFIFO()          IEEE802154_RADIO_READ_RFD()
+#define IEEE802154_RADIO_WRITE_TXFIFO(value)    IEEE802154_RADIO_WRITE_RFD(value)
+#endif
+
+/*******************| Global variables |*******************************/
+#if defined(IEEE802154_ENABLE_DMA) && !defined(IEEE802154_SIMULATION)
+/**
+ * Descriptors of DMA channel 1-4 (DMA1CFG), index 0 is channel 1. Entries of the
+ * channels not used by the driver may be filled by the application.
+ */
+extern __xdata IEEE802154_DmaDescriptor_t IEEE802154_DmaDescriptor[4];
+#endif
+
+/*******************| Function prototypes |****************************/
+#ifdef IEEE802154_ENABLE_SOFTWARE_CRC
+uint8_t IEEE802154_radioReadRxFifoFcs(void);
+void IEEE802154_radioWriteTxFifoFcs(uint8_t value);
+#endif
+#ifndef IEEE802154_SIMULATION
+IEEE802154_Timestamp_t IEEE802154_radioReadMacTimer(void);
+#if defined(IEEE802154_ENABLE_STATISTICS) || defined(IEEE802154_ENABLE_SNIFFER)
+IEEE802154_Timestamp_t IEEE802154_radioReadMacTimerFine(uint16_t *count);
+#endif
+#ifdef IEEE802154_ENABLE_STATISTICS
+uint32_t IEEE802154_radioReadCycles(void);
+#endif
+#ifdef IEEE802154_ENABLE_DMA
+void IEEE802154_radioDmaStart(uint8_t channel, uint16_t source, uint16_t destination, uint8_t length, uint8_t config);
+#endif
+#endif
+
+#endif
+
+/** @}*/
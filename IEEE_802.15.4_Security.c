@@ -0,0 +1,657 @@
+/** @ingroup IEEE_802.15.4
+ * @{
+ */
+/*******************| Inclusions |*************************************/
+#include "IEEE_802.15.4.h"
+#include "IEEE_802.15.4_Radio.h"
+#include <stddef.h>
+
+/**
+ * MAC security according to 802.15.4-2006 Chapter "7.6 Security suite specifications":
+ * auxiliary security header, frame counters and CCM* with AES-128 (Annex B).
+ * All secured frames use the key set by IEEE802154_securitySetKey(), the key identifier
+ * of the auxiliary security header is transmitted and received but not used for key
+ * lookup. Sources of secured frames must be known by IEEE802154_securityDeviceAdd(),
+ * the device table provides the extended address for the nonce of frames with short
+ * source address and the lowest frame counter accepted next.
+ * The block cipher is the AES coprocessor of the CC2530 (swru191c.pdf Chapter 17 AES
+ * Coprocessor) in ECB mode, fed by the CPU one block at a time. CTR and CBC-MAC of CCM*
+ * are built on top of it so the same code runs with the software AES of the simulator
+ * (IEEE802154_SIMULATION) or of IEEE802154_ENABLE_SOFTWARE_AES.
+ * Only compiled in if IEEE802154_ENABLE_SECURITY is defined.
+*/
+#ifdef IEEE802154_ENABLE_SECURITY
+
+/*******************| Macros |*****************************************/
+/* CCM* with 2 byte length field (L = 2), frames are shorter than 2^16 bytes */
+#define IEEE802154_CCM_FLAGS_L                  (uint8_t)0x01   /**< L - 1 */
+#define IEEE802154_CCM_FLAGS_ADATA              (uint8_t)0x40
+#define IEEE802154_CCM_FLAGS_M(micLength)       (uint8_t)((((micLength) - 2) / 2) << 3)
+
+#define IEEE802154_SHORT_ADDRESS_NONE           (IEEE802154_ShortAddress_t)0xFFFE
+
+/* the command frame identifier of MAC command frames is not encrypted but authenticated
+ * like the header, see the secured MAC command frame of 802.15.4-2006 Annex C.2.3 */
+#define IEEE802154_OPEN_PAYLOAD_LENGTH(header, payloadLength)  \
+  (uint8_t)(((header)->fcf.frameType == IEEE802154_FCF_FRAME_TYPE_MAC_COMMAND) && ((payloadLength) > 0))
+
+/*******************| Type definitions |*******************************/
+
+/*******************| Global variables |*******************************/
+#define IEEE802154_securityDevices              (IEEE802154_Instance->securityDevices)
+#define IEEE802154_securityKeyLoaded            (IEEE802154_Instance->securityKeyLoaded)
+#define IEEE802154_securityBuffer               (IEEE802154_Instance->securityBuffer)
+#ifdef IEEE802154_SOFTWARE_AES
+#define IEEE802154_aesRoundKeys                 (IEEE802154_Instance->aesRoundKeys)
+
+static const uint8_t IEEE802154_aesSbox[256] =
+{
+  0x63, 0x7C, 0x77, 0x7B, 0xF2, 0x6B, 0x6F, 0xC5, 0x30, 0x01, 0x67, 0x2B, 0xFE, 0xD7, 0xAB, 0x76,
+  0xCA, 0x82, 0xC9, 0x7D, 0xFA, 0x59, 0x47, 0xF0, 0xAD, 0xD4, 0xA2, 0xAF, 0x9C, 0xA4, 0x72, 0xC0,
+  0xB7, 0xFD, 0x93, 0x26, 0x36, 0x3F, 0xF7, 0xCC, 0x34, 0xA5, 0xE5, 0xF1, 0x71, 0xD8, 0x31, 0x15,
+  0x04, 0xC7, 0x23, 0xC3, 0x18, 0x96, 0x05, 0x9A, 0x07, 0x12, 0x80, 0xE2, 0xEB, 0x27, 0xB2, 0x75,
+  0x09, 0x83, 0x2C, 0x1A, 0x1B, 0x6E, 0x5A, 0xA0, 0x52, 0x3B, 0xD6, 0xB3, 0x29, 0xE3, 0x2F, 0x84,
+  0x53, 0xD1, 0x00, 0xED, 0x20, 0xFC, 0xB1, 0x5B, 0x6A, 0xCB, 0xBE, 0x39, 0x4A, 0x4C, 0x58, 0xCF,
+  0xD0, 0xEF, 0xAA, 0xFB, 0x43, 0x4D, 0x33, 0x85, 0x45, 0xF9, 0x02, 0x7F, 0x50, 0x3C, 0x9F, 0xA8,
+  0x51, 0xA3, 0x40, 0x8F, 0x92, 0x9D, 0x38, 0xF5, 0xBC, 0xB6, 0xDA, 0x21, 0x10, 0xFF, 0xF3, 0xD2,
+  0xCD, 0x0C, 0x13, 0xEC, 0x5F, 0x97, 0x44, 0x17, 0xC4, 0xA7, 0x7E, 0x3D, 0x64, 0x5D, 0x19, 0x73,
+  0x60, 0x81, 0x4F, 0xDC, 0x22, 0x2A, 0x90, 0x88, 0x46, 0xEE, 0xB8, 0x14, 0xDE, 0x5E, 0x0B, 0xDB,
+  0xE0, 0x32, 0x3A, 0x0A, 0x49, 0x06, 0x24, 0x5C, 0xC2, 0xD3, 0xAC, 0x62, 0x91, 0x95, 0xE4, 0x79,
+  0xE7, 0xC8, 0x37, 0x6D, 0x8D, 0xD5, 0x4E, 0xA9, 0x6C, 0x56, 0xF4, 0xEA, 0x65, 0x7A, 0xAE, 0x08,
+  0xBA, 0x78, 0x25, 0x2E, 0x1C, 0xA6, 0xB4, 0xC6, 0xE8, 0xDD, 0x74, 0x1F, 0x4B, 0xBD, 0x8B, 0x8A,
+  0x70, 0x3E, 0xB5, 0x66, 0x48, 0x03, 0xF6, 0x0E, 0x61, 0x35, 0x57, 0xB9, 0x86, 0xC1, 0x1D, 0x9E,
+  0xE1, 0xF8, 0x98, 0x11, 0x69, 0xD9, 0x8E, 0x94, 0x9B, 0x1E, 0x87, 0xE9, 0xCE, 0x55, 0x28, 0xDF,
+  0x8C, 0xA1, 0x89, 0x0D, 0xBF, 0xE6, 0x42, 0x68, 0x41, 0x99, 0x2D, 0x0F, 0xB0, 0x54, 0xBB, 0x16
+};
+#endif
+
+/*******************| Function definition |****************************/
+
+#ifdef IEEE802154_SOFTWARE_AES
+/**
+ * Multiplication by x in GF(2^8) with the AES polynomial.
+*/
+static uint8_t IEEE802154_aesXtime(uint8_t value)
+{
+  return (uint8_t)((value << 1) ^ ((value & 0x80) ? 0x1B : 0x00));
+}
+
+/**
+ * Expands the key into the round keys of AES-128 (FIPS-197 Chapter 5.2).
+*/
+static void IEEE802154_aesLoadKey(const uint8_t *key)
+{
+  uint8_t i;
+  uint8_t rcon = 0x01;
+  for (i=0; i<IEEE802154_AES_BLOCK_SIZE; i++)
+  {
+    IEEE802154_aesRoundKeys[i] = key[i];
+  }
+  for (i=IEEE802154_AES_BLOCK_SIZE; i<sizeof(IEEE802154_aesRoundKeys); i+=4)
+  {
+    if ((i & (IEEE802154_AES_BLOCK_SIZE - 1)) == 0)
+    {
+      /* RotWord, SubWord and round constant on the first word of each round key */
+      IEEE802154_aesRoundKeys[i]     = IEEE802154_aesRoundKeys[i - 16] ^ IEEE802154_aesSbox[IEEE802154_aesRoundKeys[i - 3]] ^ rcon;
+      IEEE802154_aesRoundKeys[i + 1] = IEEE802154_aesRoundKeys[i - 15] ^ IEEE802154_aesSbox[IEEE802154_aesRoundKeys[i - 2]];
+      IEEE802154_aesRoundKeys[i + 2] = IEEE802154_aesRoundKeys[i - 14] ^ IEEE802154_aesSbox[IEEE802154_aesRoundKeys[i - 1]];
+      IEEE802154_aesRoundKeys[i + 3] = IEEE802154_aesRoundKeys[i - 13] ^ IEEE802154_aesSbox[IEEE802154_aesRoundKeys[i - 4]];
+      rcon = IEEE802154_aesXtime(rcon);
+    }
+    else
+    {
+      IEEE802154_aesRoundKeys[i]     = IEEE802154_aesRoundKeys[i - 16] ^ IEEE802154_aesRoundKeys[i - 4];
+      IEEE802154_aesRoundKeys[i + 1] = IEEE802154_aesRoundKeys[i - 15] ^ IEEE802154_aesRoundKeys[i - 3];
+      IEEE802154_aesRoundKeys[i + 2] = IEEE802154_aesRoundKeys[i - 14] ^ IEEE802154_aesRoundKeys[i - 2];
+      IEEE802154_aesRoundKeys[i + 3] = IEEE802154_aesRoundKeys[i - 13] ^ IEEE802154_aesRoundKeys[i - 1];
+    }
+  }
+}
+
+/**
+ * Encrypts one block in place with the loaded key (FIPS-197 Chapter 5.1). State is
+ * stored column by column as the block, byte i is row i % 4 of column i / 4.
+*/
+static void IEEE802154_aesEncrypt(uint8_t *block)
+{
+  uint8_t state[IEEE802154_AES_BLOCK_SIZE];
+  const uint8_t *roundKey = IEEE802154_aesRoundKeys;
+  uint8_t round;
+  uint8_t i;
+  uint8_t t;
+  uint8_t a0;
+
+  for (i=0; i<IEEE802154_AES_BLOCK_SIZE; i++)
+  {
+    block[i] ^= roundKey[i];
+  }
+  for (round=1; round<=10; round++)
+  {
+    roundKey += IEEE802154_AES_BLOCK_SIZE;
+    /* SubBytes and ShiftRows: row r is rotated left by r columns */
+    for (i=0; i<IEEE802154_AES_BLOCK_SIZE; i++)
+    {
+      state[i] = IEEE802154_aesSbox[block[(i + ((i & 0x03) << 2)) & 0x0F]];
+    }
+    for (i=0; i<IEEE802154_AES_BLOCK_SIZE; i+=4)
+    {
+      if (round != 10)
+      {
+        /* MixColumns, last round has none */
+        a0 = state[i];
+        t = state[i] ^ state[i + 1] ^ state[i + 2] ^ state[i + 3];
+        state[i]     ^= t ^ IEEE802154_aesXtime(state[i] ^ state[i + 1]);
+        state[i + 1] ^= t ^ IEEE802154_aesXtime(state[i + 1] ^ state[i + 2]);
+        state[i + 2] ^= t ^ IEEE802154_aesXtime(state[i + 2] ^ state[i + 3]);
+        state[i + 3] ^= t ^ IEEE802154_aesXtime(state[i + 3] ^ a0);
+      }
+      block[i]     = state[i] ^ roundKey[i];
+      block[i + 1] = state[i + 1] ^ roundKey[i + 1];
+      block[i + 2] = state[i + 2] ^ roundKey[i + 2];
+      block[i + 3] = state[i + 3] ^ roundKey[i + 3];
+    }
+  }
+}
+#else
+/**
+ * Loads the key into the AES coprocessor, see IEEE802154_aesEncrypt() for the critical
+ * section.
+*/
+static void IEEE802154_aesLoadKey(const uint8_t *key)
+{
+  uint8_t saved;
+  uint8_t i;
+  IEEE802154_CRITICAL_ENTER(saved);
+  ENCCS = ENCCS_MODE_ECB | ENCCS_CMD_LOAD_KEY | ENCCS_ST;
+  for (i=0; i<IEEE802154_AES_BLOCK_SIZE; i++)
+  {
+    ENCDI = key[i];
+  }
+  while ((ENCCS & ENCCS_RDY) == 0) ;
+  IEEE802154_CRITICAL_EXIT(saved);
+}
+
+/**
+ * Encrypts one block in place by the AES coprocessor in ECB mode. Frames are secured
+ * by the application and by the RF, MAC timer and DMA ISR, the coprocessor is only used
+ * inside the MAC critical section so a block is never interleaved with another one.
+*/
+static void IEEE802154_aesEncrypt(uint8_t *block)
+{
+  uint8_t saved;
+  uint8_t i;
+  IEEE802154_CRITICAL_ENTER(saved);
+  ENCCS = ENCCS_MODE_ECB | ENCCS_CMD_ENCRYPT | ENCCS_ST;
+  for (i=0; i<IEEE802154_AES_BLOCK_SIZE; i++)
+  {
+    ENCDI = block[i];
+  }
+  while ((ENCCS & ENCCS_RDY) == 0) ;
+  for (i=0; i<IEEE802154_AES_BLOCK_SIZE; i++)
+  {
+    block[i] = ENCDO;
+  }
+  IEEE802154_CRITICAL_EXIT(saved);
+}
+#endif
+
+/**
+ * Clears the device table and the outgoing frame counter, called by IEEE802154_radioInit().
+ * A frame counter kept in non-volatile memory must be restored afterwards.
+*/
+void IEEE802154_securityInit(void)
+{
+  uint8_t i;
+  IEEE802154_SecurityFrameCounter = 0;
+  for (i=0; i<IEEE802154_SECURITY_DEVICE_TABLE_SIZE; i++)
+  {
+    IEEE802154_securityDevices[i].used = 0;
+  }
+}
+
+/**
+ * Sets the key of all secured frames (AES-128). Must not be called while frames are
+ * sent or received.
+ * @param key 16 byte key
+*/
+void IEEE802154_securitySetKey(const uint8_t *key)
+{
+  IEEE802154_aesLoadKey(key);
+  IEEE802154_securityKeyLoaded = 1;
+}
+
+/**
+ * Adds a device secured frames are accepted from. Its frame counter starts at 0.
+ * @param extendedAddress extended address of device, transmitted order
+ * @param shortAddress short address of device, 0xFFFE if it only uses its extended address
+ * @return index of entry, IEEE802154_SECURITY_DEVICE_INVALID if table is full
+*/
+uint8_t IEEE802154_securityDeviceAdd(const IEEE802154_ExtendedAddress_t extendedAddress, IEEE802154_ShortAddress_t shortAddress)
+{
+  uint8_t i;
+  uint8_t j;
+  for (i=0; i<IEEE802154_SECURITY_DEVICE_TABLE_SIZE; i++)
+  {
+    if (!IEEE802154_securityDevices[i].used)
+    {
+      for (j=0; j<sizeof(IEEE802154_ExtendedAddress_t); j++)
+      {
+        IEEE802154_securityDevices[i].extendedAddress[j] = extendedAddress[j];
+      }
+      IEEE802154_securityDevices[i].shortAddress = shortAddress;
+      IEEE802154_securityDevices[i].frameCounter = 0;
+      IEEE802154_securityDevices[i].used = 1;
+      return i;
+    }
+  }
+  return IEEE802154_SECURITY_DEVICE_INVALID;
+}
+
+/**
+ * Removes a device added by IEEE802154_securityDeviceAdd().
+*/
+void IEEE802154_securityDeviceRemove(uint8_t index)
+{
+  if (index < IEEE802154_SECURITY_DEVICE_TABLE_SIZE)
+  {
+    IEEE802154_securityDevices[index].used = 0;
+  }
+}
+
+/**
+ * @return device entry of the source of a frame, NULL if source is unknown
+*/
+static IEEE802154_SecurityDevice_t* IEEE802154_securityDeviceFind(const IEEE802154_DataFrameHeader_t *frame)
+{
+  uint8_t i;
+  uint8_t j;
+  IEEE802154_SecurityDevice_t *device;
+  for (i=0; i<IEEE802154_SECURITY_DEVICE_TABLE_SIZE; i++)
+  {
+    device = &IEEE802154_securityDevices[i];
+    if (!device->used)
+    {
+      continue;
+    }
+    if (frame->fcf.sourceAddressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
+    {
+      if ((device->shortAddress == frame->sourceAddress.shortAddress) &&
+          (device->shortAddress != IEEE802154_SHORT_ADDRESS_NONE))
+      {
+        return device;
+      }
+    }
+    else if (frame->fcf.sourceAddressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT)
+    {
+      for (j=0; j<sizeof(IEEE802154_ExtendedAddress_t); j++)
+      {
+        if (device->extendedAddress[j] != frame->sourceAddress.extendedAdress[j])
+        {
+          break;
+        }
+      }
+      if (j == sizeof(IEEE802154_ExtendedAddress_t))
+      {
+        return device;
+      }
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Serializes an auxiliary security header (802.15.4-2006 Chapter "7.6.2 Auxiliary
+ * security header").
+ * @param header header to serialize
+ * @param buffer buffer of at least #IEEE802154_AUX_HEADER_MAX_SIZE bytes
+ * @return number of bytes written
+*/
+uint8_t IEEE802154_securityAuxHeaderSerialize(const IEEE802154_AuxSecurityHeader_t *header, uint8_t *buffer)
+{
+  uint8_t i;
+  uint8_t length = IEEE802154_AUX_HEADER_LENGTH(header->securityControl);
+  buffer[0] = header->securityControl;
+  buffer[1] = (uint8_t)header->frameCounter;
+  buffer[2] = (uint8_t)(header->frameCounter >> 8);
+  buffer[3] = (uint8_t)(header->frameCounter >> 16);
+  buffer[4] = (uint8_t)(header->frameCounter >> 24);
+  /* key source precedes key index */
+  for (i=5; i<length - 1; i++)
+  {
+    buffer[i] = header->keySource[i - 5];
+  }
+  if (length > IEEE802154_AUX_HEADER_MIN_SIZE)
+  {
+    buffer[length - 1] = header->keyIndex;
+  }
+  return length;
+}
+
+/**
+ * Parses an auxiliary security header.
+ * @param header parsed header
+ * @param buffer auxiliary security header as transmitted
+ * @param length bytes available in buffer
+ * @return length of auxiliary security header, 0 if buffer is too short
+*/
+uint8_t IEEE802154_securityAuxHeaderParse(IEEE802154_AuxSecurityHeader_t *header, const uint8_t *buffer, uint8_t length)
+{
+  uint8_t i;
+  uint8_t auxLength;
+  if (length == 0)
+  {
+    return 0;
+  }
+  auxLength = IEEE802154_AUX_HEADER_LENGTH(buffer[0]);
+  if (auxLength > length)
+  {
+    return 0;
+  }
+  header->securityControl = buffer[0];
+  header->frameCounter = (uint32_t)buffer[1] | ((uint32_t)buffer[2] << 8) |
+                         ((uint32_t)buffer[3] << 16) | ((uint32_t)buffer[4] << 24);
+  for (i=5; i<auxLength - 1; i++)
+  {
+    header->keySource[i - 5] = buffer[i];
+  }
+  if (auxLength > IEEE802154_AUX_HEADER_MIN_SIZE)
+  {
+    header->keyIndex = buffer[auxLength - 1];
+  }
+  return auxLength;
+}
+
+/**
+ * Builds the CCM* nonce: extended address of the originator and frame counter, both
+ * most significant byte first, and security level (802.15.4-2006 Chapter "7.6.3.2 CCM*
+ * Nonce").
+ * @param nonce buffer of #IEEE802154_CCM_NONCE_SIZE bytes
+ * @param extendedAddress extended address of originator, transmitted order
+*/
+static void IEEE802154_securityNonce(uint8_t *nonce, const uint8_t *extendedAddress, uint32_t frameCounter, uint8_t securityLevel)
+{
+  uint8_t i;
+  for (i=0; i<sizeof(IEEE802154_ExtendedAddress_t); i++)
+  {
+    nonce[i] = extendedAddress[sizeof(IEEE802154_ExtendedAddress_t) - 1 - i];
+  }
+  nonce[8] = (uint8_t)(frameCounter >> 24);
+  nonce[9] = (uint8_t)(frameCounter >> 16);
+  nonce[10] = (uint8_t)(frameCounter >> 8);
+  nonce[11] = (uint8_t)frameCounter;
+  nonce[12] = securityLevel;
+}
+
+/**
+ * Sets up counter block A_i of CCM*.
+*/
+static void IEEE802154_ccmCounterBlock(uint8_t *block, const uint8_t *nonce, uint8_t counter)
+{
+  uint8_t i;
+  block[0] = IEEE802154_CCM_FLAGS_L;
+  for (i=0; i<IEEE802154_CCM_NONCE_SIZE; i++)
+  {
+    block[i + 1] = nonce[i];
+  }
+  block[14] = 0;
+  block[15] = counter;
+}
+
+/**
+ * Encrypts or decrypts data in place with the CCM* key stream starting at A_1.
+*/
+static void IEEE802154_ccmCrypt(const uint8_t *nonce, uint8_t *data, uint8_t length)
+{
+  uint8_t block[IEEE802154_AES_BLOCK_SIZE];
+  uint8_t counter = 1;
+  uint8_t i = 0;
+  while (length--)
+  {
+    if (i == 0)
+    {
+      IEEE802154_ccmCounterBlock(block, nonce, counter++);
+      IEEE802154_aesEncrypt(block);
+    }
+    *data++ ^= block[i];
+    i = (i + 1) & (IEEE802154_AES_BLOCK_SIZE - 1);
+  }
+}
+
+/**
+ * Adds data to the CBC-MAC, the block is encrypted whenever it is full.
+ * @return position in block behind data
+*/
+static uint8_t IEEE802154_ccmAbsorb(uint8_t *block, uint8_t position, const uint8_t *data, uint8_t length)
+{
+  while (length--)
+  {
+    block[position++] ^= *data++;
+    if (position == IEEE802154_AES_BLOCK_SIZE)
+    {
+      IEEE802154_aesEncrypt(block);
+      position = 0;
+    }
+  }
+  return position;
+}
+
+/**
+ * CCM* transformation with the key set by IEEE802154_securitySetKey() (802.15.4-2006
+ * Annex B). With micLength 0 data is only encrypted, with mLength 0 it is only
+ * authenticated.
+ * @param nonce nonce of #IEEE802154_CCM_NONCE_SIZE bytes
+ * @param a additional data, authenticated only
+ * @param aLength length of a
+ * @param m data to encrypt or decrypt in place
+ * @param mLength length of m
+ * @param mic encrypted MIC, written on encryption and checked on decryption
+ * @param micLength 0, 4, 8 or 16
+ * @param decrypt 0 to encrypt, 1 to decrypt
+ * @return 1 on success, 0 if MIC does not match on decryption
+*/
+uint8_t IEEE802154_ccmStar(const uint8_t *nonce, const uint8_t *a, uint8_t aLength, uint8_t *m, uint8_t mLength,
+                           uint8_t *mic, uint8_t micLength, uint8_t decrypt)
+{
+  uint8_t block[IEEE802154_AES_BLOCK_SIZE];
+  uint8_t s0[IEEE802154_AES_BLOCK_SIZE];
+  uint8_t position;
+  uint8_t i;
+  uint8_t mismatch = 0;
+
+  /* MIC is computed over plaintext */
+  if (decrypt)
+  {
+    IEEE802154_ccmCrypt(nonce, m, mLength);
+  }
+  if (micLength != 0)
+  {
+    /* B_0: flags, nonce and length of m */
+    IEEE802154_ccmCounterBlock(block, nonce, mLength);
+    block[0] = (aLength ? IEEE802154_CCM_FLAGS_ADATA : 0) | IEEE802154_CCM_FLAGS_M(micLength) | IEEE802154_CCM_FLAGS_L;
+    IEEE802154_aesEncrypt(block);
+    if (aLength != 0)
+    {
+      /* 2 byte length of a, high byte is 0 */
+      block[1] ^= aLength;
+      position = IEEE802154_ccmAbsorb(block, 2, a, aLength);
+      if (position != 0)
+      {
+        IEEE802154_aesEncrypt(block);
+      }
+    }
+    if (IEEE802154_ccmAbsorb(block, 0, m, mLength) != 0)
+    {
+      IEEE802154_aesEncrypt(block);
+    }
+    /* MIC is encrypted with A_0 */
+    IEEE802154_ccmCounterBlock(s0, nonce, 0);
+    IEEE802154_aesEncrypt(s0);
+    for (i=0; i<micLength; i++)
+    {
+      if (decrypt)
+      {
+        mismatch |= mic[i] ^ block[i] ^ s0[i];
+      }
+      else
+      {
+        mic[i] = block[i] ^ s0[i];
+      }
+    }
+  }
+  if (!decrypt)
+  {
+    IEEE802154_ccmCrypt(nonce, m, mLength);
+  }
+  return mismatch == 0;
+}
+
+/**
+ * Secures a frame for transmission. Header, auxiliary security header with the next
+ * outgoing frame counter, payload and MIC are written to frame, payload is encrypted
+ * for security levels with encryption except the command frame identifier of MAC
+ * command frames. The frame counter used is stored in the
+ * auxiliary security header of header.
+ * @param header header with security enabled and security control of auxiliary
+ * security header set
+ * @param payloadLength length of payload excluding header, MIC and CRC
+ * @param frame buffer of IEEE802154_MAX_PHY_PACKET_SIZE bytes
+ * @param frameLength length of secured frame without FCS
+ * @return IEEE802154_TX_SUCCESS or reason why frame can not be secured
+*/
+uint8_t IEEE802154_securityOutgoingFrame(IEEE802154_DataFrameHeader_t *header, uint8_t payloadLength, uint8_t *frame, uint8_t *frameLength)
+{
+  uint8_t nonce[IEEE802154_CCM_NONCE_SIZE];
+  uint8_t extendedAddress[sizeof(IEEE802154_ExtendedAddress_t)];
+  uint8_t level = header->auxSecurityHeader.securityControl & IEEE802154_SECURITY_LEVEL_MASK;
+  uint8_t micLength = IEEE802154_MIC_LENGTH(level);
+  uint8_t headerLength;
+  uint8_t aLength;
+  uint8_t open;
+  uint8_t saved;
+  uint8_t i;
+  uint32_t frameCounter;
+
+  if (!IEEE802154_securityKeyLoaded)
+  {
+    return IEEE802154_TX_UNAVAILABLE_KEY;
+  }
+  headerLength = IEEE802154_serializeHeader(header, frame);
+  if (headerLength == 0)
+  {
+    return IEEE802154_TX_INVALID_PARAMETER;
+  }
+  aLength = headerLength + IEEE802154_AUX_HEADER_LENGTH(header->auxSecurityHeader.securityControl);
+  if ((uint16_t)aLength + payloadLength + micLength + IEEE802154_CRCLENGTH > IEEE802154_MAX_PHY_PACKET_SIZE)
+  {
+    return IEEE802154_TX_FRAME_TOO_LONG;
+  }
+  /* frames are secured by the application and the ISRs, each takes a counter of its own */
+  IEEE802154_CRITICAL_ENTER(saved);
+  frameCounter = IEEE802154_SecurityFrameCounter;
+  if (frameCounter != 0xFFFFFFFFUL)
+  {
+    IEEE802154_SecurityFrameCounter = frameCounter + 1;
+  }
+  IEEE802154_CRITICAL_EXIT(saved);
+  if (frameCounter == 0xFFFFFFFFUL)
+  {
+    return IEEE802154_TX_COUNTER_ERROR;
+  }
+  header->auxSecurityHeader.frameCounter = frameCounter;
+  (void)IEEE802154_securityAuxHeaderSerialize(&header->auxSecurityHeader, &frame[headerLength]);
+  for (i=0; i<payloadLength; i++)
+  {
+    frame[aLength + i] = header->payload[i];
+  }
+  /* own extended address, register holds it in transmitted order */
+  extendedAddress[0] = EXT_ADDR0;
+  extendedAddress[1] = EXT_ADDR1;
+  extendedAddress[2] = EXT_ADDR2;
+  extendedAddress[3] = EXT_ADDR3;
+  extendedAddress[4] = EXT_ADDR4;
+  extendedAddress[5] = EXT_ADDR5;
+  extendedAddress[6] = EXT_ADDR6;
+  extendedAddress[7] = EXT_ADDR7;
+  IEEE802154_securityNonce(nonce, extendedAddress, header->auxSecurityHeader.frameCounter, level);
+  *frameLength = aLength + payloadLength + micLength;
+  if (level & IEEE802154_SECURITY_LEVEL_ENC)
+  {
+    open = IEEE802154_OPEN_PAYLOAD_LENGTH(header, payloadLength);
+    (void)IEEE802154_ccmStar(nonce, frame, aLength + open, &frame[aLength + open], payloadLength - open,
+                             &frame[aLength + payloadLength], micLength, 0);
+  }
+  else
+  {
+    /* MIC only, payload is authenticated as part of a */
+    (void)IEEE802154_ccmStar(nonce, frame, aLength + payloadLength, NULL, 0, &frame[aLength + payloadLength], micLength, 0);
+  }
+  return IEEE802154_TX_SUCCESS;
+}
+
+/**
+ * Unsecures a received frame, called by the RF ISR for frames with valid CRC and
+ * security enabled. The auxiliary security header must already be parsed into frame,
+ * the payload is decrypted in place and the MIC is removed.
+ * @param frame received frame, payload starts behind auxiliary security header
+ * @param payloadLength length of payload including MIC, reduced by the MIC length
+ * @return 1 if frame is authentic, 0 if source is unknown, frame counter was already
+ * used or MIC does not match
+*/
+uint8_t IEEE802154_securityIncomingFrame(IEEE802154_DataFrameHeader_t *frame, uint8_t *payloadLength)
+{
+  uint8_t nonce[IEEE802154_CCM_NONCE_SIZE];
+  uint8_t level = frame->auxSecurityHeader.securityControl & IEEE802154_SECURITY_LEVEL_MASK;
+  uint8_t micLength = IEEE802154_MIC_LENGTH(level);
+  uint8_t mLength;
+  uint8_t aLength;
+  uint8_t open;
+  uint8_t i;
+  uint32_t frameCounter = frame->auxSecurityHeader.frameCounter;
+  IEEE802154_SecurityDevice_t *device;
+
+  if (!IEEE802154_securityKeyLoaded || (*payloadLength < micLength))
+  {
+    return 0;
+  }
+  device = IEEE802154_securityDeviceFind(frame);
+  if ((device == NULL) || (frameCounter < device->frameCounter) || (frameCounter == 0xFFFFFFFFUL))
+  {
+    return 0;
+  }
+  IEEE802154_securityNonce(nonce, device->extendedAddress, frameCounter, level);
+  /* additional data is rebuilt from the parsed header */
+  aLength = IEEE802154_serializeHeader(frame, IEEE802154_securityBuffer);
+  aLength += IEEE802154_securityAuxHeaderSerialize(&frame->auxSecurityHeader, &IEEE802154_securityBuffer[aLength]);
+  mLength = *payloadLength - micLength;
+  if (level & IEEE802154_SECURITY_LEVEL_ENC)
+  {
+    open = IEEE802154_OPEN_PAYLOAD_LENGTH(frame, mLength);
+    if (open)
+    {
+      IEEE802154_securityBuffer[aLength] = frame->payload[0];
+    }
+    if (!IEEE802154_ccmStar(nonce, IEEE802154_securityBuffer, aLength + open, &frame->payload[open], mLength - open,
+                            &frame->payload[mLength], micLength, 1))
+    {
+      return 0;
+    }
+  }
+  else
+  {
+    for (i=0; i<mLength; i++)
+    {
+      IEEE802154_securityBuffer[aLength + i] = frame->payload[i];
+    }
+    if (!IEEE802154_ccmStar(nonce, IEEE802154_securityBuffer, aLength + mLength, NULL, 0, &frame->payload[mLength], micLength, 1))
+    {
+      return 0;
+    }
+  }
+  device->frameCounter = frameCounter + 1;
+  *payloadLength = mLength;
+  return 1;
+}
+
+#endif
+
+/** @}*/
@@ -0,0 +1,448 @@
+/** @ingroup IEEE_802.15.4
+ * @{
+ */
+/*******************| Inclusions |*************************************/
+#include "IEEE_802.15.4.h"
+#include "IEEE_802.15.4_Radio.h"
+#include <string.h>
+#include <stdio.h>
+
+/**
+ * Host emulation of the CC2530 radio FIFOs and the registers used by the MAC.
+ * Only compiled in if IEEE802154_SIMULATION is defined.
+*/
+#ifdef IEEE802154_SIMULATION
+
+/*******************| Macros |*****************************************/
+
+/*******************| Type definitions |*******************************/
+
+/*******************| Global variables |*******************************/
+#define IEEE802154_Sim_rxFifo                   (IEEE802154_Instance->sim.rxFifo)
+#define IEEE802154_Sim_rxFifoHead               (IEEE802154_Instance->sim.rxFifoHead)
+#define IEEE802154_Sim_rxFifoCnt                (IEEE802154_Instance->sim.rxFifoCnt)
+#define IEEE802154_Sim_txFifo                   (IEEE802154_Instance->sim.txFifo)
+#define IEEE802154_Sim_txFifoCnt                (IEEE802154_Instance->sim.txFifoCnt)
+#define IEEE802154_Sim_txActive                 (IEEE802154_Instance->sim.txActive)
+#define IEEE802154_Sim_txEnd                    (IEEE802154_Instance->sim.txEnd)
+#ifdef IEEE802154_ENABLE_SNIFFER
+#define IEEE802154_Sim_snifferFile              (IEEE802154_Instance->sim.snifferFile)
+#endif
+
+/*******************| Function definition |****************************/
+
+/**
+ * Resets FIFOs, registers, counters, time and the hooks to power-on state.
+ */
+void IEEE802154_Sim_reset(void)
+{
+  RFIRQF0 = RFIRQF1 = RFIRQM0 = RFIRQM1 = 0;
+  IEN2 = S1CON = RFERRF = FRMCTRL0 = RSSI = RSSISTAT = 0;
+  FRMFILT0 = 0x0D;    /* reset value, frame filtering enabled */
+  AGCCTRL1 = TXFILTCFG = FSCAL1 = FREQCTRL = 0;
+  FSMSTAT1 = T2MSEL = T2M0 = T2M1 = T2CTRL = 0;
+  T2IRQF = T2IRQM = IEN1 = IRCON = DMAIRQ = 0;
+  SRCMATCH = SRCSHORTEN0 = SRCSHORTEN1 = SRCSHORTEN2 = SRCEXTEN0 = SRCEXTEN1 = SRCEXTEN2 = 0;
+  SRCSHORTPENDEN0 = SRCSHORTPENDEN1 = SRCSHORTPENDEN2 = 0;
+  SRCEXTPENDEN0 = SRCEXTPENDEN1 = SRCEXTPENDEN2 = 0;
+  SHORT_ADDR0 = SHORT_ADDR1 = PAN_ID0 = PAN_ID1 = 0;
+  EXT_ADDR0 = EXT_ADDR1 = EXT_ADDR2 = EXT_ADDR3 = 0;
+  EXT_ADDR4 = EXT_ADDR5 = EXT_ADDR6 = EXT_ADDR7 = 0;
+  IEEE802154_Sim_rxFifoHead = 0;
+  IEEE802154_Sim_rxFifoCnt = 0;
+  IEEE802154_Sim_txFifoCnt = 0;
+  IEEE802154_Sim_txActive = 0;
+  IEEE802154_Sim_BytesPerPeriod = 0;
+  IEEE802154_Sim_TxHook = NULL;
+  IEEE802154_Sim_CcaHook = NULL;
+  IEEE802154_Sim_Time = 0;
+  memset(&IEEE802154_Sim_Counters, 0, sizeof(IEEE802154_Sim_Counters));
+  memset(IEEE802154_Sim_ChannelEnergy, 0, sizeof(IEEE802154_Sim_ChannelEnergy));
+}
+
+/**
+ * Number of bytes in RXFIFO (register RXFIFOCNT)
+ */
+uint8_t IEEE802154_Sim_rxFifoCount(void)
+{
+  return IEEE802154_Sim_rxFifoCnt;
+}
+
+/**
+ * First byte in RXFIFO without removing it (register RXFIRST)
+ */
+uint8_t IEEE802154_Sim_peekRxFifo(void)
+{
+  return IEEE802154_Sim_rxFifo[IEEE802154_Sim_rxFifoHead];
+}
+
+/**
+ * Read of RFD. As the hardware an empty RXFIFO reads as 0.
+ */
+uint8_t IEEE802154_Sim_readRxFifo(void)
+{
+  uint8_t value = 0;
+  IEEE802154_Sim_Counters.rxFifoReads++;
+  if (IEEE802154_Sim_rxFifoCnt > 0)
+  {
+    value = IEEE802154_Sim_rxFifo[IEEE802154_Sim_rxFifoHead];
+    IEEE802154_Sim_rxFifoHead = (IEEE802154_Sim_rxFifoHead + 1) % IEEE802154_SIM_FIFO_SIZE;
+    IEEE802154_Sim_rxFifoCnt--;
+  }
+  return value;
+}
+
+/**
+ * Write to RFD. Bytes exceeding the TXFIFO size are discarded.
+ */
+void IEEE802154_Sim_writeTxFifo(uint8_t value)
+{
+  IEEE802154_Sim_Counters.txFifoWrites++;
+  if (IEEE802154_Sim_txFifoCnt < IEEE802154_SIM_FIFO_SIZE)
+  {
+    IEEE802154_Sim_txFifo[IEEE802154_Sim_txFifoCnt++] = value;
+  }
+}
+
+/**
+ * Write to RFST. Transmission is instantaneous and TXDONE is set before the strobe
+ * returns unless IEEE802154_Sim_BytesPerPeriod is set, see IEEE802154_Sim_airtime().
+ * As the hardware the TXFIFO content is kept after transmission to allow
+ * retransmission. ISTXONCCA updates FSMSTAT1.SAMPLED_CCA and only transmits if the
+ * channel is clear.
+ */
+void IEEE802154_Sim_strobe(uint8_t instruction)
+{
+  uint8_t length;
+  uint8_t channel;
+  uint8_t airtime;
+  IEEE802154_Sim_Counters.strobes++;
+  switch (instruction)
+  {
+    case IEEE802154_CSP_ISTXONCCA:
+      if ((IEEE802154_Sim_CcaHook != NULL) && !IEEE802154_Sim_CcaHook())
+      {
+        FSMSTAT1 &= (uint8_t)~FSMSTAT1_SAMPLED_CCA;
+        break;
+      }
+      FSMSTAT1 |= FSMSTAT1_SAMPLED_CCA;
+      /* fall through */
+    case IEEE802154_CSP_ISTXON:
+      airtime = 0;
+      if (IEEE802154_Sim_txFifoCnt > 0)
+      {
+        /* first byte is PHY length including FCS which is not written by MAC */
+        length = IEEE802154_Sim_txFifo[0] - IEEE802154_CRCLENGTH;
+        if (length > IEEE802154_Sim_txFifoCnt - 1)
+        {
+          length = IEEE802154_Sim_txFifoCnt - 1;
+        }
+        if (((FRMCTRL0 & FRMCTRL0_AUTOCRC_ENABLED) == 0) &&
+            (IEEE802154_crc16(IEEE802154_CRC16_INIT, &IEEE802154_Sim_txFifo[1], length + IEEE802154_CRCLENGTH) != IEEE802154_CRC16_INIT))
+        {
+          IEEE802154_Sim_Counters.txFcsErrors++;
+        }
+        if (IEEE802154_Sim_TxHook != NULL)
+        {
+          IEEE802154_Sim_TxHook(&IEEE802154_Sim_txFifo[1], length);
+        }
+        IEEE802154_Sim_Counters.framesSent++;
+        airtime = IEEE802154_Sim_airtime(length);
+      }
+      if (airtime == 0)
+      {
+        RFIRQF1 |= RFIRQF1_TXDONE;
+      }
+      else
+      {
+        IEEE802154_Sim_txEnd = IEEE802154_Sim_Time + airtime;
+        IEEE802154_Sim_txActive = 1;
+      }
+      break;
+    case IEEE802154_CSP_ISFLUSHRX:
+      IEEE802154_Sim_rxFifoHead = 0;
+      IEEE802154_Sim_rxFifoCnt = 0;
+      break;
+    case IEEE802154_CSP_ISFLUSHTX:
+      IEEE802154_Sim_txFifoCnt = 0;
+      break;
+    case IEEE802154_CSP_ISRXON:
+      channel = (uint8_t)((FREQCTRL - FREQCTRL_CHANNEL_OFFSET) / FREQCTRL_CHANNEL_FAKTOR);
+      if (channel < IEEE802154_CHANNEL_COUNT)
+      {
+        RSSI = (uint8_t)IEEE802154_Sim_ChannelEnergy[channel];
+      }
+      RSSISTAT |= RSSISTAT_RSSI_VALID;
+      break;
+    case IEEE802154_CSP_ISRFOFF:
+      RSSISTAT &= (uint8_t)~RSSISTAT_RSSI_VALID;
+      break;
+    default:
+      /* remaining radio state is not modelled */
+      break;
+  }
+}
+
+/**
+ * Places a received frame in RXFIFO the same way the radio does and sets RXPKTDONE. The
+ * interrupt is not triggered, see IEEE802154_Sim_fireRadioInterrupt().
+ * With AUTOCRC disabled the FCS of the frame is appended instead of RSSI and correlation
+ * value, it is corrupted if CRC OK is not set in crcOkCorrelation, RSSI is placed in
+ * register RSSI.
+ * @param frame MAC frame starting with frame control field, without FCS
+ * @param length length of frame without FCS
+ * @param rssi RSSI value appended instead of first FCS byte
+ * @param crcOkCorrelation value appended instead of second FCS byte, bit 7 is CRC OK
+ * (#IEEE802154_CRCOK_MASK), bit 6:0 correlation value
+ * @return 1 if frame was placed in RXFIFO, 0 if it did not fit (overflow)
+ */
+uint8_t IEEE802154_Sim_pushRxFrame(const uint8_t *frame, uint8_t length, sint8_t rssi, uint8_t crcOkCorrelation)
+{
+  uint8_t i;
+  uint8_t tail;
+  if ((uint16_t)IEEE802154_Sim_rxFifoCnt + length + 1 + IEEE802154_CRCLENGTH > IEEE802154_SIM_FIFO_SIZE)
+  {
+    IEEE802154_Sim_Counters.rxOverflows++;
+    RFERRF |= RFERRF_RXOVERF;
+    return 0;
+  }
+  tail = (IEEE802154_Sim_rxFifoHead + IEEE802154_Sim_rxFifoCnt) % IEEE802154_SIM_FIFO_SIZE;
+  IEEE802154_Sim_rxFifo[tail] = length + IEEE802154_CRCLENGTH;
+  tail = (tail + 1) % IEEE802154_SIM_FIFO_SIZE;
+  for (i=0; i<length; i++)
+  {
+    IEEE802154_Sim_rxFifo[tail] = frame[i];
+    tail = (tail + 1) % IEEE802154_SIM_FIFO_SIZE;
+  }
+  if ((FRMCTRL0 & FRMCTRL0_AUTOCRC_ENABLED) == 0)
+  {
+    uint16_t fcs = IEEE802154_crc16(IEEE802154_CRC16_INIT, frame, length);
+    if ((crcOkCorrelation & IEEE802154_CRCOK_MASK) == 0)
+    {
+      fcs ^= 0xFFFF;
+    }
+    RSSI = (uint8_t)rssi;
+    rssi = (sint8_t)LO_UINT16(fcs);
+    crcOkCorrelation = HI_UINT16(fcs);
+  }
+  IEEE802154_Sim_rxFifo[tail] = (uint8_t)rssi;
+  tail = (tail + 1) % IEEE802154_SIM_FIFO_SIZE;
+  IEEE802154_Sim_rxFifo[tail] = crcOkCorrelation;
+  IEEE802154_Sim_rxFifoCnt += length + 1 + IEEE802154_CRCLENGTH;
+  IEEE802154_Sim_Counters.framesReceived++;
+  RFIRQF0 |= RFIRQF0_RXPKTDONE;
+  return 1;
+}
+
+/**
+ * Calls IEEE802154_radioISR if the RF interrupt is enabled and an enabled RF interrupt
+ * flag is pending, the same condition under which the CPU would vector to RF_VECTOR.
+ */
+void IEEE802154_Sim_fireRadioInterrupt(void)
+{
+  if ((IEN2 & IEN2_RFIE) && ((RFIRQF0 & RFIRQM0) || (RFIRQF1 & RFIRQM1)))
+  {
+    IEEE802154_Sim_Counters.interrupts++;
+    IEEE802154_radioISR();
+  }
+}
+
+/**
+ * Backoff periods a frame occupies the channel with the airtime model of
+ * IEEE802154_Sim_BytesPerPeriod, PHY overhead and FCS included.
+ * @param length length of frame without FCS
+ * @return airtime in backoff periods, 0 if transmission is instantaneous
+ */
+uint8_t IEEE802154_Sim_airtime(uint8_t length)
+{
+  if (IEEE802154_Sim_BytesPerPeriod == 0)
+  {
+    return 0;
+  }
+  return (uint8_t)((IEEE802154_SIM_PHY_OVERHEAD + length + IEEE802154_CRCLENGTH + IEEE802154_Sim_BytesPerPeriod - 1) / IEEE802154_Sim_BytesPerPeriod);
+}
+
+/**
+ * Advances IEEE802154_Sim_Time by the given number of MAC timer overflows (backoff
+ * periods). TXDONE of a frame on air is set once its airtime has passed. Each overflow
+ * sets T2IRQF.TIMER2_PERF and calls IEEE802154_macTimerISR if the timer runs and its
+ * interrupt is enabled.
+ */
+void IEEE802154_Sim_advanceTime(uint32_t periods)
+{
+  while (periods-- > 0)
+  {
+    IEEE802154_Sim_Time++;
+    if (IEEE802154_Sim_txActive && (IEEE802154_Sim_Time == IEEE802154_Sim_txEnd))
+    {
+      IEEE802154_Sim_txActive = 0;
+      RFIRQF1 |= RFIRQF1_TXDONE;
+    }
+    if (T2CTRL & T2CTRL_RUN)
+    {
+      T2IRQF |= T2IRQF_TIMER2_PERF;
+#ifdef IEEE802154_ENABLE_CSMA
+      if ((IEN1 & IEN1_T2IE) && (T2IRQF & T2IRQM))
+      {
+        IEEE802154_Sim_Counters.interrupts++;
+        IEEE802154_macTimerISR();
+      }
+#endif
+    }
+  }
+}
+
+/**
+ * DMA block transfer of the MAC RX channel from RFD to memory. As RFD reads by the CPU an
+ * empty RXFIFO reads as 0.
+ */
+void IEEE802154_Sim_dmaFromRxFifo(uint8_t *destination, uint8_t length)
+{
+  IEEE802154_Sim_Counters.dmaTransfers++;
+  IEEE802154_Sim_Counters.dmaBytes += length;
+  while (length-- > 0)
+  {
+    *destination = 0;
+    if (IEEE802154_Sim_rxFifoCnt > 0)
+    {
+      *destination = IEEE802154_Sim_rxFifo[IEEE802154_Sim_rxFifoHead];
+      IEEE802154_Sim_rxFifoHead = (IEEE802154_Sim_rxFifoHead + 1) % IEEE802154_SIM_FIFO_SIZE;
+      IEEE802154_Sim_rxFifoCnt--;
+    }
+    destination++;
+  }
+  DMAIRQ |= IEEE802154_DMA_RX_MASK;
+  IRCON |= IRCON_DMAIF;
+}
+
+/**
+ * DMA block transfer of the MAC TX channel from memory to RFD.
+ */
+void IEEE802154_Sim_dmaToTxFifo(const uint8_t *source, uint8_t length)
+{
+  IEEE802154_Sim_Counters.dmaTransfers++;
+  IEEE802154_Sim_Counters.dmaBytes += length;
+  while (length-- > 0)
+  {
+    if (IEEE802154_Sim_txFifoCnt < IEEE802154_SIM_FIFO_SIZE)
+    {
+      IEEE802154_Sim_txFifo[IEEE802154_Sim_txFifoCnt++] = *source;
+    }
+    source++;
+  }
+  DMAIRQ |= IEEE802154_DMA_TX_MASK;
+  IRCON |= IRCON_DMAIF;
+}
+
+/**
+ * Calls IEEE802154_dmaISR if the DMA interrupt is enabled and the TX or RX channel of the
+ * MAC, the only ones with IRQMASK set, has completed.
+ */
+void IEEE802154_Sim_fireDmaInterrupt(void)
+{
+#ifdef IEEE802154_ENABLE_DMA
+  if ((IEN1 & IEN1_DMAIE) && (DMAIRQ & (IEEE802154_DMA_TX_MASK | IEEE802154_DMA_RX_MASK)))
+  {
+    IEEE802154_Sim_Counters.interrupts++;
+    IEEE802154_dmaISR();
+  }
+#endif
+}
+
+/**
+ * Used by the MAC while it busy waits for an interrupt: delivers pending DMA and RF
+ * interrupts and lets one backoff period pass.
+ */
+void IEEE802154_Sim_busyWait(void)
+{
+  IEEE802154_Sim_fireDmaInterrupt();
+  IEEE802154_Sim_fireRadioInterrupt();
+  IEEE802154_Sim_advanceTime(1);
+}
+
+/**
+ * Cycle counter used by IEEE802154_ENABLE_STATISTICS. Simulated time counts with the
+ * period of the MAC timer, each radio access done by the MAC costs one cycle.
+ */
+uint32_t IEEE802154_Sim_readCycles(void)
+{
+  return IEEE802154_Sim_Time * IEEE802154_MAC_TIMER_BACKOFF_PERIOD +
+         IEEE802154_Sim_Counters.rxFifoReads + IEEE802154_Sim_Counters.txFifoWrites +
+         IEEE802154_Sim_Counters.strobes + IEEE802154_Sim_Counters.dmaBytes;
+}
+
+#ifdef IEEE802154_ENABLE_SNIFFER
+/**
+ * Creates a pcap file for the frames captured by the sniffer and writes the global header.
+ * @return 1 on success, 0 if file could not be created
+ */
+uint8_t IEEE802154_Sim_snifferOpen(const char *path)
+{
+  uint8_t header[IEEE802154_PCAP_HEADER_SIZE];
+  IEEE802154_Sim_snifferFile = fopen(path, "wb");
+  if (IEEE802154_Sim_snifferFile == NULL)
+  {
+    return 0;
+  }
+  fwrite(header, 1, IEEE802154_snifferPcapHeader(header), IEEE802154_Sim_snifferFile);
+  return 1;
+}
+
+/**
+ * Moves all frames captured so far from the sniffer buffer to the pcap file. Called by
+ * the host as often as the application on the target would stream the buffer out.
+ * @return number of frames written
+ */
+uint16_t IEEE802154_Sim_snifferWrite(void)
+{
+  uint8_t record[IEEE802154_PCAP_RECORD_MAX];
+  uint8_t length;
+  uint16_t frames = 0;
+  while ((length = IEEE802154_snifferPcapRecord(record)) != 0)
+  {
+    if (IEEE802154_Sim_snifferFile != NULL)
+    {
+      fwrite(record, 1, length, IEEE802154_Sim_snifferFile);
+    }
+    frames++;
+  }
+  return frames;
+}
+
+/**
+ * Closes the pcap file.
+ */
+void IEEE802154_Sim_snifferClose(void)
+{
+  if (IEEE802154_Sim_snifferFile != NULL)
+  {
+    fclose(IEEE802154_Sim_snifferFile);
+    IEEE802154_Sim_snifferFile = NULL;
+  }
+}
+#endif
+
+/**
+ * Copies the frame currently in TXFIFO (i.e. the last one sent) without length byte.
+ * @param frame buffer of at least IEEE802154_SIM_FIFO_SIZE bytes
+ * @return length of frame without FCS, 0 if TXFIFO is empty
+ */
+uint8_t IEEE802154_Sim_getTxFrame(uint8_t *frame)
+{
+  uint8_t length;
+  if (IEEE802154_Sim_txFifoCnt == 0)
+  {
+    return 0;
+  }
+  length = IEEE802154_Sim_txFifo[0] - IEEE802154_CRCLENGTH;
+  if (length > IEEE802154_Sim_txFifoCnt - 1)
+  {
+    length = IEEE802154_Sim_txFifoCnt - 1;
+  }
+  memcpy(frame, &IEEE802154_Sim_txFifo[1], length);
+  return length;
+}
+
+#endif
+
+/** @}*/
@@ -0,0 +1,252 @@
+/** @ingroup IEEE_802.15.4
+ * @{
+ */
+#ifndef IEEE_802_15_4_SIM_H_
+#define IEEE_802_15_4_SIM_H_
+
+/**
+ * In-memory emulation of the CC2530 radio used as backend by IEEE_802.15.4_Radio.h
+ * when IEEE802154_SIMULATION is defined. RXFIFO and TXFIFO are modelled as 128 byte
+ * buffers with the same content layout as the hardware (length byte, frame, RSSI and
+ * CRC OK/correlation byte instead of FCS, see swru191c.pdf Chapter 23.9.7
+ * Frame-Check Sequence). If AUTOCRC is disabled in FRMCTRL0 received frames carry
+ * their FCS and the FCS of sent frames is checked. Radio registers and the state of the
+ * emulation are members of IEEE802154_Sim_t in the context of the MAC instance.
+ * Frames are injected with IEEE802154_Sim_pushRxFrame() and delivered by calling
+ * IEEE802154_Sim_fireRadioInterrupt(). Frames sent by the MAC are captured on the
+ * ISTXON strobe and can be read back with IEEE802154_Sim_getTxFrame() or by
+ * registering IEEE802154_Sim_TxHook.
+ * The MAC timer is advanced in backoff periods with IEEE802154_Sim_advanceTime(), the
+ * result of CCA done by ISTXONCCA is decided by IEEE802154_Sim_CcaHook.
+ * Transmission is instantaneous unless IEEE802154_Sim_BytesPerPeriod is set, TXDONE is
+ * then raised by IEEE802154_Sim_advanceTime() once the airtime of the frame has passed.
+ * ISRXON loads RSSI with the energy of the channel selected in FREQCTRL taken from
+ * IEEE802154_Sim_ChannelEnergy and sets RSSISTAT valid.
+ * DMA transfers between RFD and memory complete immediately and raise the DMAIRQ flag
+ * of the channel, the DMA interrupt is delivered by IEEE802154_Sim_fireDmaInterrupt().
+ * A received frame whose payload is copied by DMA is only delivered by this interrupt.
+ * Frames captured by the sniffer are written to a pcap file with
+ * IEEE802154_Sim_snifferWrite().
+*/
+
+/*******************| Inclusions |*************************************/
+#include <PlatformTypes.h>
+#include <stdio.h>
+
+/*******************| Macros |*****************************************/
+#define IEEE802154_SIM_FIFO_SIZE                (uint8_t)128    /**< size of CC2530 RXFIFO and TXFIFO in bytes */
+#define IEEE802154_SIM_PHY_OVERHEAD             (uint8_t)6      /**< preamble, SFD and length byte sent with every frame */
+#define IEEE802154_SIM_BYTES_PER_PERIOD         (uint8_t)10     /**< bytes sent per backoff period at 250 kbit/s */
+#define IEEE802154_SIM_XDATA_SIZE               0x10000UL       /**< XREG address space */
+
+/* register model */
+#define RXFIFOCNT                               IEEE802154_Sim_rxFifoCount()
+#define RXFIRST                                 IEEE802154_Sim_peekRxFifo()
+#define XREG(addr)                              IEEE802154_Sim_XData[(addr)]
+
+/* helpers normally provided by cc253x.h */
+#define enableInterrupt(reg, mask)              (reg) |= (mask)
+#define disableInterrupt(reg, mask)             (reg) &= (uint8_t)~(mask)
+#define clearInterruptFlag(reg, mask)           (reg) &= (uint8_t)~(mask)
+#ifndef HI_UINT16
+#define HI_UINT16(a)                            (uint8_t)(((a) >> 8) & 0xFF)
+#endif
+#ifndef LO_UINT16
+#define LO_UINT16(a)                            (uint8_t)((a) & 0xFF)
+#endif
+
+/*******************| Type definitions |*******************************/
+/**
+ * Counters of radio accesses done by the MAC. Each FIFO access corresponds to one
+ * MOVX on the target, thus they are a good measure for ISR and TX cost per frame.
+ */
+typedef struct {
+  uint32_t rxFifoReads;         /**< bytes read from RXFIFO via RFD */
+  uint32_t txFifoWrites;        /**< bytes written to TXFIFO via RFD */
+  uint32_t strobes;             /**< command strobes issued via RFST */
+  uint32_t interrupts;          /**< calls of IEEE802154_radioISR */
+  uint32_t framesReceived;      /**< frames pushed into RXFIFO */
+  uint32_t framesSent;          /**< frames sent by ISTXON */
+  uint32_t rxOverflows;         /**< frames dropped by IEEE802154_Sim_pushRxFrame because RXFIFO was full, sets RFERRF_RXOVERF */
+  uint32_t dmaBytes;            /**< bytes moved between RFD and memory by DMA, not included in rxFifoReads and txFifoWrites */
+  uint32_t dmaTransfers;        /**< DMA transfers started */
+  uint32_t txFcsErrors;         /**< frames sent with AUTOCRC disabled whose FCS written by the MAC is wrong */
+} IEEE802154_Sim_Counters_t;
+
+/**
+ * Called on every ISTXON strobe with the frame in TXFIFO (without length byte and FCS)
+ */
+typedef void (*IEEE802154_Sim_TxHook_t)(const uint8_t *frame, uint8_t length);
+
+/**
+ * Called on every ISTXONCCA strobe, returns 1 if the channel is clear
+ */
+typedef uint8_t (*IEEE802154_Sim_CcaHook_t)(void);
+
+/**
+ * State of the emulated radio, member sim of IEEE802154_Context_t. The register names
+ * and globals below are macros for the members of the current instance.
+ */
+typedef struct {
+  uint8_t RFIRQF0;
+  uint8_t RFIRQF1;
+  uint8_t RFIRQM0;
+  uint8_t RFIRQM1;
+  uint8_t IEN2;
+  uint8_t S1CON;
+  uint8_t RFERRF;
+  uint8_t FRMCTRL0;
+  uint8_t FRMFILT0;
+  uint8_t RSSI;
+  uint8_t RSSISTAT;
+  uint8_t SRCMATCH;
+  uint8_t SRCSHORTEN0;
+  uint8_t SRCSHORTEN1;
+  uint8_t SRCSHORTEN2;
+  uint8_t SRCEXTEN0;
+  uint8_t SRCEXTEN1;
+  uint8_t SRCEXTEN2;
+  uint8_t SRCSHORTPENDEN0;
+  uint8_t SRCSHORTPENDEN1;
+  uint8_t SRCSHORTPENDEN2;
+  uint8_t SRCEXTPENDEN0;
+  uint8_t SRCEXTPENDEN1;
+  uint8_t SRCEXTPENDEN2;
+  uint8_t FSMSTAT1;
+  uint8_t T2MSEL;
+  uint8_t T2M0;
+  uint8_t T2M1;
+  uint8_t T2CTRL;
+  uint8_t T2IRQF;
+  uint8_t T2IRQM;
+  uint8_t IEN1;
+  uint8_t IRCON;
+  uint8_t DMAIRQ;
+  uint8_t AGCCTRL1;
+  uint8_t TXFILTCFG;
+  uint8_t FSCAL1;
+  uint8_t FREQCTRL;
+  uint8_t SHORT_ADDR0;
+  uint8_t SHORT_ADDR1;
+  uint8_t PAN_ID0;
+  uint8_t PAN_ID1;
+  uint8_t EXT_ADDR0;
+  uint8_t EXT_ADDR1;
+  uint8_t EXT_ADDR2;
+  uint8_t EXT_ADDR3;
+  uint8_t EXT_ADDR4;
+  uint8_t EXT_ADDR5;
+  uint8_t EXT_ADDR6;
+  uint8_t EXT_ADDR7;
+  uint8_t xData[IEEE802154_SIM_XDATA_SIZE];
+  IEEE802154_Sim_Counters_t counters;
+  uint32_t time;
+  IEEE802154_Sim_TxHook_t txHook;
+  IEEE802154_Sim_CcaHook_t ccaHook;
+  sint8_t channelEnergy[IEEE802154_CHANNEL_COUNT];
+  uint8_t bytesPerPeriod;
+  uint8_t rxFifo[IEEE802154_SIM_FIFO_SIZE];
+  uint8_t rxFifoHead;                   /**< index of next byte read via RFD */
+  uint8_t rxFifoCnt;                    /**< number of bytes in RXFIFO */
+  uint8_t txFifo[IEEE802154_SIM_FIFO_SIZE];
+  uint8_t txFifoCnt;                    /**< number of bytes in TXFIFO */
+  uint8_t txActive;                     /**< frame is on air, TXDONE is pending */
+  uint32_t txEnd;                       /**< time TXDONE of the frame on air is raised */
+#ifdef IEEE802154_ENABLE_SNIFFER
+  FILE *snifferFile;                    /**< pcap file written by IEEE802154_Sim_snifferWrite */
+#endif
+} IEEE802154_Sim_t;
+
+/*******************| Global variables |*******************************/
+#define RFIRQF0                                 (IEEE802154_Instance->sim.RFIRQF0)
+#define RFIRQF1                                 (IEEE802154_Instance->sim.RFIRQF1)
+#define RFIRQM0                                 (IEEE802154_Instance->sim.RFIRQM0)
+#define RFIRQM1                                 (IEEE802154_Instance->sim.RFIRQM1)
+#define IEN2                                    (IEEE802154_Instance->sim.IEN2)
+#define S1CON                                   (IEEE802154_Instance->sim.S1CON)
+#define RFERRF                                  (IEEE802154_Instance->sim.RFERRF)
+#define FRMCTRL0                                (IEEE802154_Instance->sim.FRMCTRL0)
+#define FRMFILT0                                (IEEE802154_Instance->sim.FRMFILT0)
+#define RSSI                                    (IEEE802154_Instance->sim.RSSI)
+#define RSSISTAT                                (IEEE802154_Instance->sim.RSSISTAT)
+#define SRCMATCH                                (IEEE802154_Instance->sim.SRCMATCH)
+#define SRCSHORTEN0                             (IEEE802154_Instance->sim.SRCSHORTEN0)
+#define SRCSHORTEN1                             (IEEE802154_Instance->sim.SRCSHORTEN1)
+#define SRCSHORTEN2                             (IEEE802154_Instance->sim.SRCSHORTEN2)
+#define SRCEXTEN0                               (IEEE802154_Instance->sim.SRCEXTEN0)
+#define SRCEXTEN1                               (IEEE802154_Instance->sim.SRCEXTEN1)
+#define SRCEXTEN2                               (IEEE802154_Instance->sim.SRCEXTEN2)
+#define SRCSHORTPENDEN0                         (IEEE802154_Instance->sim.SRCSHORTPENDEN0)
+#define SRCSHORTPENDEN1                         (IEEE802154_Instance->sim.SRCSHORTPENDEN1)
+#define SRCSHORTPENDEN2                         (IEEE802154_Instance->sim.SRCSHORTPENDEN2)
+#define SRCEXTPENDEN0                           (IEEE802154_Instance->sim.SRCEXTPENDEN0)
+#define SRCEXTPENDEN1                           (IEEE802154_Instance->sim.SRCEXTPENDEN1)
+#define SRCEXTPENDEN2                           (IEEE802154_Instance->sim.SRCEXTPENDEN2)
+#define FSMSTAT1                                (IEEE802154_Instance->sim.FSMSTAT1)
+#define T2MSEL                                  (IEEE802154_Instance->sim.T2MSEL)
+#define T2M0                                    (IEEE802154_Instance->sim.T2M0)
+#define T2M1                                    (IEEE802154_Instance->sim.T2M1)
+#define T2CTRL                                  (IEEE802154_Instance->sim.T2CTRL)
+#define T2IRQF                                  (IEEE802154_Instance->sim.T2IRQF)
+#define T2IRQM                                  (IEEE802154_Instance->sim.T2IRQM)
+#define IEN1                                    (IEEE802154_Instance->sim.IEN1)
+#define IRCON                                   (IEEE802154_Instance->sim.IRCON)
+#define DMAIRQ                                  (IEEE802154_Instance->sim.DMAIRQ)
+#define AGCCTRL1                                (IEEE802154_Instance->sim.AGCCTRL1)
+#define TXFILTCFG                               (IEEE802154_Instance->sim.TXFILTCFG)
+#define FSCAL1                                  (IEEE802154_Instance->sim.FSCAL1)
+#define FREQCTRL                                (IEEE802154_Instance->sim.FREQCTRL)
+#define SHORT_ADDR0                             (IEEE802154_Instance->sim.SHORT_ADDR0)
+#define SHORT_ADDR1                             (IEEE802154_Instance->sim.SHORT_ADDR1)
+#define PAN_ID0                                 (IEEE802154_Instance->sim.PAN_ID0)
+#define PAN_ID1                                 (IEEE802154_Instance->sim.PAN_ID1)
+#define EXT_ADDR0                               (IEEE802154_Instance->sim.EXT_ADDR0)
+#define EXT_ADDR1                               (IEEE802154_Instance->sim.EXT_ADDR1)
+#define EXT_ADDR2                               (IEEE802154_Instance->sim.EXT_ADDR2)
+#define EXT_ADDR3                               (IEEE802154_Instance->sim.EXT_ADDR3)
+#define EXT_ADDR4                               (IEEE802154_Instance->sim.EXT_ADDR4)
+#define EXT_ADDR5                               (IEEE802154_Instance->sim.EXT_ADDR5)
+#define EXT_ADDR6                               (IEEE802154_Instance->sim.EXT_ADDR6)
+#define EXT_ADDR7                               (IEEE802154_Instance->sim.EXT_ADDR7)
+#define IEEE802154_Sim_XData                    (IEEE802154_Instance->sim.xData)
+
+#define IEEE802154_Sim_Counters                 (IEEE802154_Instance->sim.counters)
+#define IEEE802154_Sim_Time                     (IEEE802154_Instance->sim.time) /**< simulated MAC timer, advanced by the host, used as timestamp of received frames */
+#define IEEE802154_Sim_TxHook                   (IEEE802154_Instance->sim.txHook)
+#define IEEE802154_Sim_CcaHook                  (IEEE802154_Instance->sim.ccaHook) /**< NULL: channel is always clear */
+#define IEEE802154_Sim_ChannelEnergy            (IEEE802154_Instance->sim.channelEnergy) /**< RSSI register value per channel 11-26 */
+#define IEEE802154_Sim_BytesPerPeriod           (IEEE802154_Instance->sim.bytesPerPeriod) /**< airtime model, 0: transmission is instantaneous */
+
+/*******************| Function prototypes |****************************/
+void IEEE802154_Sim_reset(void);
+uint8_t IEEE802154_Sim_rxFifoCount(void);
+uint8_t IEEE802154_Sim_peekRxFifo(void);
+uint8_t IEEE802154_Sim_readRxFifo(void);
+void IEEE802154_Sim_writeTxFifo(uint8_t value);
+void IEEE802154_Sim_strobe(uint8_t instruction);
+uint8_t IEEE802154_Sim_pushRxFrame(const uint8_t *frame, uint8_t length, sint8_t rssi, uint8_t crcOk);
+void IEEE802154_Sim_fireRadioInterrupt(void);
+uint8_t IEEE802154_Sim_getTxFrame(uint8_t *frame);
+uint32_t IEEE802154_Sim_readCycles(void);
+#ifdef IEEE802154_ENABLE_SNIFFER
+uint8_t IEEE802154_Sim_snifferOpen(const char *path);
+uint16_t IEEE802154_Sim_snifferWrite(void);
+void IEEE802154_Sim_snifferClose(void);
+#endif
+void IEEE802154_Sim_advanceTime(uint32_t periods);
+uint8_t IEEE802154_Sim_airtime(uint8_t length);
+void IEEE802154_Sim_busyWait(void);
+void IEEE802154_Sim_dmaFromRxFifo(uint8_t *destination, uint8_t length);
+void IEEE802154_Sim_dmaToTxFifo(const uint8_t *source, uint8_t length);
+void IEEE802154_Sim_fireDmaInterrupt(void);
+
+/* RF ISR of the MAC, called by IEEE802154_Sim_fireRadioInterrupt */
+extern void IEEE802154_radioISR(void);
+/* MAC timer ISR of the MAC, called by IEEE802154_Sim_advanceTime */
+extern void IEEE802154_macTimerISR(void);
+/* DMA ISR of the MAC, called by IEEE802154_Sim_fireDmaInterrupt */
+extern void IEEE802154_dmaISR(void);
+
+#endif
+
+/** @}*/
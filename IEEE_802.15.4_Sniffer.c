@@ -0,0 +1,312 @@
+/** @ingroup IEEE_802.15.4
+ * @{
+ */
+/*******************| Inclusions |*************************************/
+#include "IEEE_802.15.4.h"
+#include "IEEE_802.15.4_Radio.h"
+
+/**
+ * Promiscuous capture of all frames on the channel. While the sniffer runs the RF ISR
+ * calls IEEE802154_snifferDrain() instead of the MAC receive path, it copies each
+ * complete frame from RXFIFO into a ring buffer without parsing it. The application
+ * streams the buffer out as pcap with IEEE802154_snifferPcapHeader() once and
+ * IEEE802154_snifferPcapRecord() per frame, e.g. to UART or, in simulation, to a file.
+ * A buffer record is: PHY length, timestamp (4 bytes, backoff periods), MAC timer count
+ * (2 bytes, cycles), channel, frame without FCS, RSSI, CRC OK and correlation value.
+ * Frames are timestamped when they are copied by the ISR, not at SFD.
+ * Only compiled in if IEEE802154_ENABLE_SNIFFER is defined.
+*/
+#ifdef IEEE802154_ENABLE_SNIFFER
+
+/*******************| Macros |*****************************************/
+#define IEEE802154_SNIFFER_INDEX(index)         ((index) & (IEEE802154_SNIFFER_BUFFER_SIZE - 1))
+#define IEEE802154_PCAP_MAGIC                   0xA1B2C3D4UL
+#define IEEE802154_PCAP_SNAPLEN                 (IEEE802154_PCAP_TAP_HEADER_SIZE + IEEE802154_MAX_PHY_PACKET_SIZE)
+#define IEEE802154_PCAP_PERIODS_PER_SECOND      3125UL  /**< backoff periods of 320us per second */
+#define IEEE802154_PCAP_CYCLES_PER_US           32      /**< MAC timer runs at 32MHz */
+
+/* TLVs of the IEEE 802.15.4 TAP header */
+#define IEEE802154_TAP_FCS_TYPE                 0
+#define IEEE802154_TAP_RSS                      1
+#define IEEE802154_TAP_CHANNEL                  3
+#define IEEE802154_TAP_LQI                      10
+#define IEEE802154_TAP_FCS_16BIT                1
+
+/*******************| Type definitions |*******************************/
+
+/*******************| Global variables |*******************************/
+#define IEEE802154_snifferBuffer                (IEEE802154_Instance->snifferBuffer)
+#define IEEE802154_snifferHead                  (IEEE802154_Instance->snifferHead)
+#define IEEE802154_snifferTail                  (IEEE802154_Instance->snifferTail)
+#define IEEE802154_snifferFrmfilt0              (IEEE802154_Instance->snifferFrmfilt0)
+#define IEEE802154_snifferFrmctrl0              (IEEE802154_Instance->snifferFrmctrl0)
+
+/*******************| Function definition |****************************/
+
+/**
+ * Disables frame filtering and AUTOACK and starts capturing into an empty buffer.
+*/
+void IEEE802154_snifferStart(void)
+{
+  disableInterrupt(IEN2, IEN2_RFIE);
+  IEEE802154_snifferHead = 0;
+  IEEE802154_snifferTail = 0;
+  IEEE802154_SnifferDropped = 0;
+  IEEE802154_snifferFrmfilt0 = FRMFILT0;
+  IEEE802154_snifferFrmctrl0 = FRMCTRL0;
+  FRMFILT0 &= (uint8_t)~FRMFILT0_FRAME_FILTER_EN;
+  FRMCTRL0 &= (uint8_t)~FRMCTRL0_AUTOACK_ENABLED;
+  IEEE802154_ISFLUSHRX();
+  IEEE802154_SnifferActive = 1;
+  enableInterrupt(IEN2, IEN2_RFIE);
+}
+
+/**
+ * Restores frame filtering and AUTOACK and returns to normal reception. Frames still in
+ * the buffer can be read afterwards.
+*/
+void IEEE802154_snifferStop(void)
+{
+  disableInterrupt(IEN2, IEN2_RFIE);
+  IEEE802154_SnifferActive = 0;
+  FRMFILT0 = IEEE802154_snifferFrmfilt0;
+  FRMCTRL0 = IEEE802154_snifferFrmctrl0;
+  IEEE802154_ISFLUSHRX();
+  enableInterrupt(IEN2, IEN2_RFIE);
+}
+
+/**
+ * Copies all complete frames from RXFIFO into the buffer, called by the RF ISR on
+ * RXPKTDONE. Frames not fitting into the buffer are skipped and counted.
+*/
+void IEEE802154_snifferDrain(void)
+{
+  uint8_t i;
+  uint8_t frameLength;
+  uint8_t value;
+  uint16_t count;
+  uint16_t head = IEEE802154_snifferHead;
+  IEEE802154_Timestamp_t timestamp;
+#ifdef IEEE802154_ENABLE_SOFTWARE_CRC
+  uint16_t fcs;
+#endif
+
+  while (RXFIFOCNT > 0)
+  {
+    frameLength = RXFIRST;
+    if ((frameLength < IEEE802154_ACK_PACKET_SIZE) || (frameLength > IEEE802154_MAX_PHY_PACKET_SIZE))
+    {
+      /* lost synchronisation with frame boundaries */
+      IEEE802154_SnifferDropped++;
+      IEEE802154_ISFLUSHRX();
+      break;
+    }
+    if (frameLength >= RXFIFOCNT)
+    {
+      /* incomplete, RXPKTDONE will be raised again once it is received */
+      break;
+    }
+    (void)IEEE802154_RADIO_READ_RFD();
+    if ((uint16_t)(head - IEEE802154_snifferTail) + IEEE802154_SNIFFER_RECORD_OVERHEAD + frameLength > IEEE802154_SNIFFER_BUFFER_SIZE)
+    {
+      IEEE802154_SnifferDropped++;
+      for (i=0; i<frameLength; i++)
+      {
+        (void)IEEE802154_RADIO_READ_RFD();
+      }
+      continue;
+    }
+    timestamp = IEEE802154_RADIO_TIMESTAMP_FINE(count);
+    IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(head++)] = frameLength;
+    IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(head++)] = (uint8_t)timestamp;
+    IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(head++)] = (uint8_t)(timestamp >> 8);
+    IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(head++)] = (uint8_t)(timestamp >> 16);
+    IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(head++)] = (uint8_t)(timestamp >> 24);
+    IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(head++)] = LO_UINT16(count);
+    IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(head++)] = HI_UINT16(count);
+    IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(head++)] = IEEE802154_radioGetChannel();
+#ifdef IEEE802154_ENABLE_SOFTWARE_CRC
+    /* RXFIFO holds the FCS, store RSSI and CRC OK as AUTOCRC would */
+    fcs = IEEE802154_CRC16_INIT;
+    for (i=0; i<frameLength; i++)
+    {
+      value = IEEE802154_RADIO_READ_RFD();
+      fcs = IEEE802154_CRC16_UPDATE(fcs, value);
+      if (i < frameLength - IEEE802154_CRCLENGTH)
+      {
+        IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(head++)] = value;
+      }
+    }
+    IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(head++)] = RSSI;
+    IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(head++)] = (fcs == IEEE802154_CRC16_INIT) ? IEEE802154_CRCOK_MASK : 0;
+#else
+    for (i=0; i<frameLength; i++)
+    {
+      value = IEEE802154_RADIO_READ_RFD();
+      IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(head++)] = value;
+    }
+#endif
+    /* publish frame to consumer */
+    IEEE802154_snifferHead = head;
+  }
+  if (RFERRF & RFERRF_RXOVERF)
+  {
+    /* remainder of RXFIFO is corrupt */
+    IEEE802154_SnifferDropped++;
+    IEEE802154_ISFLUSHRX();
+    clearInterruptFlag(RFERRF, RFERRF_RXOVERF);
+  }
+}
+
+/**
+ * Writes a 16 bit value little endian.
+ * @return position behind value
+*/
+static uint8_t* IEEE802154_pcapPut16(uint8_t *buffer, uint16_t value)
+{
+  *buffer++ = LO_UINT16(value);
+  *buffer++ = HI_UINT16(value);
+  return buffer;
+}
+
+/**
+ * Writes a 32 bit value little endian.
+ * @return position behind value
+*/
+static uint8_t* IEEE802154_pcapPut32(uint8_t *buffer, uint32_t value)
+{
+  buffer = IEEE802154_pcapPut16(buffer, (uint16_t)value);
+  return IEEE802154_pcapPut16(buffer, (uint16_t)(value >> 16));
+}
+
+/**
+ * Writes a TLV of the TAP header with a value of up to 4 bytes, padded to 4 bytes.
+ * @return position behind TLV
+*/
+static uint8_t* IEEE802154_pcapPutTlv(uint8_t *buffer, uint16_t type, uint16_t length, uint32_t value)
+{
+  buffer = IEEE802154_pcapPut16(buffer, type);
+  buffer = IEEE802154_pcapPut16(buffer, length);
+  return IEEE802154_pcapPut32(buffer, value);
+}
+
+/**
+ * Converts an integer to the bit pattern of an IEEE 754 single precision float, avoids
+ * the floating point library for the RSS TLV.
+*/
+static uint32_t IEEE802154_pcapFloat(sint16_t value)
+{
+  uint32_t sign = 0;
+  uint32_t mantissa;
+  uint8_t exponent = 127 + 23;
+  if (value == 0)
+  {
+    return 0;
+  }
+  if (value < 0)
+  {
+    sign = 0x80000000UL;
+    value = -value;
+  }
+  mantissa = (uint32_t)value;
+  while ((mantissa & 0x00800000UL) == 0)
+  {
+    mantissa <<= 1;
+    exponent--;
+  }
+  return sign | ((uint32_t)exponent << 23) | (mantissa & 0x007FFFFFUL);
+}
+
+/**
+ * Writes the pcap global header which must precede the records.
+ * @param buffer at least IEEE802154_PCAP_HEADER_SIZE bytes
+ * @return IEEE802154_PCAP_HEADER_SIZE
+*/
+uint8_t IEEE802154_snifferPcapHeader(uint8_t *buffer)
+{
+  buffer = IEEE802154_pcapPut32(buffer, IEEE802154_PCAP_MAGIC);
+  buffer = IEEE802154_pcapPut16(buffer, 2);       /* version 2.4 */
+  buffer = IEEE802154_pcapPut16(buffer, 4);
+  buffer = IEEE802154_pcapPut32(buffer, 0);       /* time zone */
+  buffer = IEEE802154_pcapPut32(buffer, 0);       /* accuracy of timestamps */
+  buffer = IEEE802154_pcapPut32(buffer, IEEE802154_PCAP_SNAPLEN);
+  (void)IEEE802154_pcapPut32(buffer, IEEE802154_PCAP_LINKTYPE_IEEE802_15_4_TAP);
+  return IEEE802154_PCAP_HEADER_SIZE;
+}
+
+/**
+ * Removes the oldest frame from the buffer and writes it as pcap record. The FCS
+ * replaced by RSSI and correlation value in RXFIFO is recomputed, for frames received
+ * with invalid CRC it is inverted so analyzers flag them.
+ * @param buffer at least IEEE802154_PCAP_RECORD_MAX bytes
+ * @return length of record, 0 if no frame is buffered
+*/
+uint8_t IEEE802154_snifferPcapRecord(uint8_t *buffer)
+{
+  uint8_t i;
+  uint8_t frameLength;
+  uint8_t channel;
+  sint8_t rssi;
+  uint8_t crcOkCorrelation;
+  uint16_t count;
+  uint16_t fcs = IEEE802154_CRC16_INIT;
+  uint16_t head;
+  uint16_t tail = IEEE802154_snifferTail;
+  IEEE802154_Timestamp_t timestamp;
+  uint8_t *record = buffer;
+
+  /* 16 bit index is not read atomically by the CPU */
+  disableInterrupt(IEN2, IEN2_RFIE);
+  head = IEEE802154_snifferHead;
+  enableInterrupt(IEN2, IEN2_RFIE);
+  if (head == tail)
+  {
+    return 0;
+  }
+  frameLength = IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(tail++)];
+  timestamp = IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(tail++)];
+  timestamp |= (IEEE802154_Timestamp_t)IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(tail++)] << 8;
+  timestamp |= (IEEE802154_Timestamp_t)IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(tail++)] << 16;
+  timestamp |= (IEEE802154_Timestamp_t)IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(tail++)] << 24;
+  count = IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(tail++)];
+  count |= (uint16_t)IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(tail++)] << 8;
+  channel = IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(tail++)];
+
+  /* record header: seconds, microseconds, captured and original length */
+  buffer = IEEE802154_pcapPut32(buffer, timestamp / IEEE802154_PCAP_PERIODS_PER_SECOND);
+  buffer = IEEE802154_pcapPut32(buffer, (timestamp % IEEE802154_PCAP_PERIODS_PER_SECOND) * 320UL + count / IEEE802154_PCAP_CYCLES_PER_US);
+  buffer = IEEE802154_pcapPut32(buffer, (uint32_t)IEEE802154_PCAP_TAP_HEADER_SIZE + frameLength);
+  buffer = IEEE802154_pcapPut32(buffer, (uint32_t)IEEE802154_PCAP_TAP_HEADER_SIZE + frameLength);
+  /* TAP header, TLVs are filled in once RSSI and correlation value are known */
+  buffer += IEEE802154_PCAP_TAP_HEADER_SIZE;
+  for (i=0; i<frameLength - IEEE802154_CRCLENGTH; i++)
+  {
+    *buffer = IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(tail++)];
+    fcs = IEEE802154_CRC16_UPDATE(fcs, *buffer);
+    buffer++;
+  }
+  rssi = (sint8_t)IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(tail++)];
+  crcOkCorrelation = IEEE802154_snifferBuffer[IEEE802154_SNIFFER_INDEX(tail++)];
+  disableInterrupt(IEN2, IEN2_RFIE);
+  IEEE802154_snifferTail = tail;
+  enableInterrupt(IEN2, IEN2_RFIE);
+  if ((crcOkCorrelation & IEEE802154_CRCOK_MASK) == 0)
+  {
+    fcs ^= 0xFFFF;
+  }
+  (void)IEEE802154_pcapPut16(buffer, fcs);
+
+  buffer = record + 16;
+  *buffer++ = 0;                                  /* TAP version */
+  *buffer++ = 0;
+  buffer = IEEE802154_pcapPut16(buffer, IEEE802154_PCAP_TAP_HEADER_SIZE);
+  buffer = IEEE802154_pcapPutTlv(buffer, IEEE802154_TAP_FCS_TYPE, 1, IEEE802154_TAP_FCS_16BIT);
+  buffer = IEEE802154_pcapPutTlv(buffer, IEEE802154_TAP_RSS, 4, IEEE802154_pcapFloat((sint16_t)rssi - IEEE802154_RSSI_OFFSET));
+  buffer = IEEE802154_pcapPutTlv(buffer, IEEE802154_TAP_CHANNEL, 3, channel);   /* channel, page 0 */
+  (void)IEEE802154_pcapPutTlv(buffer, IEEE802154_TAP_LQI, 1, crcOkCorrelation & (uint8_t)~IEEE802154_CRCOK_MASK);
+  return 16 + IEEE802154_PCAP_TAP_HEADER_SIZE + frameLength;
+}
+
+#endif
+
+/** @}*/
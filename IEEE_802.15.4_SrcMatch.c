@@ -0,0 +1,351 @@
+/** @ingroup IEEE_802.15.4
+ * @{
+ */
+/*******************| Inclusions |*************************************/
+#include "IEEE_802.15.4.h"
+#include "IEEE_802.15.4_Radio.h"
+
+/**
+ * Management of the source address matching table of the radio and indirect
+ * transmission to sleepy children. Entries are identified by a handle in the format of
+ * SRCRESINDEX: index of the entry, IEEE802154_SRCMATCH_EXTENDED set for extended
+ * entries. With AUTOPEND the radio sets frame pending in the ACK of a data request from
+ * a source whose entry has its pending bit set (swru191c.pdf Chapter 23.8.2).
+ * Only compiled in if IEEE802154_ENABLE_SOURCE_MATCH is defined.
+*/
+#ifdef IEEE802154_ENABLE_SOURCE_MATCH
+
+/*******************| Macros |*****************************************/
+#define IEEE802154_SRCMATCH_INDEX(entry)        ((entry) & 0x1F)
+/* index into IEEE802154_indirectHead: short entries first, extended entries behind */
+#define IEEE802154_INDIRECT_CHILD(entry)        (((entry) & IEEE802154_SRCMATCH_EXTENDED) ? \
+                                                 IEEE802154_SRCMATCH_SHORT_ENTRIES + IEEE802154_SRCMATCH_INDEX(entry) : (entry))
+
+/*******************| Type definitions |*******************************/
+
+/*******************| Global variables |*******************************/
+#define IEEE802154_srcMatchUsed                 (IEEE802154_Instance->srcMatchUsed)
+#define IEEE802154_srcMatchShortEnable          (IEEE802154_Instance->srcMatchShortEnable)
+#define IEEE802154_srcMatchExtendedEnable       (IEEE802154_Instance->srcMatchExtendedEnable)
+#define IEEE802154_srcMatchShortPending         (IEEE802154_Instance->srcMatchShortPending)
+#define IEEE802154_srcMatchExtendedPending      (IEEE802154_Instance->srcMatchExtendedPending)
+#ifdef IEEE802154_ENABLE_INDIRECT_QUEUE
+#define IEEE802154_indirectPool                 (IEEE802154_Instance->indirectPool)
+#define IEEE802154_indirectFree                 (IEEE802154_Instance->indirectFree)
+#define IEEE802154_indirectHead                 (IEEE802154_Instance->indirectHead)
+#endif
+
+/*******************| Function definition |****************************/
+
+/**
+ * Writes the shadow of the enable and pending registers to the radio.
+*/
+static void IEEE802154_srcMatchUpdate(void)
+{
+  SRCSHORTEN0 = (uint8_t)IEEE802154_srcMatchShortEnable;
+  SRCSHORTEN1 = (uint8_t)(IEEE802154_srcMatchShortEnable >> 8);
+  SRCSHORTEN2 = (uint8_t)(IEEE802154_srcMatchShortEnable >> 16);
+  SRCEXTEN0 = (uint8_t)IEEE802154_srcMatchExtendedEnable;
+  SRCEXTEN1 = (uint8_t)(IEEE802154_srcMatchExtendedEnable >> 8);
+  SRCEXTEN2 = (uint8_t)(IEEE802154_srcMatchExtendedEnable >> 16);
+  SRCSHORTPENDEN0 = (uint8_t)IEEE802154_srcMatchShortPending;
+  SRCSHORTPENDEN1 = (uint8_t)(IEEE802154_srcMatchShortPending >> 8);
+  SRCSHORTPENDEN2 = (uint8_t)(IEEE802154_srcMatchShortPending >> 16);
+  SRCEXTPENDEN0 = (uint8_t)IEEE802154_srcMatchExtendedPending;
+  SRCEXTPENDEN1 = (uint8_t)(IEEE802154_srcMatchExtendedPending >> 8);
+  SRCEXTPENDEN2 = (uint8_t)(IEEE802154_srcMatchExtendedPending >> 16);
+}
+
+/**
+ * Clears the table and enables source matching with automatic frame pending for data
+ * requests. Called by IEEE802154_radioInit().
+*/
+void IEEE802154_srcMatchInit(void)
+{
+  IEEE802154_srcMatchUsed = 0;
+  IEEE802154_srcMatchShortEnable = 0;
+  IEEE802154_srcMatchExtendedEnable = 0;
+  IEEE802154_srcMatchShortPending = 0;
+  IEEE802154_srcMatchExtendedPending = 0;
+  IEEE802154_srcMatchUpdate();
+  SRCMATCH = SRCMATCH_SRC_MATCH_EN | SRCMATCH_AUTOPEND | SRCMATCH_PEND_DATAREQ_ONLY;
+#ifdef IEEE802154_ENABLE_INDIRECT_QUEUE
+  {
+    uint8_t i;
+    for (i=0; i<IEEE802154_INDIRECT_POOL_SIZE; i++)
+    {
+      IEEE802154_indirectPool[i].next = i + 1;
+    }
+    IEEE802154_indirectPool[IEEE802154_INDIRECT_POOL_SIZE - 1].next = IEEE802154_SRCMATCH_INVALID;
+    IEEE802154_indirectFree = 0;
+    for (i=0; i<sizeof(IEEE802154_indirectHead); i++)
+    {
+      IEEE802154_indirectHead[i] = IEEE802154_SRCMATCH_INVALID;
+    }
+  }
+#endif
+}
+
+/**
+ * Adds a short address to the table.
+ * @param panId PAN ID of source
+ * @param address short address of source
+ * @return entry handle, IEEE802154_SRCMATCH_INVALID if table is full
+*/
+uint8_t IEEE802154_srcMatchAddShort(IEEE802154_PANIdentifier_t panId, IEEE802154_ShortAddress_t address)
+{
+  uint8_t i;
+  for (i=0; i<IEEE802154_SRCMATCH_SHORT_ENTRIES; i++)
+  {
+    if ((IEEE802154_srcMatchUsed & ((uint32_t)1 << i)) == 0)
+    {
+      /* entry is stored little endian: PAN ID followed by short address */
+      IEEE802154_SRC_ADDRESS_TABLE(4 * i) = LO_UINT16(panId);
+      IEEE802154_SRC_ADDRESS_TABLE(4 * i + 1) = HI_UINT16(panId);
+      IEEE802154_SRC_ADDRESS_TABLE(4 * i + 2) = LO_UINT16(address);
+      IEEE802154_SRC_ADDRESS_TABLE(4 * i + 3) = HI_UINT16(address);
+      IEEE802154_srcMatchUsed |= (uint32_t)1 << i;
+      IEEE802154_srcMatchShortEnable |= (uint32_t)1 << i;
+      IEEE802154_srcMatchUpdate();
+      return i;
+    }
+  }
+  return IEEE802154_SRCMATCH_INVALID;
+}
+
+/**
+ * Adds an extended address to the table.
+ * @param address extended address of source, least significant byte first
+ * @return entry handle, IEEE802154_SRCMATCH_INVALID if table is full
+*/
+uint8_t IEEE802154_srcMatchAddExtended(const IEEE802154_ExtendedAddress_t address)
+{
+  uint8_t i;
+  uint8_t j;
+  for (i=0; i<IEEE802154_SRCMATCH_EXTENDED_ENTRIES; i++)
+  {
+    if ((IEEE802154_srcMatchUsed & ((uint32_t)3 << (2 * i))) == 0)
+    {
+      for (j=0; j<sizeof(IEEE802154_ExtendedAddress_t); j++)
+      {
+        IEEE802154_SRC_ADDRESS_TABLE(8 * i + j) = address[j];
+      }
+      IEEE802154_srcMatchUsed |= (uint32_t)3 << (2 * i);
+      IEEE802154_srcMatchExtendedEnable |= (uint32_t)1 << (2 * i);
+      IEEE802154_srcMatchUpdate();
+      return IEEE802154_SRCMATCH_EXTENDED | i;
+    }
+  }
+  return IEEE802154_SRCMATCH_INVALID;
+}
+
+/**
+ * Looks up the source of a received frame in the table, the same match the radio does
+ * in hardware. Short entries match on destination PAN ID of the frame.
+ * @return entry handle, IEEE802154_SRCMATCH_INVALID if source is not in table
+*/
+uint8_t IEEE802154_srcMatchFind(const IEEE802154_DataFrameHeader_t *frame)
+{
+  uint8_t i;
+  uint8_t j;
+  if (frame->fcf.sourceAddressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
+  {
+    for (i=0; i<IEEE802154_SRCMATCH_SHORT_ENTRIES; i++)
+    {
+      if ((IEEE802154_srcMatchShortEnable & ((uint32_t)1 << i)) &&
+          (IEEE802154_SRC_ADDRESS_TABLE(4 * i) == LO_UINT16(frame->destinationPANID)) &&
+          (IEEE802154_SRC_ADDRESS_TABLE(4 * i + 1) == HI_UINT16(frame->destinationPANID)) &&
+          (IEEE802154_SRC_ADDRESS_TABLE(4 * i + 2) == LO_UINT16(frame->sourceAddress.shortAddress)) &&
+          (IEEE802154_SRC_ADDRESS_TABLE(4 * i + 3) == HI_UINT16(frame->sourceAddress.shortAddress)))
+      {
+        return i;
+      }
+    }
+  }
+  else if (frame->fcf.sourceAddressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT)
+  {
+    for (i=0; i<IEEE802154_SRCMATCH_EXTENDED_ENTRIES; i++)
+    {
+      if (IEEE802154_srcMatchExtendedEnable & ((uint32_t)1 << (2 * i)))
+      {
+        for (j=0; j<sizeof(IEEE802154_ExtendedAddress_t); j++)
+        {
+          if (IEEE802154_SRC_ADDRESS_TABLE(8 * i + j) != frame->sourceAddress.extendedAdress[j])
+          {
+            break;
+          }
+        }
+        if (j == sizeof(IEEE802154_ExtendedAddress_t))
+        {
+          return IEEE802154_SRCMATCH_EXTENDED | i;
+        }
+      }
+    }
+  }
+  return IEEE802154_SRCMATCH_INVALID;
+}
+
+/**
+ * Sets or clears the pending bit of an entry. AUTOACK sets frame pending in the ACK of a
+ * data request from a source whose pending bit is set. With IEEE802154_ENABLE_INDIRECT_QUEUE
+ * the pending bit is managed by the indirect queue.
+*/
+void IEEE802154_srcMatchSetPending(uint8_t entry, uint8_t pending)
+{
+  uint32_t *mask = &IEEE802154_srcMatchShortPending;
+  uint8_t bit = IEEE802154_SRCMATCH_INDEX(entry);
+  if (entry & IEEE802154_SRCMATCH_EXTENDED)
+  {
+    mask = &IEEE802154_srcMatchExtendedPending;
+    bit *= 2;
+  }
+  if (pending)
+  {
+    *mask |= (uint32_t)1 << bit;
+  }
+  else
+  {
+    *mask &= ~((uint32_t)1 << bit);
+  }
+  IEEE802154_srcMatchUpdate();
+}
+
+/**
+ * Removes an entry from the table. Frames queued for indirect transmission to the
+ * entry are dropped.
+*/
+void IEEE802154_srcMatchRemove(uint8_t entry)
+{
+  uint8_t index = IEEE802154_SRCMATCH_INDEX(entry);
+#ifdef IEEE802154_ENABLE_INDIRECT_QUEUE
+  IEEE802154_indirectFlush(entry);
+#endif
+  if (entry & IEEE802154_SRCMATCH_EXTENDED)
+  {
+    IEEE802154_srcMatchUsed &= ~((uint32_t)3 << (2 * index));
+    IEEE802154_srcMatchExtendedEnable &= ~((uint32_t)1 << (2 * index));
+    IEEE802154_srcMatchExtendedPending &= ~((uint32_t)1 << (2 * index));
+  }
+  else
+  {
+    IEEE802154_srcMatchUsed &= ~((uint32_t)1 << index);
+    IEEE802154_srcMatchShortEnable &= ~((uint32_t)1 << index);
+    IEEE802154_srcMatchShortPending &= ~((uint32_t)1 << index);
+  }
+  IEEE802154_srcMatchUpdate();
+}
+
+#ifdef IEEE802154_ENABLE_INDIRECT_QUEUE
+/**
+ * Queues a frame for indirect transmission to a child. It is sent when the child polls
+ * with a data request, completion is reported by IEEE802154_UserCbk_DataFrameSent().
+ * Header and payload must stay valid until then.
+ * @param entry handle of child in source match table
+ * @param header header of frame including pointer to payload
+ * @param payloadLength length of frame payload excluding header and CRC
+ * @return 1 if frame was queued, 0 if pool is full
+*/
+uint8_t IEEE802154_indirectQueue(uint8_t entry, IEEE802154_DataFrameHeader_t *header, uint8_t payloadLength)
+{
+  uint8_t frame;
+  uint8_t *link;
+  uint8_t saved;
+  /* RF or DMA ISR dequeues on data requests */
+  IEEE802154_CRITICAL_ENTER(saved);
+  frame = IEEE802154_indirectFree;
+  if (frame != IEEE802154_SRCMATCH_INVALID)
+  {
+    IEEE802154_indirectFree = IEEE802154_indirectPool[frame].next;
+    IEEE802154_indirectPool[frame].header = header;
+    IEEE802154_indirectPool[frame].payloadLength = payloadLength;
+    IEEE802154_indirectPool[frame].next = IEEE802154_SRCMATCH_INVALID;
+    /* append to end of child's list */
+    link = &IEEE802154_indirectHead[IEEE802154_INDIRECT_CHILD(entry)];
+    while (*link != IEEE802154_SRCMATCH_INVALID)
+    {
+      link = &IEEE802154_indirectPool[*link].next;
+    }
+    *link = frame;
+    IEEE802154_srcMatchSetPending(entry, 1);
+  }
+  IEEE802154_CRITICAL_EXIT(saved);
+  return frame != IEEE802154_SRCMATCH_INVALID;
+}
+
+/**
+ * @return number of frames queued for a child
+*/
+uint8_t IEEE802154_indirectPending(uint8_t entry)
+{
+  uint8_t count = 0;
+  uint8_t frame = IEEE802154_indirectHead[IEEE802154_INDIRECT_CHILD(entry)];
+  while (frame != IEEE802154_SRCMATCH_INVALID)
+  {
+    count++;
+    frame = IEEE802154_indirectPool[frame].next;
+  }
+  return count;
+}
+
+/**
+ * Drops all frames queued for a child, e.g. when its transaction persistence time
+ * has expired.
+*/
+void IEEE802154_indirectFlush(uint8_t entry)
+{
+  uint8_t frame;
+  uint8_t *head = &IEEE802154_indirectHead[IEEE802154_INDIRECT_CHILD(entry)];
+  uint8_t saved;
+  IEEE802154_CRITICAL_ENTER(saved);
+  while (*head != IEEE802154_SRCMATCH_INVALID)
+  {
+    frame = *head;
+    *head = IEEE802154_indirectPool[frame].next;
+    IEEE802154_indirectPool[frame].next = IEEE802154_indirectFree;
+    IEEE802154_indirectFree = frame;
+  }
+  IEEE802154_srcMatchSetPending(entry, 0);
+  IEEE802154_CRITICAL_EXIT(saved);
+}
+
+/**
+ * Called by the RF ISR for a data request command with valid CRC. Hands the first frame
+ * queued for the requesting child to the transmit queue, the frame is sent with frame
+ * pending set if more frames are queued. The header of the frame is not modified. If the transmit queue is full the frame stays queued and is
+ * sent on the next data request.
+*/
+void IEEE802154_indirectDataRequest(const IEEE802154_DataFrameHeader_t *frame)
+{
+  uint8_t entry = IEEE802154_srcMatchFind(frame);
+  uint8_t *head;
+  uint8_t first;
+  IEEE802154_IndirectFrame_t *indirect;
+  if (entry == IEEE802154_SRCMATCH_INVALID)
+  {
+    return;
+  }
+  head = &IEEE802154_indirectHead[IEEE802154_INDIRECT_CHILD(entry)];
+  first = *head;
+  if (first == IEEE802154_SRCMATCH_INVALID)
+  {
+    return;
+  }
+  indirect = &IEEE802154_indirectPool[first];
+  if (!IEEE802154_radioSentIndirectFrameAsync(indirect->header, indirect->payloadLength,
+                                              indirect->next != IEEE802154_SRCMATCH_INVALID))
+  {
+    return;
+  }
+  *head = indirect->next;
+  indirect->next = IEEE802154_indirectFree;
+  IEEE802154_indirectFree = first;
+  if (*head == IEEE802154_SRCMATCH_INVALID)
+  {
+    IEEE802154_srcMatchSetPending(entry, 0);
+  }
+}
+#endif
+
+#endif
+
+/** @}*/
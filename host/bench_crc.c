@@ -0,0 +1,174 @@
+/**
+ * Throughput of the table driven FCS of IEEE_802.15.4_Crc.c compared with a bitwise
+ * implementation doing 8 shift/XOR steps per byte. Both are first checked against the
+ * check values of "123456789", 0x2189 for the 16 bit and 0xCBF43926 for the 32 bit
+ * FCS, then run over maximum length frames.
+ * Built by host/Makefile with IEEE802154_ENABLE_SOFTWARE_CRC and IEEE802154_ENABLE_CRC32.
+*/
+
+/*******************| Inclusions |*************************************/
+#define _POSIX_C_SOURCE 199309L     /* clock_gettime */
+#include "IEEE_802.15.4.h"
+#include <stdio.h>
+#include <time.h>
+
+/*******************| Macros |*****************************************/
+#define BENCH_FRAMES                            1000000UL
+#define BENCH_FRAME_LENGTH                      (IEEE802154_MAX_PHY_PACKET_SIZE - IEEE802154_CRCLENGTH)
+#define BENCH_CRC16_POLYNOMIAL                  0x8408          /**< x^16 + x^12 + x^5 + 1, reflected */
+#define BENCH_CRC32_POLYNOMIAL                  0xEDB88320UL    /**< ANSI X3.66, reflected */
+
+/*******************| Global variables |*******************************/
+IEEE802154_DataFrameHeader_t IEEE802154_TxDataFrame;
+IEEE802154_DataFrameHeader_t IEEE802154_RxDataFrame;
+
+static const uint8_t checkInput[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+static volatile uint32_t sink;
+
+/*******************| Function definition |****************************/
+void IEEE802154_UserCbk_BeaconFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_DataFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_AckFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_MACCommandFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_CRCError(uint8_t payloadLength, sint8_t rssi) {}
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint16_t bitwiseCrc16(uint16_t crc, const uint8_t *data, uint8_t length)
+{
+  uint8_t bit;
+
+  while (length-- > 0)
+  {
+    crc ^= *data++;
+    for (bit = 0; bit < 8; bit++)
+    {
+      crc = (crc & 1) ? (uint16_t)((crc >> 1) ^ BENCH_CRC16_POLYNOMIAL) : (uint16_t)(crc >> 1);
+    }
+  }
+  return crc;
+}
+
+static uint32_t bitwiseCrc32(uint32_t crc, const uint8_t *data, uint8_t length)
+{
+  uint8_t bit;
+
+  while (length-- > 0)
+  {
+    crc ^= *data++;
+    for (bit = 0; bit < 8; bit++)
+    {
+      crc = (crc & 1) ? (crc >> 1) ^ BENCH_CRC32_POLYNOMIAL : crc >> 1;
+    }
+  }
+  return crc;
+}
+
+/**
+ * Per byte update as done while bytes are streamed through RFD.
+*/
+static uint16_t streamCrc16(uint16_t crc, const uint8_t *data, uint8_t length)
+{
+  while (length-- > 0)
+  {
+    crc = IEEE802154_CRC16_UPDATE(crc, *data++);
+  }
+  return crc;
+}
+
+static int check(const char *name, uint32_t got, uint32_t expected)
+{
+  if (got != expected)
+  {
+    printf("%s: check value 0x%08lX, expected 0x%08lX\n", name, (unsigned long)got, (unsigned long)expected);
+    return 1;
+  }
+  return 0;
+}
+
+static void report(const char *name, double seconds, double reference)
+{
+  printf("%-18s %10.1f %10.1f %8.1fx\n", name, seconds * 1e9 / BENCH_FRAMES,
+         (double)BENCH_FRAMES * BENCH_FRAME_LENGTH / seconds / 1e6, reference / seconds);
+}
+
+int main(void)
+{
+  uint8_t frame[BENCH_FRAME_LENGTH];
+  unsigned long i;
+  uint32_t sum;
+  double bitwise;
+  double start;
+  int failed = 0;
+
+  failed += check("crc16 table", IEEE802154_crc16(IEEE802154_CRC16_INIT, checkInput, sizeof(checkInput)), 0x2189);
+  failed += check("crc16 stream", streamCrc16(IEEE802154_CRC16_INIT, checkInput, sizeof(checkInput)), 0x2189);
+  failed += check("crc16 bitwise", bitwiseCrc16(IEEE802154_CRC16_INIT, checkInput, sizeof(checkInput)), 0x2189);
+  failed += check("crc32 table", IEEE802154_CRC32_FINAL(IEEE802154_crc32(IEEE802154_CRC32_INIT, checkInput, sizeof(checkInput))), 0xCBF43926UL);
+  failed += check("crc32 bitwise", IEEE802154_CRC32_FINAL(bitwiseCrc32(IEEE802154_CRC32_INIT, checkInput, sizeof(checkInput))), 0xCBF43926UL);
+  if (failed)
+  {
+    return 1;
+  }
+
+  for (i = 0; i < sizeof(frame); i++)
+  {
+    frame[i] = (uint8_t)(i * 7 + 3);
+  }
+  printf("bench_crc: %lu frames of %u bytes per row\n", BENCH_FRAMES, BENCH_FRAME_LENGTH);
+  printf("%-18s %10s %10s %9s\n", "", "ns/frame", "MB/s", "speedup");
+
+  start = now();
+  for (i = 0, sum = 0; i < BENCH_FRAMES; i++)
+  {
+    frame[0] = (uint8_t)i;
+    sum += bitwiseCrc16(IEEE802154_CRC16_INIT, frame, sizeof(frame));
+  }
+  sink = sum;
+  bitwise = now() - start;
+  report("crc16 bitwise", bitwise, bitwise);
+
+  start = now();
+  for (i = 0, sum = 0; i < BENCH_FRAMES; i++)
+  {
+    frame[0] = (uint8_t)i;
+    sum += IEEE802154_crc16(IEEE802154_CRC16_INIT, frame, sizeof(frame));
+  }
+  sink = sum;
+  report("crc16 table", now() - start, bitwise);
+
+  start = now();
+  for (i = 0, sum = 0; i < BENCH_FRAMES; i++)
+  {
+    frame[0] = (uint8_t)i;
+    sum += streamCrc16(IEEE802154_CRC16_INIT, frame, sizeof(frame));
+  }
+  sink = sum;
+  report("crc16 per byte", now() - start, bitwise);
+
+  start = now();
+  for (i = 0, sum = 0; i < BENCH_FRAMES; i++)
+  {
+    frame[0] = (uint8_t)i;
+    sum += bitwiseCrc32(IEEE802154_CRC32_INIT, frame, sizeof(frame));
+  }
+  sink = sum;
+  bitwise = now() - start;
+  report("crc32 bitwise", bitwise, bitwise);
+
+  start = now();
+  for (i = 0, sum = 0; i < BENCH_FRAMES; i++)
+  {
+    frame[0] = (uint8_t)i;
+    sum += IEEE802154_crc32(IEEE802154_CRC32_INIT, frame, sizeof(frame));
+  }
+  sink = sum;
+  report("crc32 table", now() - start, bitwise);
+  return 0;
+}
@@ -0,0 +1,231 @@
+/**
+ * Header parsing with IEEE802154_FrameView_t compared with the parser of the original
+ * RF ISR. The original parser copies the header byte by byte into the packed header
+ * structure, skipping unused address fields by pointer arithmetic, and copies the
+ * payload out of the frame. The frame view finds all field offsets with one lookup in
+ * IEEE802154_frameLayout and reads them in place. Both read PAN IDs, addresses,
+ * sequence number and payload of the same frames of four header shapes.
+ * Built by host/Makefile.
+*/
+
+/*******************| Inclusions |*************************************/
+#define _POSIX_C_SOURCE 199309L     /* clock_gettime */
+#include "IEEE_802.15.4.h"
+#include <stdio.h>
+#include <time.h>
+
+/*******************| Macros |*****************************************/
+#define BENCH_ROUNDS                            5000000UL
+#define BENCH_PAYLOAD_LENGTH                    32
+
+/*******************| Type definitions |*******************************/
+/* header layout of the original driver, packed like on the 8051 */
+typedef struct __attribute__((packed)) {
+  IEEE802154_ShortAddress_t shortAddress;
+  IEEE802154_ExtendedAddress_t extendedAdress;
+} LegacyAdress_t;
+
+typedef struct __attribute__((packed)) {
+  IEEE802154_FCF_t fcf;
+  uint8_t sequenceNumber;
+  IEEE802154_PANIdentifier_t destinationPANID;
+  LegacyAdress_t destinationAddress;
+  IEEE802154_PANIdentifier_t sourcePANID;
+  LegacyAdress_t sourceAddress;
+  IEEE802154_PayloadPointer payload;
+} LegacyHeader_t;
+
+typedef struct {
+  const char *name;
+  uint8_t fcf0;
+  uint8_t fcf1;
+} Shape_t;
+
+/*******************| Global variables |*******************************/
+IEEE802154_DataFrameHeader_t IEEE802154_TxDataFrame;
+IEEE802154_DataFrameHeader_t IEEE802154_RxDataFrame;
+
+static const Shape_t shapes[] = {
+  { "short/short, PAN ID compression", 0x41, 0x88 },
+  { "short/short",                     0x01, 0x88 },
+  { "extended/short, PAN ID compr.",   0x41, 0x8C },
+  { "extended/extended",               0x01, 0xCC },
+};
+
+static uint8_t legacyPayload[IEEE802154_MAX_PHY_PACKET_SIZE];
+static volatile uint32_t sink;
+
+/*******************| Function definition |****************************/
+void IEEE802154_UserCbk_BeaconFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_DataFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_AckFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_MACCommandFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_CRCError(uint8_t payloadLength, sint8_t rssi) {}
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Builds a frame of the given shape, returns its length without FCS.
+*/
+static uint8_t buildFrame(uint8_t *frame, const Shape_t *shape)
+{
+  uint8_t length = 0;
+  uint8_t i;
+
+  frame[length++] = shape->fcf0;
+  frame[length++] = shape->fcf1;
+  frame[length++] = 0x5A;
+  /* PAN IDs and addresses */
+  for (i = IEEE802154_FRAME_HEADER_MIN; i < IEEE802154_frameLayout[IEEE802154_FRAME_LAYOUT_INDEX(shape->fcf0, shape->fcf1)].headerLength; i++)
+  {
+    frame[length++] = (uint8_t)(0x10 + i);
+  }
+  for (i = 0; i < BENCH_PAYLOAD_LENGTH; i++)
+  {
+    frame[length++] = i;
+  }
+  return length;
+}
+
+/**
+ * Parser of the original RF ISR with RFD replaced by the frame buffer. The length
+ * byte is the frame length including FCS.
+*/
+static void legacyParse(LegacyHeader_t *header, const uint8_t *frame, uint8_t frameLength)
+{
+  uint8_t *rxFramePtr = (uint8_t*)header;
+  uint8_t payloadLength = frameLength + IEEE802154_CRCLENGTH;
+  uint8_t i;
+
+  for (i = 0; i < IEEE802154_HEADERSIZE_STATIC; i++)
+  {
+    *rxFramePtr++ = *frame++;
+  }
+  payloadLength -= IEEE802154_HEADERSIZE_STATIC;
+  if (header->fcf.destinationAddressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
+  {
+    *rxFramePtr++ = *frame++;
+    *rxFramePtr++ = *frame++;
+    payloadLength -= sizeof(IEEE802154_ShortAddress_t);
+    rxFramePtr += sizeof(IEEE802154_ExtendedAddress_t);
+  }
+  if (header->fcf.destinationAddressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT)
+  {
+    for (i = 0; i < sizeof(IEEE802154_ExtendedAddress_t); i++)
+    {
+      *rxFramePtr++ = *frame++;
+    }
+    payloadLength -= sizeof(IEEE802154_ExtendedAddress_t);
+    rxFramePtr += sizeof(IEEE802154_ShortAddress_t);
+  }
+  /* the original parser always read a source PAN ID, honour the FCF bit here to stay in sync */
+  if (!header->fcf.panIdCompression)
+  {
+    *rxFramePtr++ = *frame++;
+    *rxFramePtr++ = *frame++;
+    payloadLength -= sizeof(IEEE802154_PANIdentifier_t);
+  }
+  else
+  {
+    rxFramePtr += sizeof(IEEE802154_PANIdentifier_t);
+  }
+  if (header->fcf.sourceAddressMode == IEEE802154_FCF_ADDRESS_MODE_16BIT)
+  {
+    *rxFramePtr++ = *frame++;
+    *rxFramePtr++ = *frame++;
+    payloadLength -= sizeof(IEEE802154_ShortAddress_t);
+    rxFramePtr += sizeof(IEEE802154_ExtendedAddress_t);
+  }
+  if (header->fcf.sourceAddressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT)
+  {
+    for (i = 0; i < sizeof(IEEE802154_ExtendedAddress_t); i++)
+    {
+      *rxFramePtr++ = *frame++;
+    }
+    payloadLength -= sizeof(IEEE802154_ExtendedAddress_t);
+    rxFramePtr += sizeof(IEEE802154_ShortAddress_t);
+  }
+  payloadLength -= IEEE802154_CRCLENGTH;
+  rxFramePtr = (uint8_t*)header->payload;
+  for (i = 0; i < payloadLength; i++)
+  {
+    *rxFramePtr++ = *frame++;
+  }
+}
+
+static uint32_t benchLegacy(const uint8_t *frame, uint8_t length)
+{
+  LegacyHeader_t header;
+  uint32_t sum = 0;
+  unsigned long i;
+
+  header.payload = legacyPayload;
+  for (i = 0; i < BENCH_ROUNDS; i++)
+  {
+    legacyParse(&header, frame, length);
+    sum += header.sequenceNumber + header.destinationPANID + header.sourcePANID;
+    sum += (header.fcf.destinationAddressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT) ?
+           header.destinationAddress.extendedAdress[0] : header.destinationAddress.shortAddress;
+    sum += (header.fcf.sourceAddressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT) ?
+           header.sourceAddress.extendedAdress[0] : header.sourceAddress.shortAddress;
+    sum += header.payload[BENCH_PAYLOAD_LENGTH - 1];
+  }
+  return sum;
+}
+
+static uint32_t benchView(uint8_t *frame, uint8_t length)
+{
+  IEEE802154_FrameView_t view;
+  const uint8_t *address;
+  uint32_t sum = 0;
+  unsigned long i;
+
+  for (i = 0; i < BENCH_ROUNDS; i++)
+  {
+    if (!IEEE802154_frameViewInit(&view, frame, length))
+    {
+      return 0;
+    }
+    sum += IEEE802154_FRAMEVIEW_SEQUENCE_NUMBER(&view);
+    sum += IEEE802154_frameViewDestinationPANID(&view) + IEEE802154_frameViewSourcePANID(&view);
+    address = IEEE802154_frameViewDestinationAddress(&view);
+    sum += (IEEE802154_FRAMEVIEW_DESTINATION_ADDRESS_MODE(&view) == IEEE802154_FCF_ADDRESS_MODE_64BIT) ?
+           address[0] : IEEE802154_GET_UINT16(address);
+    address = IEEE802154_frameViewSourceAddress(&view);
+    sum += (IEEE802154_FRAMEVIEW_SOURCE_ADDRESS_MODE(&view) == IEEE802154_FCF_ADDRESS_MODE_64BIT) ?
+           address[0] : IEEE802154_GET_UINT16(address);
+    sum += IEEE802154_FRAMEVIEW_PAYLOAD(&view)[IEEE802154_FRAMEVIEW_PAYLOAD_LENGTH(&view) - 1];
+  }
+  return sum;
+}
+
+int main(void)
+{
+  uint8_t frame[IEEE802154_MAX_PHY_PACKET_SIZE];
+  uint8_t length;
+  uint8_t i;
+  double legacy;
+  double view;
+
+  printf("bench_frame: %lu parses per row, %u byte payload\n", BENCH_ROUNDS, BENCH_PAYLOAD_LENGTH);
+  printf("%-34s %6s %12s %12s %8s\n", "header", "length", "legacy ns", "view ns", "speedup");
+  for (i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++)
+  {
+    length = buildFrame(frame, &shapes[i]);
+    legacy = now();
+    sink = benchLegacy(frame, length);
+    legacy = now() - legacy;
+    view = now();
+    sink = benchView(frame, length);
+    view = now() - view;
+    printf("%-34s %6u %12.2f %12.2f %7.1fx\n", shapes[i].name, length,
+           legacy * 1e9 / BENCH_ROUNDS, view * 1e9 / BENCH_ROUNDS, legacy / view);
+  }
+  return 0;
+}
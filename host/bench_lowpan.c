@@ -0,0 +1,293 @@
+/**
+ * Header compression ratio and reassembly throughput of the 6LoWPAN layer.
+ * The compression table lists the IPv6 and UDP headers of typical packets against
+ * the IPHC and NHC headers IEEE802154_lowpanCompress() makes of them, once for frames
+ * with short and once with extended MAC addresses. For reassembly a packet of
+ * IEEE802154_LOWPAN_MTU bytes is fragmented by IEEE802154_lowpanSend(), the fragments
+ * are captured by IEEE802154_Sim_TxHook and fed to IEEE802154_lowpanInput() until it has
+ * delivered BENCH_PACKETS packets.
+ * Built by host/Makefile with IEEE802154_ENABLE_SCATTER_GATHER and IEEE802154_ENABLE_LOWPAN.
+*/
+
+/*******************| Inclusions |*************************************/
+#define _POSIX_C_SOURCE 199309L     /* clock_gettime */
+#include "IEEE_802.15.4.h"
+#include "IEEE_802.15.4_Radio.h"
+#include "IEEE_802.15.4_Lowpan.h"
+#include <stdio.h>
+#include <time.h>
+
+/*******************| Macros |*****************************************/
+#define BENCH_PACKETS                           200000UL
+#define BENCH_FRAGMENTS                         32
+#define BENCH_CHANNEL                           15
+#define BENCH_PANID                             0xABCD
+#define BENCH_OWN_ADDRESS                       0x1234
+#define BENCH_PEER_ADDRESS                      0x5678
+#define BENCH_UDP_PAYLOAD_LENGTH                32
+
+/*******************| Type definitions |*******************************/
+typedef enum {
+  ADDRESS_MAC,                          /**< link-local, IID derived from MAC address */
+  ADDRESS_GLOBAL,                       /**< global unicast, carried inline */
+  ADDRESS_MULTICAST                     /**< ff02::1 */
+} AddressKind_t;
+
+typedef struct {
+  const char *name;
+  AddressKind_t source;
+  AddressKind_t destination;
+  uint8_t nextHeader;
+  uint8_t hopLimit;
+  uint16_t sourcePort;
+  uint16_t destinationPort;
+  uint32_t flowLabel;
+} Shape_t;
+
+/*******************| Global variables |*******************************/
+IEEE802154_DataFrameHeader_t IEEE802154_TxDataFrame;
+IEEE802154_DataFrameHeader_t IEEE802154_RxDataFrame;
+
+static const Shape_t shapes[] = {
+  { "link-local UDP 0xF0Bx ports", ADDRESS_MAC,    ADDRESS_MAC,       17, 64,  0xF0B1, 0xF0B2, 0 },
+  { "link-local UDP CoAP",         ADDRESS_MAC,    ADDRESS_MAC,       17, 64,  5683,   5683,   0 },
+  { "link-local to ff02::1",       ADDRESS_MAC,    ADDRESS_MULTICAST, 17, 255, 0xF0B1, 0xF0B2, 0 },
+  { "global UDP CoAP",             ADDRESS_GLOBAL, ADDRESS_GLOBAL,    17, 64,  5683,   5683,   0 },
+  { "global TCP with flow label",  ADDRESS_GLOBAL, ADDRESS_GLOBAL,    6,  64,  0,      0,      0xABCDE },
+};
+
+static const uint8_t globalPrefix[8] = { 0x20, 0x01, 0x0D, 0xB8, 0x00, 0x00, 0x00, 0x01 };
+
+static uint8_t packet[IEEE802154_LOWPAN_MTU];
+static uint8_t fragments[BENCH_FRAGMENTS][IEEE802154_MAX_PHY_PACKET_SIZE];
+static uint8_t fragmentLengths[BENCH_FRAGMENTS];
+static uint8_t fragmentCount;
+static unsigned long delivered;
+
+/*******************| Function definition |****************************/
+void IEEE802154_UserCbk_BeaconFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_DataFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_AckFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_MACCommandFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_CRCError(uint8_t payloadLength, sint8_t rssi) {}
+
+void IEEE802154_UserCbk_LowpanPacketReceived(const IEEE802154_DataFrameHeader_t *frame, const uint8_t *packet, uint16_t packetLength)
+{
+  delivered++;
+}
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Keeps the LoWPAN payload of every sent frame, the MAC header is stripped.
+*/
+static void captureFragment(const uint8_t *frame, uint8_t length)
+{
+  uint8_t headerLength = IEEE802154_frameLayout[IEEE802154_FRAME_LAYOUT_INDEX(frame[0], frame[1])].headerLength;
+  uint8_t i;
+
+  if (fragmentCount < BENCH_FRAGMENTS)
+  {
+    for (i = 0; i < length - headerLength; i++)
+    {
+      fragments[fragmentCount][i] = frame[headerLength + i];
+    }
+    fragmentLengths[fragmentCount++] = length - headerLength;
+  }
+}
+
+static void macHeader(IEEE802154_DataFrameHeader_t *header, uint8_t addressMode)
+{
+  uint8_t i;
+
+  *header = (IEEE802154_DataFrameHeader_t){ 0 };
+  header->fcf.frameType = IEEE802154_FCF_FRAME_TYPE_DATA;
+  header->fcf.panIdCompression = IEEE802154_FCF_PANIDCOMPRESSION_ENABLED;
+  header->fcf.destinationAddressMode = addressMode;
+  header->fcf.sourceAddressMode = addressMode;
+  header->destinationPANID = BENCH_PANID;
+  header->destinationAddress.shortAddress = BENCH_PEER_ADDRESS;
+  header->sourceAddress.shortAddress = BENCH_OWN_ADDRESS;
+  if (addressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT)
+  {
+    for (i = 0; i < sizeof(IEEE802154_ExtendedAddress_t); i++)
+    {
+      header->destinationAddress.extendedAdress[i] = (uint8_t)(0x10 + i);
+      header->sourceAddress.extendedAdress[i] = (uint8_t)(0x20 + i);
+    }
+  }
+}
+
+/**
+ * Writes an IPv6 address, link-local addresses get the IID the MAC address implies.
+*/
+static void ipAddress(uint8_t *address, AddressKind_t kind, const IEEE802154_Adress_t *mac, uint8_t addressMode, uint8_t host)
+{
+  uint8_t i;
+
+  for (i = 0; i < 16; i++)
+  {
+    address[i] = 0;
+  }
+  switch (kind)
+  {
+  case ADDRESS_MAC:
+    address[0] = 0xFE;
+    address[1] = 0x80;
+    if (addressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT)
+    {
+      for (i = 0; i < sizeof(IEEE802154_ExtendedAddress_t); i++)
+      {
+        address[8 + i] = mac->extendedAdress[sizeof(IEEE802154_ExtendedAddress_t) - 1 - i];
+      }
+      address[8] ^= 0x02;
+    }
+    else
+    {
+      address[11] = 0xFF;
+      address[12] = 0xFE;
+      address[14] = HI_UINT16(mac->shortAddress);
+      address[15] = LO_UINT16(mac->shortAddress);
+    }
+    break;
+  case ADDRESS_GLOBAL:
+    for (i = 0; i < sizeof(globalPrefix); i++)
+    {
+      address[i] = globalPrefix[i];
+    }
+    address[15] = host;
+    address[13] = 0x5A;
+    break;
+  case ADDRESS_MULTICAST:
+    address[0] = 0xFF;
+    address[1] = 0x02;
+    address[15] = 0x01;
+    break;
+  }
+}
+
+/**
+ * Builds IPv6 packet of the given shape, returns its length.
+*/
+static uint16_t buildPacket(const Shape_t *shape, const IEEE802154_DataFrameHeader_t *header, uint16_t length)
+{
+  uint16_t payloadLength = length - IEEE802154_LOWPAN_IPV6_HEADER_SIZE;
+  uint16_t i;
+
+  packet[0] = 0x60;
+  packet[1] = (uint8_t)((shape->flowLabel >> 16) & 0x0F);
+  packet[2] = (uint8_t)(shape->flowLabel >> 8);
+  packet[3] = (uint8_t)shape->flowLabel;
+  packet[4] = HI_UINT16(payloadLength);
+  packet[5] = LO_UINT16(payloadLength);
+  packet[6] = shape->nextHeader;
+  packet[7] = shape->hopLimit;
+  ipAddress(&packet[8], shape->source, &header->sourceAddress, header->fcf.sourceAddressMode, 1);
+  ipAddress(&packet[24], shape->destination, &header->destinationAddress, header->fcf.destinationAddressMode, 2);
+  for (i = IEEE802154_LOWPAN_IPV6_HEADER_SIZE; i < length; i++)
+  {
+    packet[i] = (uint8_t)(i * 13);
+  }
+  packet[40] = HI_UINT16(shape->sourcePort);
+  packet[41] = LO_UINT16(shape->sourcePort);
+  packet[42] = HI_UINT16(shape->destinationPort);
+  packet[43] = LO_UINT16(shape->destinationPort);
+  if (shape->nextHeader == IEEE802154_LOWPAN_NEXT_HEADER_UDP)
+  {
+    packet[44] = HI_UINT16(payloadLength);
+    packet[45] = LO_UINT16(payloadLength);
+  }
+  return length;
+}
+
+static void benchCompression(uint8_t addressMode)
+{
+  IEEE802154_DataFrameHeader_t header;
+  uint8_t buffer[IEEE802154_LOWPAN_HEADER_MAX_SIZE];
+  uint8_t headerLength;
+  uint8_t compressedLength;
+  uint16_t length;
+  uint8_t i;
+
+  macHeader(&header, addressMode);
+  for (i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++)
+  {
+    length = buildPacket(&shapes[i], &header, IEEE802154_LOWPAN_IPV6_HEADER_SIZE + IEEE802154_LOWPAN_UDP_HEADER_SIZE + BENCH_UDP_PAYLOAD_LENGTH);
+    compressedLength = IEEE802154_lowpanCompress(&header, packet, length, buffer, &headerLength);
+    printf("%-8s %-28s %8u %11u %7.1fx\n", (addressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT) ? "extended" : "short",
+           shapes[i].name, headerLength, compressedLength, (double)headerLength / compressedLength);
+  }
+}
+
+static void benchReassembly(uint8_t addressMode)
+{
+  IEEE802154_DataFrameHeader_t header;
+  IEEE802154_DataFrameHeader_t received;
+  unsigned long round;
+  uint16_t bytes = 0;
+  uint8_t i;
+  uint8_t status;
+  double start;
+
+  macHeader(&header, addressMode);
+  buildPacket(&shapes[0], &header, IEEE802154_LOWPAN_MTU);
+  fragmentCount = 0;
+  IEEE802154_Sim_TxHook = captureFragment;
+  status = IEEE802154_lowpanSend(&header, packet, IEEE802154_LOWPAN_MTU);
+  IEEE802154_Sim_TxHook = NULL;
+  if (status != IEEE802154_TX_SUCCESS)
+  {
+    printf("reassembly: send failed with 0x%02X\n", status);
+    return;
+  }
+  for (i = 0; i < fragmentCount; i++)
+  {
+    bytes += fragmentLengths[i];
+  }
+
+  /* receiver parses the same MAC header out of the fragments */
+  received = header;
+  delivered = 0;
+  start = now();
+  for (round = 0; round < BENCH_PACKETS; round++)
+  {
+    for (i = 0; i < fragmentCount; i++)
+    {
+      IEEE802154_lowpanInput(&received, fragments[i], fragmentLengths[i], 0);
+    }
+  }
+  start = now() - start;
+  if (delivered != BENCH_PACKETS)
+  {
+    printf("reassembly: %lu of %lu packets delivered\n", delivered, BENCH_PACKETS);
+  }
+  printf("%-8s %6u %9u %9u %12.0f %10.1f\n", (addressMode == IEEE802154_FCF_ADDRESS_MODE_64BIT) ? "extended" : "short",
+         IEEE802154_LOWPAN_MTU, fragmentCount, bytes, start * 1e9 / BENCH_PACKETS,
+         (double)BENCH_PACKETS * IEEE802154_LOWPAN_MTU / start / 1e6);
+}
+
+int main(void)
+{
+  IEEE802154_Config_t config = { BENCH_CHANNEL, BENCH_OWN_ADDRESS, BENCH_PANID };
+
+  IEEE802154_Sim_reset();
+  IEEE802154_radioInit(&config);
+  IEEE802154_lowpanInit();
+
+  printf("bench_lowpan: IPv6 and UDP headers of %u byte UDP payload\n", BENCH_UDP_PAYLOAD_LENGTH);
+  printf("%-8s %-28s %8s %11s %8s\n", "MAC", "packet", "headers", "compressed", "ratio");
+  benchCompression(IEEE802154_FCF_ADDRESS_MODE_16BIT);
+  benchCompression(IEEE802154_FCF_ADDRESS_MODE_64BIT);
+
+  printf("bench_lowpan: reassembly, %lu packets per row\n", BENCH_PACKETS);
+  printf("%-8s %6s %9s %9s %12s %10s\n", "MAC", "packet", "fragments", "on air", "ns/packet", "MB/s");
+  benchReassembly(IEEE802154_FCF_ADDRESS_MODE_16BIT);
+  benchReassembly(IEEE802154_FCF_ADDRESS_MODE_64BIT);
+  return 0;
+}
@@ -0,0 +1,155 @@
+/**
+ * Cost of the RX and TX paths per frame, measured on the radio emulator.
+ * Frames with a short/short PAN ID compressed header and different payload lengths
+ * are received through IEEE802154_radioISR and sent with
+ * IEEE802154_radioSentDataFrame. Per frame it reports the FIFO accesses and strobes
+ * counted by the emulator (one MOVX each on the target), the cycles of RF ISR and
+ * blocking send taken from IEEE802154_statisticsSnapshot() and the host time.
+ * Built by host/Makefile with IEEE802154_ENABLE_STATISTICS.
+*/
+
+/*******************| Inclusions |*************************************/
+#define _POSIX_C_SOURCE 199309L     /* clock_gettime */
+#include "IEEE_802.15.4.h"
+#include "IEEE_802.15.4_Radio.h"
+#include <stdio.h>
+#include <time.h>
+
+/*******************| Macros |*****************************************/
+#define BENCH_FRAMES                            200000UL
+#define BENCH_CHANNEL                           15
+#define BENCH_PANID                             0xABCD
+#define BENCH_OWN_ADDRESS                       0x1234
+#define BENCH_PEER_ADDRESS                      0x5678
+#define BENCH_HEADER_LENGTH                     9       /**< FCF, sequence number, PAN ID, two short addresses */
+
+/*******************| Global variables |*******************************/
+IEEE802154_DataFrameHeader_t IEEE802154_TxDataFrame;
+IEEE802154_DataFrameHeader_t IEEE802154_RxDataFrame;
+
+static uint8_t rxPayload[IEEE802154_MAX_PHY_PACKET_SIZE];
+static uint8_t txPayload[IEEE802154_MAX_PHY_PACKET_SIZE];
+static unsigned long received;
+
+static const uint8_t payloadLengths[] = { 0, 16, 64, 100 };
+
+/*******************| Function definition |****************************/
+void IEEE802154_UserCbk_BeaconFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_DataFrameReceived(uint8_t payloadLength, sint8_t rssi) { received++; }
+void IEEE802154_UserCbk_AckFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_MACCommandFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_CRCError(uint8_t payloadLength, sint8_t rssi) {}
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void report(const char *path, uint8_t payloadLength, const IEEE802154_Sim_Counters_t *counters,
+                   const IEEE802154_CycleStatistics_t *cycles, double seconds)
+{
+  printf("%-3s %4u %10.1f %10.1f %8.1f %10.1f %8lu %10.1f %10.0f\n", path, payloadLength,
+         (double)counters->rxFifoReads / BENCH_FRAMES, (double)counters->txFifoWrites / BENCH_FRAMES,
+         (double)counters->strobes / BENCH_FRAMES,
+         cycles->count ? (double)cycles->total / cycles->count : 0.0, (unsigned long)cycles->max,
+         seconds * 1e9 / BENCH_FRAMES, BENCH_FRAMES / seconds);
+}
+
+static void benchReceive(uint8_t payloadLength)
+{
+  uint8_t frame[IEEE802154_MAX_PHY_PACKET_SIZE];
+  IEEE802154_Statistics_t statistics;
+  unsigned long i;
+  uint8_t n;
+  double start;
+
+  frame[0] = 0x41;                      /* data frame, PAN ID compression */
+  frame[1] = 0x88;                      /* short destination and source address */
+  frame[3] = LO_UINT16(BENCH_PANID);
+  frame[4] = HI_UINT16(BENCH_PANID);
+  frame[5] = LO_UINT16(BENCH_OWN_ADDRESS);
+  frame[6] = HI_UINT16(BENCH_OWN_ADDRESS);
+  frame[7] = LO_UINT16(BENCH_PEER_ADDRESS);
+  frame[8] = HI_UINT16(BENCH_PEER_ADDRESS);
+  for (n = 0; n < payloadLength; n++)
+  {
+    frame[BENCH_HEADER_LENGTH + n] = n;
+  }
+
+  IEEE802154_Sim_Counters = (IEEE802154_Sim_Counters_t){ 0 };
+  IEEE802154_statisticsReset();
+  received = 0;
+  start = now();
+  for (i = 0; i < BENCH_FRAMES; i++)
+  {
+    frame[2] = (uint8_t)i;
+    IEEE802154_Sim_pushRxFrame(frame, BENCH_HEADER_LENGTH + payloadLength, -40, 0x80 | 100);
+    IEEE802154_Sim_fireRadioInterrupt();
+    IEEE802154_Sim_fireDmaInterrupt();
+  }
+  start = now() - start;
+  IEEE802154_statisticsSnapshot(&statistics);
+  if (received != BENCH_FRAMES)
+  {
+    printf("RX %u: %lu of %lu frames delivered\n", payloadLength, received, BENCH_FRAMES);
+  }
+  report("RX", payloadLength, &IEEE802154_Sim_Counters, &statistics.isrCycles, start);
+}
+
+static void benchTransmit(uint8_t payloadLength)
+{
+  IEEE802154_Statistics_t statistics;
+  unsigned long i;
+  double start;
+
+  IEEE802154_TxDataFrame.fcf.frameType = IEEE802154_FCF_FRAME_TYPE_DATA;
+  IEEE802154_TxDataFrame.fcf.panIdCompression = IEEE802154_FCF_PANIDCOMPRESSION_ENABLED;
+  IEEE802154_TxDataFrame.fcf.destinationAddressMode = IEEE802154_FCF_ADDRESS_MODE_16BIT;
+  IEEE802154_TxDataFrame.fcf.sourceAddressMode = IEEE802154_FCF_ADDRESS_MODE_16BIT;
+  IEEE802154_TxDataFrame.destinationPANID = BENCH_PANID;
+  IEEE802154_TxDataFrame.destinationAddress.shortAddress = BENCH_PEER_ADDRESS;
+  IEEE802154_TxDataFrame.sourceAddress.shortAddress = BENCH_OWN_ADDRESS;
+  IEEE802154_TxDataFrame.payload = txPayload;
+
+  IEEE802154_Sim_Counters = (IEEE802154_Sim_Counters_t){ 0 };
+  IEEE802154_statisticsReset();
+  start = now();
+  for (i = 0; i < BENCH_FRAMES; i++)
+  {
+    IEEE802154_TxDataFrame.sequenceNumber = (uint8_t)i;
+    IEEE802154_radioSentDataFrame(&IEEE802154_TxDataFrame, payloadLength);
+  }
+  start = now() - start;
+  IEEE802154_statisticsSnapshot(&statistics);
+  if (IEEE802154_Sim_Counters.framesSent != BENCH_FRAMES)
+  {
+    printf("TX %u: %lu of %lu frames sent\n", payloadLength, (unsigned long)IEEE802154_Sim_Counters.framesSent, BENCH_FRAMES);
+  }
+  report("TX", payloadLength, &IEEE802154_Sim_Counters, &statistics.txCycles, start);
+}
+
+int main(void)
+{
+  IEEE802154_Config_t config = { BENCH_CHANNEL, BENCH_OWN_ADDRESS, BENCH_PANID };
+  uint8_t i;
+
+  IEEE802154_Sim_reset();
+  IEEE802154_radioInit(&config);
+  IEEE802154_RxDataFrame.payload = rxPayload;
+
+  printf("bench_radio: %lu frames per row, %u byte MAC header\n", BENCH_FRAMES, BENCH_HEADER_LENGTH);
+  printf("%-3s %4s %10s %10s %8s %10s %8s %10s %10s\n", "", "len", "fifo rd", "fifo wr", "strobes",
+         "cycles", "max", "ns/frame", "frames/s");
+  for (i = 0; i < sizeof(payloadLengths); i++)
+  {
+    benchReceive(payloadLengths[i]);
+  }
+  for (i = 0; i < sizeof(payloadLengths); i++)
+  {
+    benchTransmit(payloadLengths[i]);
+  }
+  return 0;
+}
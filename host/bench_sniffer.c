@@ -0,0 +1,129 @@
+/**
+ * Sniffer under saturated traffic, measured on the radio emulator. BENCH_FRAMES frames
+ * of one length are received back to back at 250 kbit/s through IEEE802154_radioISR,
+ * which stores them with IEEE802154_snifferDrain. The application side is modelled by
+ * IEEE802154_Sim_snifferWrite, called once per read interval of simulated time, the
+ * pcap records are converted but not written to a file. Per row it reports the frames
+ * captured, the frames lost because the sniffer buffer was full (IEEE802154_SnifferDropped)
+ * or RXFIFO overflowed and the host time.
+ * Built by host/Makefile with IEEE802154_ENABLE_SNIFFER.
+*/
+
+/*******************| Inclusions |*************************************/
+#define _POSIX_C_SOURCE 199309L     /* clock_gettime */
+#include "IEEE_802.15.4.h"
+#include "IEEE_802.15.4_Radio.h"
+#include <stdio.h>
+#include <time.h>
+
+/*******************| Macros |*****************************************/
+#define BENCH_FRAMES                            20000UL
+#define BENCH_CHANNEL                           15
+#define BENCH_PANID                             0xABCD
+#define BENCH_OWN_ADDRESS                       0x1234
+#define BENCH_PEER_ADDRESS                      0x5678
+#define BENCH_HEADER_LENGTH                     9       /**< FCF, sequence number, PAN ID, two short addresses */
+#define BENCH_BYTES_PER_PERIOD                  10      /**< 250 kbit/s during one backoff period of 320us */
+
+/*******************| Global variables |*******************************/
+IEEE802154_DataFrameHeader_t IEEE802154_TxDataFrame;
+IEEE802154_DataFrameHeader_t IEEE802154_RxDataFrame;
+
+static uint8_t rxPayload[IEEE802154_MAX_PHY_PACKET_SIZE];
+
+static const uint8_t payloadLengths[] = { 0, 16, 64, 116 };
+static const uint16_t readIntervals[] = { 1, 31, 78, 156 };    /**< backoff periods, 0.32, 10, 25 and 50 ms */
+
+/*******************| Function definition |****************************/
+void IEEE802154_UserCbk_BeaconFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_DataFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_AckFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_MACCommandFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_CRCError(uint8_t payloadLength, sint8_t rssi) {}
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void benchSniffer(uint8_t payloadLength, uint16_t readInterval)
+{
+  uint8_t frame[IEEE802154_MAX_PHY_PACKET_SIZE];
+  unsigned long captured = 0;
+  unsigned long i;
+  uint32_t lastRead;
+  uint16_t airBytes = 0;
+  uint8_t n;
+  double start;
+
+  frame[0] = 0x41;                      /* data frame, PAN ID compression */
+  frame[1] = 0x88;                      /* short destination and source address */
+  frame[3] = LO_UINT16(BENCH_PANID);
+  frame[4] = HI_UINT16(BENCH_PANID);
+  frame[5] = LO_UINT16(BENCH_OWN_ADDRESS);
+  frame[6] = HI_UINT16(BENCH_OWN_ADDRESS);
+  frame[7] = LO_UINT16(BENCH_PEER_ADDRESS);
+  frame[8] = HI_UINT16(BENCH_PEER_ADDRESS);
+  for (n = 0; n < payloadLength; n++)
+  {
+    frame[BENCH_HEADER_LENGTH + n] = n;
+  }
+
+  IEEE802154_Sim_Counters = (IEEE802154_Sim_Counters_t){ 0 };
+  IEEE802154_snifferStart();
+  lastRead = IEEE802154_Sim_Time;
+  start = now();
+  for (i = 0; i < BENCH_FRAMES; i++)
+  {
+    frame[2] = (uint8_t)i;
+    IEEE802154_Sim_pushRxFrame(frame, BENCH_HEADER_LENGTH + payloadLength, -40, 0x80 | 100);
+    IEEE802154_Sim_fireRadioInterrupt();
+    /* next frame follows once this one is on air, no gap */
+    airBytes += IEEE802154_SIM_PHY_OVERHEAD + BENCH_HEADER_LENGTH + payloadLength + IEEE802154_CRCLENGTH;
+    IEEE802154_Sim_advanceTime(airBytes / BENCH_BYTES_PER_PERIOD);
+    airBytes %= BENCH_BYTES_PER_PERIOD;
+    if ((uint32_t)(IEEE802154_Sim_Time - lastRead) >= readInterval)
+    {
+      captured += IEEE802154_Sim_snifferWrite();
+      lastRead = IEEE802154_Sim_Time;
+    }
+  }
+  captured += IEEE802154_Sim_snifferWrite();
+  start = now() - start;
+  IEEE802154_snifferStop();
+  if (captured + IEEE802154_SnifferDropped + IEEE802154_Sim_Counters.rxOverflows != BENCH_FRAMES)
+  {
+    printf("%u/%u: %lu of %lu frames accounted for\n", payloadLength, readInterval,
+           captured + IEEE802154_SnifferDropped + IEEE802154_Sim_Counters.rxOverflows, BENCH_FRAMES);
+  }
+  printf("%4u %8.2f %8lu %8lu %8lu %10.1f %10.0f\n", BENCH_HEADER_LENGTH + payloadLength,
+         readInterval * 0.32, captured, (unsigned long)IEEE802154_SnifferDropped,
+         (unsigned long)IEEE802154_Sim_Counters.rxOverflows, start * 1e9 / BENCH_FRAMES, BENCH_FRAMES / start);
+}
+
+int main(void)
+{
+  IEEE802154_Config_t config = { BENCH_CHANNEL, BENCH_OWN_ADDRESS, BENCH_PANID };
+  uint8_t i;
+  uint8_t j;
+
+  IEEE802154_Sim_reset();
+  IEEE802154_radioInit(&config);
+  IEEE802154_RxDataFrame.payload = rxPayload;
+
+  printf("bench_sniffer: %lu frames per row at 250 kbit/s, %u byte sniffer buffer\n", BENCH_FRAMES,
+         IEEE802154_SNIFFER_BUFFER_SIZE);
+  printf("%4s %8s %8s %8s %8s %10s %10s\n", "len", "read ms", "captured", "dropped", "overflow",
+         "ns/frame", "frames/s");
+  for (i = 0; i < sizeof(payloadLengths); i++)
+  {
+    for (j = 0; j < sizeof(readIntervals) / sizeof(readIntervals[0]); j++)
+    {
+      benchSniffer(payloadLengths[i], readIntervals[j]);
+    }
+  }
+  return 0;
+}
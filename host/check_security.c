@@ -0,0 +1,339 @@
+/**
+ * MAC security checked against the secured frames of 802.15.4-2006 Annex C.2 and
+ * latency of securing and unsecuring a frame.
+ * The beacon (C.2.1, MIC-64), data (C.2.2, ENC) and MAC command (C.2.3, ENC-MIC-64)
+ * frames are sent with IEEE802154_radioSentDataFrame() and compared byte by byte with
+ * the standard, then received through IEEE802154_radioISR() and compared with the
+ * plaintext payload. CCM* itself is checked with packet vector #1 of RFC 3610.
+ * Latency is measured per security level for sending and receiving frames with short
+ * addresses on the radio emulator, including FIFO accesses.
+ * Built by host/Makefile with IEEE802154_ENABLE_SECURITY.
+*/
+
+/*******************| Inclusions |*************************************/
+#define _POSIX_C_SOURCE 199309L     /* clock_gettime */
+#include "IEEE_802.15.4.h"
+#include "IEEE_802.15.4_Radio.h"
+#include <stdio.h>
+#include <time.h>
+
+/*******************| Macros |*****************************************/
+#define CHECK_FRAMES                            20000U
+#define CHECK_CHANNEL                           15
+#define CHECK_PANID                             0x4321
+#define CHECK_OWN_ADDRESS                       0x1234
+#define CHECK_PEER_ADDRESS                      0x5678
+#define CHECK_FRAME_COUNTER                     5
+
+/*******************| Type definitions |*******************************/
+typedef struct {
+  const char *name;
+  uint8_t fcf0;
+  uint8_t fcf1;
+  uint8_t securityLevel;
+  IEEE802154_PANIdentifier_t sourcePANID;
+  const uint8_t *payload;
+  uint8_t payloadLength;
+  const uint8_t *frame;                 /**< secured frame without FCS */
+  uint8_t frameLength;
+} Vector_t;
+
+/*******************| Global variables |*******************************/
+IEEE802154_DataFrameHeader_t IEEE802154_TxDataFrame;
+IEEE802154_DataFrameHeader_t IEEE802154_RxDataFrame;
+
+/* key and addresses of all Annex C.2 examples, extended addresses in transmitted order */
+static const uint8_t key[16] =
+{
+  0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF
+};
+static const IEEE802154_ExtendedAddress_t sourceAddress = { 0x01, 0x00, 0x00, 0x00, 0x00, 0x48, 0xDE, 0xAC };
+static const IEEE802154_ExtendedAddress_t destinationAddress = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x48, 0xDE, 0xAC };
+
+static const uint8_t beaconPayload[] = { 0x55, 0xCF, 0x00, 0x00, 0x51, 0x52, 0x53, 0x54 };
+static const uint8_t beaconFrame[] =
+{
+  0x08, 0xD0, 0x84, 0x21, 0x43, 0x01, 0x00, 0x00, 0x00, 0x00, 0x48, 0xDE, 0xAC,
+  0x02, 0x05, 0x00, 0x00, 0x00,
+  0x55, 0xCF, 0x00, 0x00, 0x51, 0x52, 0x53, 0x54,
+  0x22, 0x3B, 0xC1, 0xEC, 0x84, 0x1A, 0xB5, 0x53
+};
+static const uint8_t dataPayload[] = { 0x61, 0x62, 0x63, 0x64 };
+static const uint8_t dataFrame[] =
+{
+  0x69, 0xDC, 0x84, 0x21, 0x43, 0x02, 0x00, 0x00, 0x00, 0x00, 0x48, 0xDE, 0xAC,
+  0x01, 0x00, 0x00, 0x00, 0x00, 0x48, 0xDE, 0xAC,
+  0x04, 0x05, 0x00, 0x00, 0x00,
+  0xD4, 0x3E, 0x02, 0x2B
+};
+static const uint8_t commandPayload[] = { 0x01, 0xCE };
+static const uint8_t commandFrame[] =
+{
+  0x2B, 0xDC, 0x84, 0x21, 0x43, 0x02, 0x00, 0x00, 0x00, 0x00, 0x48, 0xDE, 0xAC,
+  0xFF, 0xFF, 0x01, 0x00, 0x00, 0x00, 0x00, 0x48, 0xDE, 0xAC,
+  0x06, 0x05, 0x00, 0x00, 0x00,
+  0x01, 0xD8,
+  0x4F, 0xDE, 0x52, 0x90, 0x61, 0xF9, 0xC6, 0xF1
+};
+
+static const Vector_t vectors[] =
+{
+  { "C.2.1 beacon MIC-64",      0x08, 0xD0, 2, 0x4321, beaconPayload,  sizeof(beaconPayload),  beaconFrame,  sizeof(beaconFrame) },
+  { "C.2.2 data ENC",           0x69, 0xDC, 4, 0x0000, dataPayload,    sizeof(dataPayload),    dataFrame,    sizeof(dataFrame) },
+  { "C.2.3 command ENC-MIC-64", 0x2B, 0xDC, 6, 0xFFFF, commandPayload, sizeof(commandPayload), commandFrame, sizeof(commandFrame) },
+};
+
+/* RFC 3610 packet vector #1 */
+static const uint8_t rfcNonce[IEEE802154_CCM_NONCE_SIZE] =
+{
+  0x00, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5
+};
+static const uint8_t rfcCiphertext[] =
+{
+  0x58, 0x8C, 0x97, 0x9A, 0x61, 0xC6, 0x63, 0xD2, 0xF0, 0x66, 0xD0, 0xC2, 0xC0, 0xF9, 0x89, 0x80,
+  0x6D, 0x5F, 0x6B, 0x61, 0xDA, 0xC3, 0x84
+};
+static const uint8_t rfcMic[] = { 0x17, 0xE8, 0xD1, 0x2C, 0xFD, 0xF9, 0x26, 0xE0 };
+
+static const uint8_t latencyLevels[] = { 0, 4, 6, 7 };
+static const uint8_t latencyPayloadLengths[] = { 16, 48, 90 };
+
+static uint8_t rxPayload[IEEE802154_MAX_PHY_PACKET_SIZE];
+static uint8_t txPayload[IEEE802154_MAX_PHY_PACKET_SIZE];
+static uint8_t frames[CHECK_FRAMES][IEEE802154_MAX_PHY_PACKET_SIZE];
+static uint8_t frameLengths[CHECK_FRAMES];
+static sint16_t received;               /**< payload length of last frame received, -1 if none */
+
+/*******************| Function definition |****************************/
+void IEEE802154_UserCbk_BeaconFrameReceived(uint8_t payloadLength, sint8_t rssi) { received = payloadLength; }
+void IEEE802154_UserCbk_DataFrameReceived(uint8_t payloadLength, sint8_t rssi) { received = payloadLength; }
+void IEEE802154_UserCbk_AckFrameReceived(uint8_t payloadLength, sint8_t rssi) {}
+void IEEE802154_UserCbk_MACCommandFrameReceived(uint8_t payloadLength, sint8_t rssi) { received = payloadLength; }
+void IEEE802154_UserCbk_CRCError(uint8_t payloadLength, sint8_t rssi) {}
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint8_t equal(const uint8_t *a, const uint8_t *b, uint8_t length)
+{
+  uint8_t i;
+
+  for (i = 0; i < length; i++)
+  {
+    if (a[i] != b[i])
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void dump(const char *name, const uint8_t *data, uint8_t length)
+{
+  uint8_t i;
+
+  printf("  %-8s", name);
+  for (i = 0; i < length; i++)
+  {
+    printf(" %02X", data[i]);
+  }
+  printf("\n");
+}
+
+static void receive(const uint8_t *frame, uint8_t length)
+{
+  received = -1;
+  IEEE802154_Sim_pushRxFrame(frame, length, -40, IEEE802154_CRCOK_MASK | 100);
+  IEEE802154_Sim_fireRadioInterrupt();
+  IEEE802154_Sim_fireDmaInterrupt();
+}
+
+static int checkCcm(void)
+{
+  uint8_t a[8];
+  uint8_t m[sizeof(rfcCiphertext)];
+  uint8_t mic[sizeof(rfcMic)];
+  uint8_t i;
+
+  for (i = 0; i < sizeof(a); i++)
+  {
+    a[i] = i;
+  }
+  for (i = 0; i < sizeof(m); i++)
+  {
+    m[i] = (uint8_t)(sizeof(a) + i);
+  }
+  IEEE802154_ccmStar(rfcNonce, a, sizeof(a), m, sizeof(m), mic, sizeof(mic), 0);
+  if (!equal(m, rfcCiphertext, sizeof(m)) || !equal(mic, rfcMic, sizeof(mic)))
+  {
+    printf("FAIL RFC 3610 #1 encryption\n");
+    return 1;
+  }
+  if (!IEEE802154_ccmStar(rfcNonce, a, sizeof(a), m, sizeof(m), mic, sizeof(mic), 1) || (m[0] != sizeof(a)))
+  {
+    printf("FAIL RFC 3610 #1 decryption\n");
+    return 1;
+  }
+  printf("ok   RFC 3610 #1 CCM\n");
+  return 0;
+}
+
+static int checkVector(const Vector_t *vector)
+{
+  IEEE802154_DataFrameHeader_t *header = &IEEE802154_TxDataFrame;
+  uint8_t *fcf = (uint8_t*)&header->fcf;
+  uint8_t frame[IEEE802154_MAX_PHY_PACKET_SIZE];
+  uint8_t length;
+  uint8_t i;
+
+  *header = (IEEE802154_DataFrameHeader_t){ 0 };
+  fcf[0] = vector->fcf0;
+  fcf[1] = vector->fcf1;
+  header->sequenceNumber = 0x84;
+  header->destinationPANID = CHECK_PANID;
+  header->sourcePANID = vector->sourcePANID;
+  for (i = 0; i < sizeof(IEEE802154_ExtendedAddress_t); i++)
+  {
+    header->destinationAddress.extendedAdress[i] = destinationAddress[i];
+    header->sourceAddress.extendedAdress[i] = sourceAddress[i];
+  }
+  header->auxSecurityHeader.securityControl = IEEE802154_SECURITY_CONTROL(vector->securityLevel, 0);
+  for (i = 0; i < vector->payloadLength; i++)
+  {
+    txPayload[i] = vector->payload[i];
+  }
+  header->payload = txPayload;
+
+  IEEE802154_SecurityFrameCounter = CHECK_FRAME_COUNTER;
+  IEEE802154_radioSentDataFrame(header, vector->payloadLength);
+  length = IEEE802154_Sim_getTxFrame(frame);
+  if ((length != vector->frameLength) || !equal(frame, vector->frame, length))
+  {
+    printf("FAIL %s sent\n", vector->name);
+    dump("sent", frame, length);
+    dump("expected", vector->frame, vector->frameLength);
+    return 1;
+  }
+
+  /* receive the frame of the standard, device table entry starts with the frame counter of the example */
+  IEEE802154_securityInit();
+  IEEE802154_securityDeviceAdd(sourceAddress, 0xFFFE);
+  receive(vector->frame, vector->frameLength);
+  if ((received != vector->payloadLength) || !equal(rxPayload, vector->payload, vector->payloadLength))
+  {
+    printf("FAIL %s received\n", vector->name);
+    return 1;
+  }
+  receive(vector->frame, vector->frameLength);
+  if (received != -1)
+  {
+    printf("FAIL %s replay accepted\n", vector->name);
+    return 1;
+  }
+  printf("ok   %s\n", vector->name);
+  return 0;
+}
+
+/**
+ * Sends CHECK_FRAMES frames, keeping them for the receive run, then receives them.
+*/
+static int latency(uint8_t level, uint8_t payloadLength)
+{
+  IEEE802154_DataFrameHeader_t *header = &IEEE802154_TxDataFrame;
+  double transmit;
+  double receive;
+  unsigned int i;
+
+  *header = (IEEE802154_DataFrameHeader_t){ 0 };
+  header->fcf.frameType = IEEE802154_FCF_FRAME_TYPE_DATA;
+  header->fcf.panIdCompression = IEEE802154_FCF_PANIDCOMPRESSION_ENABLED;
+  header->fcf.destinationAddressMode = IEEE802154_FCF_ADDRESS_MODE_16BIT;
+  header->fcf.sourceAddressMode = IEEE802154_FCF_ADDRESS_MODE_16BIT;
+  header->fcf.securityEnabled = (level != 0);
+  header->fcf.frameVersion = 1;
+  header->destinationPANID = CHECK_PANID;
+  header->destinationAddress.shortAddress = CHECK_OWN_ADDRESS;
+  header->sourceAddress.shortAddress = CHECK_PEER_ADDRESS;
+  header->auxSecurityHeader.securityControl = IEEE802154_SECURITY_CONTROL(level, 0);
+  header->payload = txPayload;
+
+  transmit = now();
+  for (i = 0; i < CHECK_FRAMES; i++)
+  {
+    header->sequenceNumber = (uint8_t)i;
+    IEEE802154_radioSentDataFrame(header, payloadLength);
+    frameLengths[i] = IEEE802154_Sim_getTxFrame(frames[i]);
+  }
+  transmit = now() - transmit;
+
+  IEEE802154_securityInit();
+  IEEE802154_securityDeviceAdd(sourceAddress, CHECK_PEER_ADDRESS);
+  receive = now();
+  for (i = 0; i < CHECK_FRAMES; i++)
+  {
+    IEEE802154_Sim_pushRxFrame(frames[i], frameLengths[i], -40, IEEE802154_CRCOK_MASK | 100);
+    IEEE802154_Sim_fireRadioInterrupt();
+    IEEE802154_Sim_fireDmaInterrupt();
+  }
+  receive = now() - receive;
+  if ((received != payloadLength) || !equal(rxPayload, txPayload, payloadLength))
+  {
+    printf("FAIL level %u, %u bytes: frames not received\n", level, payloadLength);
+    return 1;
+  }
+  printf("%5u %6u %6u %12.0f %12.0f\n", level, payloadLength, frameLengths[0],
+         transmit * 1e9 / CHECK_FRAMES, receive * 1e9 / CHECK_FRAMES);
+  return 0;
+}
+
+int main(void)
+{
+  IEEE802154_Config_t config = { CHECK_CHANNEL, CHECK_OWN_ADDRESS, CHECK_PANID };
+  int failed = 0;
+  uint8_t i;
+  uint8_t j;
+
+  IEEE802154_Sim_reset();
+  IEEE802154_radioInit(&config);
+  IEEE802154_RxDataFrame.payload = rxPayload;
+  IEEE802154_securitySetKey(key);
+  /* own extended address is the source of the examples, register holds it in transmitted order */
+  EXT_ADDR0 = sourceAddress[0];
+  EXT_ADDR1 = sourceAddress[1];
+  EXT_ADDR2 = sourceAddress[2];
+  EXT_ADDR3 = sourceAddress[3];
+  EXT_ADDR4 = sourceAddress[4];
+  EXT_ADDR5 = sourceAddress[5];
+  EXT_ADDR6 = sourceAddress[6];
+  EXT_ADDR7 = sourceAddress[7];
+
+  failed += checkCcm();
+  for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++)
+  {
+    failed += checkVector(&vectors[i]);
+  }
+  if (failed)
+  {
+    return 1;
+  }
+
+  for (i = 0; i < sizeof(txPayload); i++)
+  {
+    txPayload[i] = (uint8_t)(i * 3);
+  }
+  printf("check_security: latency per frame, %u frames per row\n", CHECK_FRAMES);
+  printf("%5s %6s %6s %12s %12s\n", "level", "length", "frame", "send ns", "receive ns");
+  for (i = 0; i < sizeof(latencyLevels); i++)
+  {
+    for (j = 0; j < sizeof(latencyPayloadLengths); j++)
+    {
+      failed += latency(latencyLevels[i], latencyPayloadLengths[j]);
+    }
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * Runs a network simulation of IEEE_802.15.4_NetSim.c and prints the report per node
+ * and for the network, the wall clock time of the run goes to stderr.
+ *   netsim [nodes [duration [trafficInterval [toSink [area [lossPercent [workers]]]]]]]
+ * Arguments not given keep the values of IEEE802154_NetSim_defaultConfig(), duration and
+ * trafficInterval are in backoff periods of 320us, workers 0 uses one per online CPU.
+ * Built by host/Makefile with IEEE802154_ENABLE_NETSIM, IEEE802154_ENABLE_TX_QUEUE and
+ * IEEE802154_ENABLE_CSMA.
+*/
+
+/*******************| Inclusions |*************************************/
+#define _POSIX_C_SOURCE 199309L     /* clock_gettime */
+#include "IEEE_802.15.4.h"
+#include "IEEE_802.15.4_Radio.h"
+#include "IEEE_802.15.4_NetSim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*******************| Macros |*****************************************/
+#define NETSIM_ARGUMENTS                        7
+
+/*******************| Function definition |****************************/
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+  static const unsigned long maximum[NETSIM_ARGUMENTS] = { IEEE802154_NETSIM_MAX_NODES, 0xFFFFFFFEUL, 0x7FFFFFFFUL, 1, 0xFFFF, 100, 0xFFFF };
+  IEEE802154_NetSim_Config_t config;
+  IEEE802154_NetSim_Report_t *reports;
+  unsigned long value[NETSIM_ARGUMENTS];
+  char *end;
+  double start;
+  int i;
+
+  IEEE802154_NetSim_defaultConfig(&config);
+  value[0] = config.nodes;
+  value[1] = config.duration;
+  value[2] = config.trafficInterval;
+  value[3] = config.toSink;
+  value[4] = config.area;
+  value[5] = config.lossPercent;
+  value[6] = config.workers;
+  for (i = 1; i < argc; i++)
+  {
+    if (i <= NETSIM_ARGUMENTS)
+    {
+      value[i - 1] = strtoul(argv[i], &end, 0);
+    }
+    if ((i > NETSIM_ARGUMENTS) || (*argv[i] == '\0') || (*end != '\0') || (value[i - 1] > maximum[i - 1]))
+    {
+      fprintf(stderr, "usage: netsim [nodes [duration [trafficInterval [toSink [area [lossPercent [workers]]]]]]]\n");
+      return 1;
+    }
+  }
+  config.nodes = (uint16_t)value[0];
+  config.duration = (uint32_t)value[1];
+  config.trafficInterval = (uint32_t)value[2];
+  config.toSink = (uint8_t)value[3];
+  config.area = (uint16_t)value[4];
+  config.lossPercent = (uint8_t)value[5];
+  config.workers = (uint16_t)value[6];
+
+  reports = calloc(config.nodes ? config.nodes : 1, sizeof(IEEE802154_NetSim_Report_t));
+  if (reports == NULL)
+  {
+    return 1;
+  }
+  start = now();
+  if (!IEEE802154_NetSim_run(&config, reports))
+  {
+    fprintf(stderr, "netsim: run failed, check the configuration\n");
+    free(reports);
+    return 1;
+  }
+  fprintf(stderr, "netsim: %u nodes, %lu periods in %.2f s\n", (unsigned)config.nodes,
+          (unsigned long)config.duration, now() - start);
+  IEEE802154_NetSim_printReport(stdout, &config, reports);
+  free(reports);
+  return 0;
+}
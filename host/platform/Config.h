@@ -0,0 +1,9 @@
+#ifndef CONFIG_H_
+#define CONFIG_H_
+
+/**
+ * Configuration of host builds, see host/Makefile. IEEE802154_SIMULATION and the
+ * IEEE802154_ENABLE_* options of a program are given on the compiler command line.
+*/
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef PLATFORMTYPES_H_
+#define PLATFORMTYPES_H_
+
+/**
+ * Platform types of host builds, see host/Makefile. The target build takes this file
+ * from the platform package of the CC2530.
+*/
+
+#include <stdint.h>
+
+typedef int8_t sint8_t;
+typedef int16_t sint16_t;
+typedef int32_t sint32_t;
+
+#endif